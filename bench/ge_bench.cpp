@@ -0,0 +1,319 @@
+// Headless benchmark: renders the main scene offscreen along a scripted camera path and writes
+// per-frame CPU/GPU times, so performance can be compared between builds without anyone at the keyboard.
+//
+//   ge_bench [--frames N] [--warmup N] [--width W] [--height H] [--cubes N] [--props N] [--lights N]
+//            [--path orbit|flyover] [--csv file] [--json file]
+//
+// Uses a hidden GLFW window and renders into its own framebuffer object. On a machine without a
+// display run it under a virtual X server, e.g. `xvfb-run ./ge_bench`, which works with Mesa llvmpipe.
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Camera.h"
+#include "Culling.h"
+#include "GLExtensions.h"
+#include "InstancedRenderer.h"
+#include "JobSystem.h"
+#include "ProgramCache.h"
+#include "Scene.h"
+
+#ifndef GE_SHADER_DIR
+#define GE_SHADER_DIR "../../src/shaders/"
+#endif
+
+struct BenchOptions
+{
+    int Frames = 600;
+    int Warmup = 60;
+    int Width = 1280;
+    int Height = 720;
+    int Cubes = 20000;
+    int Props = 2000;
+    int Lights = 4096;
+    std::string Path = "orbit";
+    std::string Csv = "ge_bench.csv";
+    std::string Json = "ge_bench.json";
+};
+
+struct FrameSample
+{
+    double CpuMs;
+    double GpuMs;
+    unsigned int DrawCalls;
+    unsigned int Visible;
+    unsigned int TerrainTriangles;
+};
+
+static std::string readShader(const std::string& name)
+{
+    std::ifstream file(std::string(GE_SHADER_DIR) + name);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open shader file: " << GE_SHADER_DIR << name << std::endl;
+        return "";
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    return buffer.str();
+}
+
+static bool parseOptions(int argc, char** argv, BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return false;
+        }
+        const char* value = argv[++i];
+        if (arg == "--frames") options.Frames = std::max(1, atoi(value));
+        else if (arg == "--warmup") options.Warmup = std::max(0, atoi(value));
+        else if (arg == "--width") options.Width = std::max(1, atoi(value));
+        else if (arg == "--height") options.Height = std::max(1, atoi(value));
+        else if (arg == "--cubes") options.Cubes = std::max(0, atoi(value));
+        else if (arg == "--props") options.Props = std::max(0, atoi(value));
+        else if (arg == "--lights") options.Lights = std::max(0, atoi(value));
+        else if (arg == "--path") options.Path = value;
+        else if (arg == "--csv") options.Csv = value;
+        else if (arg == "--json") options.Json = value;
+        else
+        {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.Path != "orbit" && options.Path != "flyover")
+    {
+        std::cerr << "Unknown camera path " << options.Path << " (orbit, flyover)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Places the camera for time t (seconds). Paths only depend on t, so every run sees the same frames.
+static void placeCamera(Camera& camera, const Terrain& terrain, const std::string& path, float t)
+{
+    glm::vec3 target;
+    if (path == "orbit")
+    {
+        // circles the stress cubes while slowly bobbing up and down
+        float angle = t * 0.35f;
+        camera.Position = glm::vec3(std::cos(angle) * 40.0f, 10.0f + 6.0f * std::sin(t * 0.5f), std::sin(angle) * 40.0f);
+        target = glm::vec3(0.0f, 0.0f, 0.0f);
+    }
+    else
+    {
+        // flies away from the origin over the terrain, looking ahead and slightly down
+        glm::vec3 direction = glm::normalize(glm::vec3(1.0f, 0.0f, 0.6f));
+        glm::vec3 ground = direction * (t * 25.0f);
+        float height = terrain.GetHeight(ground.x, ground.z) + 25.0f;
+        camera.Position = glm::vec3(ground.x, height, ground.z);
+        target = camera.Position + direction * 60.0f - glm::vec3(0.0f, 20.0f, 0.0f);
+    }
+
+    glm::vec3 front = glm::normalize(target - camera.Position);
+    camera.Yaw = glm::degrees(std::atan2(front.z, front.x));
+    camera.Pitch = glm::degrees(std::asin(front.y));
+    camera.updateCameraVectors();
+}
+
+static double percentile(std::vector<double> values, double percent)
+{
+    if (values.empty())
+        return 0.0;
+    size_t rank = (size_t)(percent / 100.0 * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+}
+
+static double mean(const std::vector<double>& values)
+{
+    double sum = 0.0;
+    for (double value : values)
+        sum += value;
+    return values.empty() ? 0.0 : sum / values.size();
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options))
+        return 1;
+
+    if (!glfwInit())
+    {
+        std::cerr << "Failed to initialize GLFW" << std::endl;
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    // the window is never shown, all rendering goes to the framebuffer object below
+    GLFWwindow* window = glfwCreateWindow(64, 64, "ge_bench", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        std::cerr << "Failed to create GLFW window" << std::endl;
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "Failed to initialize GLAD" << std::endl;
+        return 1;
+    }
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+    GLuint framebuffer, colorBuffer, depthBuffer;
+    glGenFramebuffers(1, &framebuffer);
+    glGenRenderbuffers(1, &colorBuffer);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.Width, options.Height);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, options.Width, options.Height);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::cerr << "Offscreen framebuffer is incomplete" << std::endl;
+        return 1;
+    }
+
+    glEnable(GL_DEPTH_TEST);
+
+    SceneShaderSources sources;
+    sources.Vertex = readShader("vertex.glsl");
+    sources.Fragment = readShader("fragment.glsl");
+    sources.InstancedVertex = readShader("instanced_vertex.glsl");
+    sources.TerrainVertex = readShader("terrain_vertex.glsl");
+    sources.ShadowFragment = readShader("shadow_fragment.glsl");
+    if (sources.Vertex.empty() || sources.Fragment.empty() || sources.InstancedVertex.empty() || sources.TerrainVertex.empty() || sources.ShadowFragment.empty())
+        return 1;
+
+    // not initialized: the benchmark always compiles, so the cache state never changes its numbers
+    ProgramCache programCache;
+    Scene scene;
+    scene.Init(sources, programCache);
+    scene.Stress.Count = options.Cubes;
+    scene.Stress.PropCount = options.Props;
+    scene.LightCount = options.Lights;
+
+    JobSystem jobSystem;
+    jobSystem.Init();
+    scene.Stress.Jobs = &jobSystem;
+
+    Camera camera;
+    camera.FarPlane = scene.Ground.GetViewDistance();
+
+    // one query per measured frame, read back after the run so timing never waits on the GPU
+    std::vector<GLuint> queries(options.Frames);
+    glGenQueries(options.Frames, queries.data());
+    std::vector<FrameSample> samples(options.Frames);
+
+    // fixed step, so frame N always shows the same camera and animation regardless of speed
+    const float step = 1.0f / 60.0f;
+    const int totalFrames = options.Warmup + options.Frames;
+    for (int frame = 0; frame < totalFrames; ++frame)
+    {
+        int measured = frame - options.Warmup;
+        float time = frame * step;
+        placeCamera(camera, scene.Ground, options.Path, time);
+
+        GetRenderStats().Reset();
+        GetCullStats().Reset();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        if (measured >= 0)
+            glBeginQuery(GL_TIME_ELAPSED, queries[measured]);
+
+        glViewport(0, 0, options.Width, options.Height);
+        glClearColor(0.2f, 0.1f, 0.3f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        scene.Draw(camera, options.Width, options.Height, time, step);
+
+        if (measured >= 0)
+            glEndQuery(GL_TIME_ELAPSED);
+        // swapping the hidden window keeps the driver's frame pacing the same as in the app
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+        auto end = std::chrono::high_resolution_clock::now();
+
+        if (measured >= 0)
+        {
+            FrameSample& sample = samples[measured];
+            sample.CpuMs = std::chrono::duration<double, std::milli>(end - start).count();
+            sample.DrawCalls = GetRenderStats().DrawCalls;
+            sample.Visible = GetCullStats().Visible;
+            sample.TerrainTriangles = scene.Ground.Stats.Triangles;
+        }
+    }
+
+    std::vector<double> cpu, gpu;
+    for (int frame = 0; frame < options.Frames; ++frame)
+    {
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(queries[frame], GL_QUERY_RESULT, &elapsed);
+        samples[frame].GpuMs = elapsed / 1.0e6;
+        cpu.push_back(samples[frame].CpuMs);
+        gpu.push_back(samples[frame].GpuMs);
+    }
+
+    std::ofstream csv(options.Csv);
+    csv << "frame,cpu_ms,gpu_ms,draw_calls,visible,terrain_triangles\n";
+    for (int frame = 0; frame < options.Frames; ++frame)
+    {
+        const FrameSample& sample = samples[frame];
+        csv << frame << ',' << sample.CpuMs << ',' << sample.GpuMs << ',' << sample.DrawCalls << ','
+            << sample.Visible << ',' << sample.TerrainTriangles << '\n';
+    }
+
+    std::ofstream json(options.Json);
+    json << "{\n"
+         << "  \"renderer\": \"" << glGetString(GL_RENDERER) << "\",\n"
+         << "  \"path\": \"" << options.Path << "\",\n"
+         << "  \"frames\": " << options.Frames << ",\n"
+         << "  \"width\": " << options.Width << ",\n"
+         << "  \"height\": " << options.Height << ",\n"
+         << "  \"cubes\": " << options.Cubes << ",\n"
+         << "  \"props\": " << options.Props << ",\n"
+         << "  \"lights\": " << options.Lights << ",\n"
+         << "  \"cpu_ms\": { \"mean\": " << mean(cpu) << ", \"p50\": " << percentile(cpu, 50) << ", \"p95\": " << percentile(cpu, 95) << ", \"p99\": " << percentile(cpu, 99) << " },\n"
+         << "  \"gpu_ms\": { \"mean\": " << mean(gpu) << ", \"p50\": " << percentile(gpu, 50) << ", \"p95\": " << percentile(gpu, 95) << ", \"p99\": " << percentile(gpu, 99) << " }\n"
+         << "}\n";
+
+    std::cout << options.Frames << " frames (" << options.Path << "), CPU mean " << mean(cpu) << " ms p99 " << percentile(cpu, 99)
+              << " ms, GPU mean " << mean(gpu) << " ms p99 " << percentile(gpu, 99) << " ms" << std::endl;
+    std::cout << "Wrote " << options.Csv << " and " << options.Json << std::endl;
+
+    glDeleteQueries(options.Frames, queries.data());
+    scene.Delete();
+    jobSystem.Delete();
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteRenderbuffers(1, &depthBuffer);
+
+    glfwTerminate();
+    return 0;
+}
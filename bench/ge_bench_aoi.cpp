@@ -0,0 +1,173 @@
+// Interest management benchmark: thousands of wandering creatures and dozens of clients looking
+// from different places. Every tick the snapshot goes into the interest grid and each client's
+// entities are selected, as the replication server does it. Reports the per-tick cost of that, how
+// many entities each client gets, and the bytes per client and tick next to sending everything to
+// everyone. Bytes are measured as if every snapshot were acknowledged right away. Every tenth tick
+// each selection is checked against a brute-force distance test over all entities, and views that
+// are NaN or far outside the world must select nothing.
+//
+//   ge_bench_aoi [--entities N] [--clients N] [--ticks N] [--extent M] [--view-distance M]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "BitStream.h"
+#include "Interest.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// ids a viewer should get, by testing every entity: all within the last ring, and those within the
+// hysteresis margin the viewer already had; compared with what Select picked
+static size_t countWrongSelections(const InterestGrid& interest, const Snapshot& snapshot, const glm::vec3& viewer,
+                                   const Snapshot* previous, const Snapshot& selected)
+{
+    float outer = interest.Rings.back().Distance;
+    float reach = outer * interest.Hysteresis;
+    std::vector<uint32_t> expected;
+    size_t known = 0;
+    for (const NetEntityState& state : snapshot.Entities)
+    {
+        glm::vec2 offset = glm::vec2(DequantizePosition(state.Position[0]), DequantizePosition(state.Position[2])) - glm::vec2(viewer.x, viewer.z);
+        float distanceSquared = glm::dot(offset, offset);
+        if (distanceSquared > reach * reach)
+            continue;
+        bool had = false;
+        if (previous)
+        {
+            while (known < previous->Entities.size() && previous->Entities[known].Id < state.Id)
+                known++;
+            had = known < previous->Entities.size() && previous->Entities[known].Id == state.Id &&
+                  previous->Entities[known].Generation == state.Generation;
+        }
+        if (distanceSquared <= outer * outer || had)
+            expected.push_back(state.Id);
+    }
+
+    size_t wrong = expected.size() > selected.Entities.size() ? expected.size() - selected.Entities.size() : 0;
+    for (size_t i = 0; i < selected.Entities.size(); ++i)
+        wrong += i >= expected.size() || selected.Entities[i].Id != expected[i];
+    return wrong;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t entityCount = 10000;
+    int clientCount = 64;
+    int ticks = 600;
+    float extent = 1000.0f;
+    float viewDistance = 200.0f;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--entities") entityCount = (uint32_t)std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--clients") clientCount = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--ticks") ticks = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--extent") extent = std::max(1.0f, (float)atof(argv[i + 1]));
+        else if (arg == "--view-distance") viewDistance = std::max(1.0f, (float)atof(argv[i + 1]));
+    }
+
+    // flat ground: the simulation's cost isn't what is measured here
+    Simulation simulation;
+    simulation.Extent = extent;
+    simulation.SpawnWanderers(entityCount);
+
+    InterestGrid interest;
+    float scale = viewDistance / interest.Rings.back().Distance;
+    for (InterestRing& ring : interest.Rings)
+        ring.Distance *= scale;
+
+    // clients fly circles of different sizes around different places
+    std::vector<glm::vec3> centers(clientCount);
+    for (int c = 0; c < clientCount; ++c)
+    {
+        float angle = c * 2.39996f;
+        float radius = extent * std::sqrt((c + 0.5f) / clientCount);
+        centers[c] = glm::vec3(std::cos(angle) * radius, 0.0f, std::sin(angle) * radius);
+    }
+    std::vector<Snapshot> selected(clientCount), previous(clientCount);
+
+    const float DT = 1.0f / 60.0f;
+    Snapshot snapshot, lastSnapshot;
+    BitWriter writer;
+    double buildMs = 0.0, selectMs = 0.0, maxTickMs = 0.0, encodeMs = 0.0;
+    unsigned long long relevant = 0, fresh = 0, candidates = 0;
+    size_t interestBytes = 0, everythingBytes = 0, wrong = 0, checked = 0;
+    for (int tick = 1; tick <= ticks; ++tick)
+    {
+        simulation.Tick(DT);
+        CaptureSnapshot(simulation.Entities, (uint32_t)tick, snapshot);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        interest.Build(snapshot);
+        for (int c = 0; c < clientCount; ++c)
+        {
+            float angle = tick * DT * (0.2f + 0.01f * c);
+            glm::vec3 view = centers[c] + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * 30.0f;
+            interest.Select(snapshot, view, tick > 1 ? &previous[c] : nullptr, selected[c]);
+        }
+        double tickMs = elapsedMs(start);
+        maxTickMs = std::max(maxTickMs, tickMs);
+        buildMs += interest.Stats.BuildMs;
+        selectMs += interest.Stats.SelectMs;
+        relevant += interest.Stats.Relevant;
+        fresh += interest.Stats.Fresh;
+        candidates += interest.Stats.Candidates;
+
+        if (tick % 10 == 1)
+        {
+            for (int c = 0; c < clientCount; ++c)
+            {
+                float angle = tick * DT * (0.2f + 0.01f * c);
+                glm::vec3 view = centers[c] + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * 30.0f;
+                wrong += countWrongSelections(interest, snapshot, view, tick > 1 ? &previous[c] : nullptr, selected[c]);
+            }
+            checked += clientCount;
+        }
+
+        auto encodeStart = std::chrono::high_resolution_clock::now();
+        for (int c = 0; c < clientCount; ++c)
+        {
+            writer.Reset();
+            EncodeSnapshot(selected[c], tick > 1 ? &previous[c] : nullptr, writer);
+            interestBytes += writer.Bytes.size();
+            std::swap(selected[c], previous[c]);
+        }
+        encodeMs += elapsedMs(encodeStart);
+        // without interest everyone gets the same delta
+        writer.Reset();
+        EncodeSnapshot(snapshot, tick > 1 ? &lastSnapshot : nullptr, writer);
+        everythingBytes += writer.Bytes.size() * clientCount;
+        std::swap(snapshot, lastSnapshot);
+    }
+
+    // a view from a broken or hostile client: NaN, or so far out the cell math would overflow
+    Snapshot outside;
+    const glm::vec3 badViews[] = { glm::vec3(NAN, 0.0f, NAN), glm::vec3(1e30f, 0.0f, -1e30f), glm::vec3(extent * 10.0f, 0.0f, 0.0f) };
+    for (const glm::vec3& view : badViews)
+    {
+        interest.Select(lastSnapshot, view, nullptr, outside);
+        wrong += outside.Entities.size();
+    }
+
+    double perClientTick = 1.0 / ((double)ticks * clientCount);
+    printf("%u entities in %.0f m x %.0f m, %d clients, view distance %.0f m, %d ticks\n",
+           entityCount, extent * 2.0f, extent * 2.0f, clientCount, viewDistance, ticks);
+    printf("interest per tick: build %.3f ms, select %.3f ms (%.1f us per client), total max %.3f ms\n",
+           buildMs / ticks, selectMs / ticks, selectMs * 1000.0 * perClientTick, maxTickMs);
+    printf("per client and tick: %.0f entities in range (%.0f looked at), %.0f with fresh state, of %u\n",
+           relevant * perClientTick, candidates * perClientTick, fresh * perClientTick, entityCount);
+    printf("bytes per client and tick: %.0f with interest (encode %.3f ms per tick for all), %.0f sending everything\n",
+           interestBytes * perClientTick, encodeMs / ticks, everythingBytes * perClientTick);
+    printf("%zu selections checked against brute force, %zu entities wrong\n", checked, wrong);
+    // the first tick is a full snapshot either way; everything else should be far smaller with interest
+    return interestBytes < everythingBytes && wrong == 0 ? 0 : 1;
+}
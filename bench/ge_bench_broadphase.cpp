@@ -0,0 +1,134 @@
+// Broadphase benchmark: moves 100k boxes of mixed sizes every tick, rebuilds the grid and finds all
+// overlapping pairs on one thread and on the job system, then checks the pairs against brute force
+// on a sample of the boxes.
+//
+//   ge_bench_broadphase [--colliders N] [--ticks N] [--cell SIZE]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Collision.h"
+#include "JobSystem.h"
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t count = 100000;
+    int ticks = 60;
+    float cellSize = 2.0f;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--colliders") count = (uint32_t)std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--ticks") ticks = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--cell") cellSize = std::max(0.1f, (float)atof(argv[i + 1]));
+    }
+
+    // same density as the stress scene: boxes up to a few units across over a square that grows with
+    // the count, plus one in a hundred large enough to span many cells
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    float extent = std::sqrt((float)count) * 1.5f;
+    std::vector<glm::vec3> centers(count), halves(count), velocities(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        centers[i] = glm::vec3((unit(rng) * 2.0f - 1.0f) * extent, unit(rng) * 8.0f, (unit(rng) * 2.0f - 1.0f) * extent);
+        float size = i % 100 == 0 ? 4.0f + 4.0f * unit(rng) : 0.2f + 0.8f * unit(rng);
+        halves[i] = glm::vec3(size * 0.5f);
+        velocities[i] = glm::vec3(unit(rng) - 0.5f, unit(rng) - 0.5f, unit(rng) - 0.5f) * 4.0f;
+    }
+
+    // boxes move every tick, so every tick starts from a full rebuild
+    BroadphaseGrid grid;
+    grid.CellSize = cellSize;
+    std::vector<AABB> boxes(count);
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    const float DT = 1.0f / 60.0f;
+    auto run = [&](const char* label) {
+        double build = 0.0, find = 0.0, best = 1e30;
+        size_t pairTotal = 0;
+        for (int tick = 0; tick < ticks; ++tick)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                centers[i] += velocities[i] * DT;
+                boxes[i].Min = centers[i] - halves[i];
+                boxes[i].Max = centers[i] + halves[i];
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            grid.Build(boxes.data(), count);
+            grid.FindPairs(pairs);
+            best = std::min(best, elapsedMs(start));
+            build += grid.Stats.BuildMs;
+            find += grid.Stats.PairsMs;
+            pairTotal += pairs.size();
+        }
+        printf("%-10s build %.3f ms + pairs %.3f ms = %.3f ms per tick (best %.3f ms), %zu pairs\n",
+               label, build / ticks, find / ticks, (build + find) / ticks, best, pairTotal / ticks);
+    };
+    printf("%u colliders, cell size %.1f\n", count, cellSize);
+    run("1 thread:");
+
+    JobSystem jobs;
+    jobs.Init();
+    if (jobs.GetThreadCount() > 1)
+    {
+        char label[32];
+        snprintf(label, sizeof(label), "%u threads:", jobs.GetThreadCount());
+        grid.Jobs = &jobs;
+        run(label);
+    }
+    printf("%u cell entries\n", grid.Stats.Entries);
+
+    // queries the way the character controller does them
+    std::vector<uint32_t> found;
+    size_t hits = 0;
+    const uint32_t QUERIES = 10000;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t q = 0; q < QUERIES; ++q)
+    {
+        AABB box;
+        box.Min = centers[(q * 7919) % count] - glm::vec3(0.35f, 0.9f, 0.35f);
+        box.Max = centers[(q * 7919) % count] + glm::vec3(0.35f, 0.9f, 0.35f);
+        grid.Query(box, found);
+        hits += found.size();
+    }
+    double queryMs = elapsedMs(start);
+    printf("%u capsule-sized queries: %.3f ms (%.1f ns each, %.1f hits)\n", QUERIES, queryMs, queryMs * 1e6 / QUERIES, (double)hits / QUERIES);
+
+    // every pair involving a sampled box must be reported exactly once
+    const uint32_t SAMPLE = std::min(count, 500u);
+    std::vector<uint32_t> expected, reported;
+    size_t mismatches = 0;
+    for (uint32_t s = 0; s < SAMPLE; ++s)
+    {
+        uint32_t a = (uint32_t)(((uint64_t)s * count) / SAMPLE);
+        expected.clear();
+        for (uint32_t b = 0; b < count; ++b)
+            if (b != a && Overlaps(boxes[a], boxes[b]))
+                expected.push_back(b);
+        reported.clear();
+        for (const auto& pair : pairs)
+        {
+            if (pair.first == a) reported.push_back(pair.second);
+            else if (pair.second == a) reported.push_back(pair.first);
+        }
+        std::sort(reported.begin(), reported.end());
+        if (reported != expected)
+            mismatches++;
+    }
+    printf("brute force check on %u colliders: %s\n", SAMPLE, mismatches == 0 ? "ok" : "MISMATCH");
+    grid.Jobs = nullptr;
+    jobs.Delete();
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+// Culling benchmark: a million bounding spheres and a million boxes scattered around a camera,
+// culled on one thread with whichever SIMD path this build has. Reports the best and average time
+// per million bounds, then checks every result against the scalar Frustum tests.
+//
+//   ge_bench_culling [--bounds N] [--repeats N]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Culling.h"
+#include "Frustum.h"
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static const char* simdPath()
+{
+#if defined(GE_CULL_AVX2) && defined(__FMA__)
+    return "AVX2 + FMA";
+#elif defined(GE_CULL_AVX2)
+    return "AVX2";
+#elif defined(GE_CULL_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t count = 1000000;
+    int repeats = 50;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--bounds") count = (uint32_t)std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--repeats") repeats = std::max(1, atoi(argv[i + 1]));
+    }
+
+    // objects all around the camera, so about a sixth of them are in view
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    SphereBoundsSoA spheres;
+    AABBBoundsSoA boxes;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        glm::vec3 center((unit(rng) * 2.0f - 1.0f) * 500.0f, unit(rng) * 50.0f, (unit(rng) * 2.0f - 1.0f) * 500.0f);
+        float size = 0.5f + unit(rng) * 4.0f;
+        spheres.Add(center, size);
+        boxes.Add(center - glm::vec3(size, size * 0.5f, size), center + glm::vec3(size, size * 0.5f, size));
+    }
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(100.0f, 15.0f, 50.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum::FromMatrix(projection * view);
+
+    std::vector<uint32_t> visible;
+    size_t sphereVisible = 0, boxVisible = 0;
+    double sphereBest = 1e30, sphereTotal = 0.0, boxBest = 1e30, boxTotal = 0.0;
+    for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        sphereVisible = CullSpheres(frustum, spheres, visible);
+        double ms = elapsedMs(start);
+        sphereBest = std::min(sphereBest, ms);
+        sphereTotal += ms;
+
+        start = std::chrono::high_resolution_clock::now();
+        boxVisible = CullAABBs(frustum, boxes, visible);
+        ms = elapsedMs(start);
+        boxBest = std::min(boxBest, ms);
+        boxTotal += ms;
+    }
+
+    // every bound, against the scalar tests the SIMD paths mirror
+    size_t mismatches = 0;
+    size_t visibleCount = CullSpheres(frustum, spheres, visible);
+    std::vector<uint8_t> marked(count, 0);
+    for (size_t v = 0; v < visibleCount; ++v)
+        marked[visible[v]] = 1;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        bool expected = frustum.IntersectsSphere(glm::vec3(spheres.X[i], spheres.Y[i], spheres.Z[i]), spheres.Radius[i]);
+        mismatches += expected != (marked[i] != 0);
+    }
+    visibleCount = CullAABBs(frustum, boxes, visible);
+    std::fill(marked.begin(), marked.end(), 0);
+    for (size_t v = 0; v < visibleCount; ++v)
+        marked[visible[v]] = 1;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        glm::vec3 center(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]);
+        glm::vec3 extents(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]);
+        mismatches += frustum.IntersectsAABB(center - extents, center + extents) != (marked[i] != 0);
+    }
+
+    double perMillion = 1e6 / count;
+    printf("%u bounds, %s, one thread, %d repeats\n", count, simdPath(), repeats);
+    printf("spheres: %zu visible, best %.3f ms, average %.3f ms per million\n",
+           sphereVisible, sphereBest * perMillion, sphereTotal / repeats * perMillion);
+    printf("boxes:   %zu visible, best %.3f ms, average %.3f ms per million\n",
+           boxVisible, boxBest * perMillion, boxTotal / repeats * perMillion);
+    printf("%zu results differ from the scalar tests\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
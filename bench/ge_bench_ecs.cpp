@@ -0,0 +1,95 @@
+// ECS benchmark: creates a million entities spread over a few archetypes, then times a
+// Transform+Velocity update on one thread and on the job system, plus add/remove churn.
+//
+//   ge_bench_ecs [--entities N] [--repeats N]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Components.h"
+#include "ECS.h"
+#include "JobSystem.h"
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t count = 1000000;
+    int repeats = 20;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--entities") count = (uint32_t)std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--repeats") repeats = std::max(1, atoi(argv[i + 1]));
+    }
+
+    World world;
+    std::vector<Entity> entities(count);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Entity entity = world.Create();
+        Transform transform;
+        transform.Position = glm::vec3((float)(i % 1000), 0.0f, (float)(i / 1000));
+        world.Add<Transform>(entity, transform);
+        Velocity velocity;
+        velocity.Linear = glm::vec3(1.0f, 0.0f, 0.5f);
+        world.Add<Velocity>(entity, velocity);
+        // every fourth entity is drawable, so the query spans two archetypes
+        if (i % 4 == 0)
+            world.Add<MeshRenderer>(entity);
+        entities[i] = entity;
+    }
+    double createMs = elapsedMs(start);
+    printf("created %u entities in %zu archetypes: %.1f ms\n", count, world.GetArchetypeCount(), createMs);
+
+    double single = 1e30;
+    for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+        start = std::chrono::high_resolution_clock::now();
+        IntegrateVelocities(world, 1.0f / 60.0f);
+        single = std::min(single, elapsedMs(start));
+    }
+    printf("Transform+Velocity update, 1 thread:   %.3f ms (%.2f ns/entity)\n", single, single * 1e6 / count);
+
+    JobSystem jobs;
+    jobs.Init();
+    double parallel = 1e30;
+    for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+        start = std::chrono::high_resolution_clock::now();
+        world.EachChunkParallel<Transform, const Velocity>(jobs, [](uint32_t n, const Entity*, Transform* transforms, const Velocity* velocities) {
+            for (uint32_t i = 0; i < n; ++i)
+                transforms[i].Position += velocities[i].Linear * (1.0f / 60.0f);
+        });
+        parallel = std::min(parallel, elapsedMs(start));
+    }
+    printf("Transform+Velocity update, %u threads: %.3f ms\n", jobs.GetThreadCount(), parallel);
+    jobs.Delete();
+
+    // structural changes: each one moves the entity to another archetype and swaps the hole closed
+    uint32_t churn = std::min(count, 100000u);
+    start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < churn; ++i)
+        world.Remove<Velocity>(entities[i]);
+    for (uint32_t i = 0; i < churn; ++i)
+        world.Add<Velocity>(entities[i]);
+    double churnMs = elapsedMs(start);
+    printf("%u component removes + %u adds: %.2f ms (%.0f ns each)\n", churn, churn, churnMs, churnMs * 1e6 / (2.0 * churn));
+
+    // checksum so the updates cannot be optimized away
+    double sum = 0.0;
+    world.EachChunk<const Transform>([&](uint32_t n, const Entity*, const Transform* transforms) {
+        for (uint32_t i = 0; i < n; ++i)
+            sum += transforms[i].Position.x;
+    });
+    printf("checksum %.1f\n", sum);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Evolution benchmark: a million genomes evolved for a number of generations, first on one thread
+// and then on 2, 4 ... up to the hardware thread count. Reports the time per generation split into
+// evaluation and breeding, the speedup against one thread, and how fitness improved. Every run
+// starts from the same seed, so each must end with the same genomes; a mismatch fails the run.
+//
+//   ge_bench_evolution [--genomes N] [--generations N] [--threads N]
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Evolution.h"
+#include "JobSystem.h"
+
+struct RunResult
+{
+    double EvaluateMs = 0.0;
+    double BreedMs = 0.0;
+    double MaxGenerationMs = 0.0;
+    float FirstMean = 0.0f;
+    float LastMean = 0.0f;
+    float LastBest = 0.0f;
+    uint64_t Hash = 0;
+};
+
+// FNV-1a over every gene's bits
+static uint64_t hashGenes(const Population& population)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::vector<float>& gene : population.Genes)
+    {
+        for (float value : gene)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+static RunResult run(uint32_t genomes, int generations, unsigned int threads)
+{
+    JobSystem jobs;
+    jobs.Init(threads);
+    Evolution evolution;
+    evolution.Jobs = &jobs;
+    evolution.Init(genomes);
+
+    RunResult result;
+    for (int generation = 0; generation < generations; ++generation)
+    {
+        evolution.Step();
+        result.EvaluateMs += evolution.Stats.EvaluateMs;
+        result.BreedMs += evolution.Stats.BreedMs;
+        result.MaxGenerationMs = std::max(result.MaxGenerationMs, evolution.Stats.GenerationMs);
+        if (generation == 0)
+            result.FirstMean = evolution.Stats.MeanFitness;
+    }
+    // score the last offspring too
+    evolution.Evaluate();
+    result.LastMean = evolution.Stats.MeanFitness;
+    result.LastBest = evolution.Stats.BestFitness;
+    result.Hash = hashGenes(evolution.Creatures);
+    jobs.Delete();
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t genomes = 1000000;
+    int generations = 20;
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--genomes") genomes = (uint32_t)std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--generations") generations = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--threads") maxThreads = (unsigned int)std::max(1, atoi(argv[i + 1]));
+    }
+
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    printf("%u genomes of %u genes, %d generations, blocks of %u\n", genomes, GENE_COUNT, generations, EVOLUTION_BLOCK);
+    printf("%8s %14s %12s %12s %10s %9s %22s\n", "threads", "generation ms", "evaluate ms", "breed ms", "max ms", "speedup", "mean fitness");
+    double singleMs = 0.0;
+    uint64_t expected = 0;
+    bool deterministic = true;
+    for (unsigned int threads : threadCounts)
+    {
+        RunResult r = run(genomes, generations, threads);
+        double generationMs = (r.EvaluateMs + r.BreedMs) / generations;
+        if (threads == threadCounts.front())
+        {
+            singleMs = generationMs;
+            expected = r.Hash;
+        }
+        bool same = r.Hash == expected;
+        deterministic = deterministic && same;
+        printf("%8u %14.2f %12.2f %12.2f %10.2f %8.2fx %10.3f -> %-9.3f%s\n",
+               threads, generationMs, r.EvaluateMs / generations, r.BreedMs / generations, r.MaxGenerationMs,
+               singleMs / generationMs, r.FirstMean, r.LastMean, same ? "" : " MISMATCH");
+    }
+    printf(deterministic ? "every thread count bred the same genomes\n" : "genomes differ between thread counts\n");
+    return deterministic ? 0 : 1;
+}
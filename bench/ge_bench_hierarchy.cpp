@@ -0,0 +1,132 @@
+// Transform hierarchy benchmark: about ten thousand nodes in creatures of 14 (a body, a hat and four
+// three-segment legs) updated breadth-first. Times a full update with every body moving and a
+// partial one where only the legs of every tenth creature move, checks the world matrices against a
+// recursive reference, and checks that a destroyed node's handle is reported dead.
+//
+//   ge_bench_hierarchy [--creatures N] [--repeats N]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "TransformHierarchy.h"
+
+static const int LEGS = 4;
+static const int LEG_SEGMENTS = 3;
+
+struct Creature
+{
+    TransformNode Body;
+    TransformNode Hat;
+    TransformNode Legs[LEGS][LEG_SEGMENTS];
+};
+
+static Transform makeLocal(float x, float y, float z, float angle)
+{
+    Transform t;
+    t.Position = glm::vec3(x, y, z);
+    t.Rotation = glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f));
+    return t;
+}
+
+static float maxDifference(const glm::mat4& a, const glm::mat4& b)
+{
+    float difference = 0.0f;
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            difference = std::max(difference, std::fabs(a[c][r] - b[c][r]));
+    return difference;
+}
+
+int main(int argc, char** argv)
+{
+    int creatureCount = 715;
+    int repeats = 200;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--creatures") creatureCount = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--repeats") repeats = std::max(1, atoi(argv[i + 1]));
+    }
+
+    TransformHierarchy hierarchy;
+    std::vector<Creature> creatures(creatureCount);
+    for (int c = 0; c < creatureCount; ++c)
+    {
+        Creature& creature = creatures[c];
+        creature.Body = hierarchy.Create(makeLocal((float)(c % 32) * 4.0f, 1.0f, (float)(c / 32) * 4.0f, 0.0f));
+        creature.Hat = hierarchy.Create(makeLocal(0.0f, 0.6f, 0.0f, 0.0f), creature.Body);
+        for (int leg = 0; leg < LEGS; ++leg)
+        {
+            TransformNode parent = creature.Body;
+            for (int segment = 0; segment < LEG_SEGMENTS; ++segment)
+            {
+                float x = segment == 0 ? (leg < 2 ? -0.4f : 0.4f) : 0.0f;
+                creature.Legs[leg][segment] = hierarchy.Create(makeLocal(x, -0.3f, 0.0f, 0.1f), parent);
+                parent = creature.Legs[leg][segment];
+            }
+        }
+    }
+    hierarchy.Update();
+
+    double fullBest = 1e30, fullTotal = 0.0, partialBest = 1e30, partialTotal = 0.0;
+    unsigned int fullUpdated = 0, partialUpdated = 0;
+    for (int repeat = 0; repeat < repeats; ++repeat)
+    {
+        float time = repeat * 0.016f;
+        for (int c = 0; c < creatureCount; ++c)
+            hierarchy.SetLocal(creatures[c].Body, makeLocal((float)(c % 32) * 4.0f + std::sin(time + c), 1.0f, (float)(c / 32) * 4.0f, time));
+        hierarchy.Update();
+        fullBest = std::min(fullBest, hierarchy.Stats.UpdateMs);
+        fullTotal += hierarchy.Stats.UpdateMs;
+        fullUpdated = hierarchy.Stats.Updated;
+
+        for (int c = 0; c < creatureCount; c += 10)
+            for (int leg = 0; leg < LEGS; ++leg)
+                hierarchy.SetLocal(creatures[c].Legs[leg][0], makeLocal(leg < 2 ? -0.4f : 0.4f, -0.3f, 0.0f, std::sin(time * 3.0f + leg)));
+        hierarchy.Update();
+        partialBest = std::min(partialBest, hierarchy.Stats.UpdateMs);
+        partialTotal += hierarchy.Stats.UpdateMs;
+        partialUpdated = hierarchy.Stats.Updated;
+    }
+
+    // every node against its parent's world matrix times its own local one
+    float worst = 0.0f;
+    for (const Creature& creature : creatures)
+    {
+        const glm::mat4& body = hierarchy.GetWorld(creature.Body);
+        worst = std::max(worst, maxDifference(body, hierarchy.GetLocal(creature.Body).ToMatrix()));
+        worst = std::max(worst, maxDifference(hierarchy.GetWorld(creature.Hat), body * hierarchy.GetLocal(creature.Hat).ToMatrix()));
+        for (int leg = 0; leg < LEGS; ++leg)
+        {
+            glm::mat4 expected = body;
+            for (int segment = 0; segment < LEG_SEGMENTS; ++segment)
+            {
+                expected = expected * hierarchy.GetLocal(creature.Legs[leg][segment]).ToMatrix();
+                worst = std::max(worst, maxDifference(hierarchy.GetWorld(creature.Legs[leg][segment]), expected));
+            }
+        }
+    }
+
+    // destroying a body takes its whole creature with it; the freed slots are reused with a new generation
+    size_t nodes = hierarchy.GetNodeCount();
+    Creature destroyed = creatures.back();
+    hierarchy.Destroy(destroyed.Body);
+    hierarchy.Update();
+    TransformNode reused = hierarchy.Create(makeLocal(0.0f, 0.0f, 0.0f, 0.0f));
+    hierarchy.Update();
+    bool staleDetected = !hierarchy.IsAlive(destroyed.Body) && !hierarchy.IsAlive(destroyed.Hat) &&
+                         !hierarchy.IsAlive(destroyed.Legs[LEGS - 1][LEG_SEGMENTS - 1]) &&
+                         hierarchy.IsAlive(reused) && hierarchy.IsAlive(creatures.front().Body) &&
+                         hierarchy.GetNodeCount() == nodes - (1 + 1 + LEGS * LEG_SEGMENTS) + 1;
+
+    printf("%d creatures, %zu nodes, %d repeats\n", creatureCount, nodes, repeats);
+    printf("full:    %u updated, best %.3f ms, average %.3f ms\n", fullUpdated, fullBest, fullTotal / repeats);
+    printf("partial: %u updated, best %.3f ms, average %.3f ms\n", partialUpdated, partialBest, partialTotal / repeats);
+    printf("largest difference from the reference: %g\n", worst);
+    printf(staleDetected ? "handles of destroyed nodes are reported dead\n" : "a destroyed node's handle is still alive\n");
+    return worst < 1e-4f && staleDetected ? 0 : 1;
+}
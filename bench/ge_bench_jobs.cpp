@@ -0,0 +1,94 @@
+// Job system scaling benchmark: runs the same parallel_for over a million elements with 1, 2, 4 ...
+// threads up to the hardware thread count and reports time and speedup against one thread.
+//
+//   ge_bench_jobs [--elements N] [--repeats N] [--threads N]
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+
+// a few dozen flops per element, roughly what a particle or transform update costs
+static void update(float* positions, float* velocities, uint32_t begin, uint32_t end)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        float p = positions[i];
+        float v = velocities[i];
+        for (int step = 0; step < 8; ++step)
+        {
+            v += -p * 0.01f - v * 0.001f;
+            p += v * 0.016f;
+            p = std::sqrt(p * p + 1.0f) - 1.0f + p * 0.5f;
+        }
+        positions[i] = p;
+        velocities[i] = v;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t elements = 1000000;
+    int repeats = 20;
+    unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--elements") elements = (uint32_t)std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--repeats") repeats = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--threads") maxThreads = (unsigned int)std::max(1, atoi(argv[i + 1]));
+    }
+
+    std::vector<float> positions(elements), velocities(elements);
+    std::cout << "parallel_for over " << elements << " elements, best of " << repeats << " runs" << std::endl;
+    std::cout << "threads      ms   speedup  efficiency" << std::endl;
+
+    // powers of two, plus the full thread count when it is not one
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int threads = 1; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(maxThreads);
+
+    double baseline = 0.0;
+    for (unsigned int threads : threadCounts)
+    {
+        JobSystem jobs;
+        jobs.Init(threads);
+
+        double best = 1e30;
+        for (int repeat = 0; repeat < repeats; ++repeat)
+        {
+            for (uint32_t i = 0; i < elements; ++i)
+            {
+                positions[i] = (float)(i % 1000) * 0.01f;
+                velocities[i] = 0.0f;
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            jobs.ParallelFor(elements, [&](uint32_t begin, uint32_t end) {
+                update(positions.data(), velocities.data(), begin, end);
+            });
+            auto end = std::chrono::high_resolution_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        jobs.Delete();
+
+        if (threads == 1)
+            baseline = best;
+        double speedup = baseline / best;
+        printf("%7u %7.3f %8.2fx %10.0f%%\n", threads, best, speedup, 100.0 * speedup / threads);
+    }
+
+    // checksum so the work cannot be optimized away
+    double sum = 0.0;
+    for (float p : positions)
+        sum += p;
+    std::cout << "checksum " << sum << std::endl;
+    return 0;
+}
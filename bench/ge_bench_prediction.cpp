@@ -0,0 +1,277 @@
+// Client-side prediction benchmark: a server and a client simulation in one process, with the
+// network replaced by queues that hold every message back for half the round trip. The client walks
+// a scripted path through the server's wanderers, predicting its player and reconciling against the
+// server's reports. For each round trip time it reports how often the prediction was corrected, by
+// how much, and what the replays cost, next to how long the player would wait for the server
+// without prediction. Finally feeds a server player commands that aren't finite or far too fast and
+// checks that it stays where it could have walked to.
+//
+//   ge_bench_prediction [--rtt-ms MS] [--ticks N] [--entities N] [--loss FRACTION]
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Prediction.h"
+#include "Replication.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "TerrainHeightmap.h"
+
+// commands as they go on the wire, read back with the server's checks
+struct ToServer
+{
+    int Due;
+    std::vector<uint8_t> Commands;
+};
+
+struct ToClient
+{
+    int Due;
+    PlayerState State;
+    Snapshot World;
+};
+
+struct RunResult
+{
+    double PendingSum = 0.0;
+    unsigned int Corrections = 0;
+    unsigned int Confirmations = 0;
+    double ErrorSum = 0.0;
+    float MaxError = 0.0f;
+    double ReplayTicksSum = 0.0;
+    uint32_t MaxReplayTicks = 0;
+    double ReplayMsSum = 0.0;
+    double MaxReplayMs = 0.0;
+    // ticks from pressing a key until the server's report shows it
+    double WaitTicksSum = 0.0;
+    unsigned int Waits = 0;
+};
+
+// walks a new direction every second and jumps now and then
+static PlayerInput scriptedInput(int tick)
+{
+    PlayerInput input;
+    int leg = tick / 60;
+    float heading = (float)((leg * 2654435761u) % 360) * 0.0174533f;
+    if (leg % 5 != 4)
+        input.Move = glm::vec3(std::cos(heading), 0.0f, std::sin(heading)) * 4.0f;
+    input.Jump = tick % 90 == 45;
+    return input;
+}
+
+static RunResult run(const TerrainHeightmap& heightmap, float rttMs, int ticks, uint32_t entityCount, float loss)
+{
+    const float DT = 1.0f / 60.0f;
+    // the round trip in whole ticks, split between the two directions
+    int roundTrip = (int)std::lround(rttMs / 1000.0 * 60.0);
+    int upstream = roundTrip / 2, downstream = roundTrip - upstream;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    Simulation server;
+    server.Extent = 24.0f;
+    server.SetGround(heightmap.AsHeightfield());
+    server.SpawnWanderers(entityCount);
+    uint32_t serverPlayer = server.AddPlayer(glm::vec3(0.0f));
+    std::vector<InputCommand> serverInputs;
+    uint32_t serverInputTick = NO_TICK;
+
+    Simulation client;
+    client.SetGround(heightmap.AsHeightfield());
+    PlayerPrediction prediction;
+
+    std::deque<ToServer> toServer;
+    std::deque<ToClient> toClient;
+    RunResult result;
+    // ticks whose input differs from the one before, waiting for the server to report them
+    std::deque<uint32_t> changes;
+    PlayerInput lastInput;
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        // client: take what arrived, then predict this tick's input
+        while (!toClient.empty() && toClient.front().Due <= tick)
+        {
+            client.ApplySnapshot(toClient.front().World);
+            client.Tick(DT);
+            unsigned int corrections = prediction.Stats.Corrections;
+            prediction.Reconcile(toClient.front().State, DT, client.Collision);
+            if (prediction.Stats.Corrections != corrections)
+            {
+                result.ErrorSum += prediction.Stats.LastError;
+                result.MaxError = std::max(result.MaxError, prediction.Stats.LastError);
+                result.ReplayTicksSum += prediction.Stats.LastReplayTicks;
+                result.ReplayMsSum += prediction.Stats.LastReplayMs;
+            }
+            while (!changes.empty() && (int32_t)(toClient.front().State.InputTick - changes.front()) >= 0)
+            {
+                result.WaitTicksSum += tick - (int)changes.front();
+                result.Waits++;
+                changes.pop_front();
+            }
+            toClient.pop_front();
+        }
+        PlayerInput input = scriptedInput(tick);
+        if (input.Move != lastInput.Move || input.Jump)
+            changes.push_back((uint32_t)tick);
+        lastInput = input;
+        prediction.Predict(input, DT, client.Collision);
+        result.PendingSum += prediction.Stats.Pending;
+        InputCommand unconfirmed[INPUT_REDUNDANCY];
+        size_t unconfirmedCount = prediction.GetUnconfirmed(unconfirmed, INPUT_REDUNDANCY);
+        ToServer message;
+        message.Due = tick + upstream;
+        message.Commands.resize(unconfirmedCount * INPUT_COMMAND_BYTES);
+        for (size_t i = 0; i < unconfirmedCount; ++i)
+            WriteInputCommand(message.Commands.data() + i * INPUT_COMMAND_BYTES, unconfirmed[i]);
+        if (unit(rng) >= loss)
+            toServer.push_back(message);
+
+        // server: queue new commands, apply one (two to catch up), report back
+        while (!toServer.empty() && toServer.front().Due <= tick)
+        {
+            const std::vector<uint8_t>& bytes = toServer.front().Commands;
+            for (size_t offset = 0; offset < bytes.size(); offset += INPUT_COMMAND_BYTES)
+            {
+                InputCommand command;
+                if (!ReadInputCommand(bytes.data() + offset, command))
+                    continue;
+                uint32_t newest = serverInputs.empty() ? serverInputTick : serverInputs.back().Tick;
+                if (newest == NO_TICK || (int32_t)(command.Tick - newest) > 0)
+                    serverInputs.push_back(command);
+            }
+            if (serverInputs.size() > MAX_QUEUED_INPUTS)
+                serverInputs.erase(serverInputs.begin(), serverInputs.end() - MAX_QUEUED_INPUTS);
+            toServer.pop_front();
+        }
+        for (int pop = 0; pop < 2 && !serverInputs.empty(); ++pop)
+        {
+            if (pop == 1 && serverInputs.size() <= INPUT_CATCH_UP)
+                break;
+            server.AddInput(serverPlayer, serverInputs.front().Input);
+            serverInputTick = serverInputs.front().Tick;
+            serverInputs.erase(serverInputs.begin());
+        }
+        server.Tick(DT);
+        if (serverInputTick != NO_TICK && unit(rng) >= loss)
+        {
+            ToClient reply;
+            reply.Due = tick + downstream;
+            const CharacterController& player = server.Players[serverPlayer];
+            reply.State.InputTick = serverInputTick;
+            reply.State.Position = player.Position;
+            reply.State.Velocity = player.Velocity;
+            reply.State.OnGround = player.OnGround;
+            CaptureSnapshot(server.Entities, (uint32_t)tick, reply.World);
+            toClient.push_back(reply);
+        }
+    }
+    result.Corrections = prediction.Stats.Corrections;
+    result.Confirmations = prediction.Stats.Confirmations;
+    result.MaxReplayTicks = prediction.Stats.MaxReplayTicks;
+    result.MaxReplayMs = prediction.Stats.MaxReplayMs;
+    return result;
+}
+
+struct HostileResult
+{
+    unsigned int Sent = 0;
+    unsigned int Rejected = 0;
+    unsigned int NotFinite = 0;
+    // horizontal distance walked in one tick, and the most a tick at MAX_WALK_SPEED allows
+    float MaxStep = 0.0f;
+    float AllowedStep = 0.0f;
+};
+
+// a client sending moves that are NaN, infinite or enormous; the server must drop the first two and
+// slow the last to a walk
+static HostileResult hostileInputs(const TerrainHeightmap& heightmap, int ticks)
+{
+    const float DT = 1.0f / 60.0f;
+    const float NOT_A_NUMBER = std::numeric_limits<float>::quiet_NaN();
+    const float INFINITE = std::numeric_limits<float>::infinity();
+    const float LARGEST = std::numeric_limits<float>::max();
+    const glm::vec2 moves[] = {
+        { NOT_A_NUMBER, 0.0f }, { 0.0f, INFINITE }, { -INFINITE, NOT_A_NUMBER }, { 1e30f, 0.0f },
+        { -LARGEST, LARGEST }, { 3.0f, 4.0f }, { 1e6f, -1e6f }, { 0.0f, -MAX_WALK_SPEED * 1.5f },
+    };
+    const unsigned int MOVES = sizeof(moves) / sizeof(moves[0]);
+
+    Simulation server;
+    server.SetGround(heightmap.AsHeightfield());
+    uint32_t player = server.AddPlayer(glm::vec3(0.0f));
+    HostileResult result;
+    result.AllowedStep = MAX_WALK_SPEED * DT;
+    for (int tick = 0; tick < ticks; ++tick)
+    {
+        InputCommand sent;
+        sent.Tick = (uint32_t)tick;
+        sent.Input.Move = glm::vec3(moves[tick % MOVES].x, 0.0f, moves[tick % MOVES].y);
+        sent.Input.Jump = tick % 30 == 0;
+        uint8_t bytes[INPUT_COMMAND_BYTES];
+        WriteInputCommand(bytes, sent);
+        result.Sent++;
+
+        InputCommand received;
+        if (ReadInputCommand(bytes, received))
+            server.AddInput(player, received.Input);
+        else
+            result.Rejected++;
+        glm::vec3 before = server.Players[player].Position;
+        server.Tick(DT);
+        glm::vec3 after = server.Players[player].Position;
+        if (!std::isfinite(after.x) || !std::isfinite(after.y) || !std::isfinite(after.z))
+        {
+            result.NotFinite++;
+            break;
+        }
+        result.MaxStep = std::max(result.MaxStep, glm::length(glm::vec2(after.x - before.x, after.z - before.z)));
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<float> rtts = { 50.0f, 150.0f, 300.0f, 500.0f };
+    int ticks = 1800;
+    uint32_t entityCount = 400;
+    float loss = 0.0f;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--rtt-ms") rtts = { (float)atof(argv[i + 1]) };
+        else if (arg == "--ticks") ticks = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--entities") entityCount = (uint32_t)std::max(0, atoi(argv[i + 1]));
+        else if (arg == "--loss") loss = (float)atof(argv[i + 1]);
+    }
+
+    TerrainHeightmap heightmap;
+    heightmap.Generate();
+
+    const double TICK_MS = 1000.0 / 60.0;
+    printf("%d ticks at 60 Hz, %u wanderers, %.0f%% loss, %u ticks of history\n", ticks, entityCount, loss * 100.0f, PlayerPrediction::HISTORY);
+    printf("%8s %10s %12s %12s %14s %14s %12s\n", "rtt ms", "pending", "corrections", "error avg/max m", "replay ticks", "replay ms", "wait ms");
+    for (float rtt : rtts)
+    {
+        RunResult r = run(heightmap, rtt, ticks, entityCount, loss);
+        double corrections = std::max(1u, r.Corrections);
+        printf("%8.0f %10.1f %5u/%-6u %7.3f/%-7.3f %6.1f/%-7u %6.3f/%-7.3f %12.0f\n",
+               rtt, r.PendingSum / ticks, r.Corrections, r.Corrections + r.Confirmations, r.ErrorSum / corrections, r.MaxError,
+               r.ReplayTicksSum / corrections, r.MaxReplayTicks, r.ReplayMsSum / corrections, r.MaxReplayMs,
+               r.Waits ? r.WaitTicksSum / r.Waits * TICK_MS : 0.0);
+    }
+    printf("input reaches the predicted player the tick it is pressed; wait is what the server's report takes\n");
+
+    // three of every eight hostile commands aren't finite
+    HostileResult hostile = hostileInputs(heightmap, 240);
+    bool rejected = hostile.Rejected == hostile.Sent / 8 * 3 && hostile.NotFinite == 0;
+    bool walked = hostile.MaxStep <= hostile.AllowedStep * 1.01f;
+    printf("hostile input: %u of %u commands rejected, position %s, fastest tick %.3f m of %.3f m allowed\n",
+           hostile.Rejected, hostile.Sent, hostile.NotFinite ? "NOT finite" : "finite", hostile.MaxStep, hostile.AllowedStep);
+    return rejected && walked ? 0 : 1;
+}
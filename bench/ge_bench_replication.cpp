@@ -0,0 +1,147 @@
+// Replication benchmark: a server and several clients in one process, talking UDP over loopback.
+// The world has a few thousand replicated entities, a fraction of them moving and a few spawned
+// and destroyed every tick. Reports bytes per tick per client and snapshot encode/decode time,
+// and checks every client ends up with exactly the server's snapshot.
+//
+//   ge_bench_replication [--entities N] [--clients N] [--ticks N] [--moving FRACTION] [--loss FRACTION]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Components.h"
+#include "ECS.h"
+#include "Replication.h"
+#include "Snapshot.h"
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t entityCount = 5000;
+    int clientCount = 4;
+    int ticks = 300;
+    float moving = 0.1f;
+    float loss = 0.0f;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--entities") entityCount = (uint32_t)std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--clients") clientCount = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--ticks") ticks = std::max(1, atoi(argv[i + 1]));
+        else if (arg == "--moving") moving = (float)atof(argv[i + 1]);
+        else if (arg == "--loss") loss = (float)atof(argv[i + 1]);
+    }
+
+    std::mt19937 rng(1337);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    World world;
+    std::vector<Entity> entities;
+    auto spawn = [&]() {
+        Entity entity = world.Create();
+        Transform transform;
+        transform.Position = glm::vec3(unit(rng) * 200.0f - 100.0f, 0.0f, unit(rng) * 200.0f - 100.0f);
+        world.Add<Transform>(entity, transform);
+        Velocity velocity;
+        if (unit(rng) < moving)
+            velocity.Linear = glm::vec3(unit(rng) - 0.5f, 0.0f, unit(rng) - 0.5f) * 6.0f;
+        world.Add<Velocity>(entity, velocity);
+        Replicated replicated;
+        replicated.Kind = (uint32_t)(unit(rng) * 4.0f);
+        world.Add<Replicated>(entity, replicated);
+        entities.push_back(entity);
+    };
+    for (uint32_t i = 0; i < entityCount; ++i)
+        spawn();
+
+    ReplicationServer server;
+    server.PacketLoss = loss;
+    if (!server.Start(0))
+    {
+        printf("could not open the server socket\n");
+        return 1;
+    }
+    std::vector<ReplicationClient> clients(clientCount);
+    for (ReplicationClient& client : clients)
+    {
+        if (!client.Connect(NetAddress::Loopback(server.GetPort())))
+        {
+            printf("could not open a client socket\n");
+            return 1;
+        }
+    }
+    // the connect requests are in flight; let them land before the first tick
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    Snapshot snapshot;
+    double captureMs = 0.0, encodeMs = 0.0, decodeMs = 0.0;
+    size_t bytes = 0, firstBytes = 0, packets = 0;
+    unsigned int fullSnapshots = 0, decoded = 0, mismatches = 0;
+    const float DT = 1.0f / 60.0f;
+    for (int tick = 1; tick <= ticks; ++tick)
+    {
+        // a little churn: one entity in a thousand replaced every tick
+        for (uint32_t i = 0; i < std::max(1u, entityCount / 1000); ++i)
+        {
+            size_t victim = (size_t)(unit(rng) * entities.size()) % entities.size();
+            world.Destroy(entities[victim]);
+            entities[victim] = entities.back();
+            entities.pop_back();
+            spawn();
+        }
+        IntegrateVelocities(world, DT);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        CaptureSnapshot(world, (uint32_t)tick, snapshot);
+        captureMs += elapsedMs(start);
+
+        server.Receive();
+        server.Send(snapshot);
+        encodeMs += server.Stats.EncodeMs;
+        bytes += server.Stats.BytesSent;
+        packets += server.Stats.PacketsSent;
+        fullSnapshots += server.Stats.FullSnapshots;
+        if (tick == 1)
+            firstBytes = server.Stats.BytesSent / std::max(1u, server.Stats.Clients);
+
+        // loopback delivers within microseconds, but give the clients a moment for big snapshots
+        auto waitStart = std::chrono::steady_clock::now();
+        for (ReplicationClient& client : clients)
+        {
+            while (true)
+            {
+                if (client.Receive())
+                {
+                    decoded++;
+                    decodeMs += client.Stats.DecodeMs;
+                }
+                const Snapshot* latest = client.GetSnapshot();
+                if ((latest && latest->Tick == (uint32_t)tick) || std::chrono::steady_clock::now() - waitStart > std::chrono::milliseconds(loss > 0.0f ? 2 : 50))
+                    break;
+            }
+            const Snapshot* latest = client.GetSnapshot();
+            if (latest && latest->Tick == (uint32_t)tick && latest->Entities != snapshot.Entities)
+                mismatches++;
+        }
+    }
+
+    size_t perClientTick = bytes / ((size_t)ticks * clientCount);
+    printf("%u entities (%.0f%% moving), %d clients, %d ticks, %.0f%% loss\n", entityCount, moving * 100.0f, clientCount, ticks, loss * 100.0f);
+    printf("full snapshot: %zu bytes; average per client and tick: %zu bytes (%.1f KB/s at 60 Hz), %.1f datagrams\n",
+           firstBytes, perClientTick, perClientTick * 60.0 / 1024.0, (double)packets / ((double)ticks * clientCount));
+    printf("capture %.3f ms/tick, encode %.3f ms per client and tick, decode %.3f ms per snapshot\n",
+           captureMs / ticks, encodeMs / ((double)ticks * clientCount), decoded ? decodeMs / decoded : 0.0);
+    printf("%u full snapshots sent, %u snapshots decoded, %u mismatches\n", fullSnapshots, decoded, mismatches);
+
+    for (ReplicationClient& client : clients)
+        client.Disconnect();
+    server.Stop();
+    return mismatches == 0 && decoded > 0 ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+// Texture streaming benchmark: writes a set of BC5 DDS files, then draws them one after another at
+// full size with a resident budget that holds only a few of them, and finally all of them at once at
+// a quarter size. Checks every frame that the uploads stay under the per-frame byte cap (a single
+// level larger than the cap may go alone) and resident memory under its budget, and after each
+// texture that the least recently drawn textures gave up their levels first. Reports frames and time
+// until each texture is sharp.
+//
+//   ge_bench_textures [--textures N] [--size N] [--budget-textures N] [--upload-kb N]
+//
+// Needs a GL 3.3 context; uses a hidden GLFW window like ge_bench (under `xvfb-run` without a display).
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "GLExtensions.h"
+#include "JobSystem.h"
+#include "TextureFile.h"
+#include "TextureStreamer.h"
+
+static const int MAX_FRAMES_PER_TEXTURE = 2000;
+
+static void writeU32(std::vector<uint8_t>& bytes, size_t offset, uint32_t value)
+{
+    memcpy(bytes.data() + offset, &value, sizeof(value));
+}
+
+// a square BC5 texture with its full mip chain; the block contents don't matter to the streamer
+static bool writeDDS(const std::string& path, uint32_t size, uint8_t fill)
+{
+    TextureFileInfo info;
+    info.Format = BLOCK_FORMAT_BC5;
+    info.Width = info.Height = size;
+    buildMipChain(info, 32, DDS_HEADER_BYTES);
+    const TextureMip& last = info.Mips.back();
+
+    std::vector<uint8_t> bytes((size_t)(last.Offset + last.Size), fill);
+    memset(bytes.data(), 0, DDS_HEADER_BYTES);
+    memcpy(bytes.data(), "DDS ", 4);
+    writeU32(bytes, 4, 124);
+    writeU32(bytes, 12, size);
+    writeU32(bytes, 16, size);
+    writeU32(bytes, 28, (uint32_t)info.Mips.size());
+    writeU32(bytes, 76, 32);
+    writeU32(bytes, 80, 0x4);
+    memcpy(bytes.data() + 84, "ATI2", 4);
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    fclose(file);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    int textureCount = 8;
+    uint32_t size = 1024;
+    float budgetTextures = 2.5f;
+    size_t uploadKB = 256;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--textures") textureCount = std::max(2, atoi(argv[i + 1]));
+        else if (arg == "--size") size = (uint32_t)std::max(128, atoi(argv[i + 1]));
+        else if (arg == "--budget-textures") budgetTextures = std::max(1.0f, (float)atof(argv[i + 1]));
+        else if (arg == "--upload-kb") uploadKB = (size_t)std::max(1, atoi(argv[i + 1]));
+    }
+
+    if (!glfwInit())
+    {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        return 1;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "ge_bench_textures", nullptr, nullptr);
+    if (window == nullptr)
+    {
+        fprintf(stderr, "Failed to create GLFW window\n");
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        fprintf(stderr, "Failed to initialize GLAD\n");
+        return 1;
+    }
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+
+    std::error_code error;
+    std::filesystem::path directory = std::filesystem::temp_directory_path(error) / "ge_bench_textures";
+    std::filesystem::create_directories(directory, error);
+    std::vector<std::string> paths;
+    for (int i = 0; i < textureCount; ++i)
+    {
+        paths.push_back((directory / ("texture" + std::to_string(i) + ".dds")).string());
+        if (!writeDDS(paths.back(), size, (uint8_t)(i * 37)))
+        {
+            fprintf(stderr, "Failed to write %s\n", paths.back().c_str());
+            return 1;
+        }
+    }
+
+    // sizes of one texture's levels, its tail (never evicted) and everything above the tail
+    TextureFileInfo info;
+    ReadTextureFileInfo(paths[0], info);
+    TextureStreamer streamer;
+    uint32_t tailLevel = 0;
+    while (std::max(info.Mips[tailLevel].Width, info.Mips[tailLevel].Height) > streamer.TailSize)
+        ++tailLevel;
+    size_t tailBytes = 0, streamedBytes = 0;
+    for (uint32_t level = 0; level < info.Mips.size(); ++level)
+        (level < tailLevel ? streamedBytes : tailBytes) += info.Mips[level].Size;
+
+    JobSystem jobs;
+    jobs.Init();
+    streamer.Init(&jobs);
+    streamer.ResidentBudgetBytes = tailBytes * textureCount + (size_t)(streamedBytes * budgetTextures);
+    streamer.UploadBudgetBytes = uploadKB << 10;
+
+    size_t overCap = 0, overBudget = 0, maxUploaded = 0;
+    unsigned int maxUploads = 0;
+    double updateMs = 0.0, maxUpdateMs = 0.0;
+    int frames = 0;
+    auto frame = [&]() {
+        streamer.Update();
+        const TextureStreamingStats& stats = streamer.Stats;
+        if (stats.UploadedBytes > streamer.UploadBudgetBytes && stats.Uploads > 1)
+            overCap++;
+        if (stats.ResidentBytes > streamer.ResidentBudgetBytes)
+            overBudget++;
+        maxUploaded = std::max(maxUploaded, stats.UploadedBytes);
+        maxUploads = std::max(maxUploads, stats.Uploads);
+        updateMs += stats.UpdateMs;
+        maxUpdateMs = std::max(maxUpdateMs, stats.UpdateMs);
+        frames++;
+    };
+
+    std::vector<StreamedTexture> handles;
+    for (const std::string& path : paths)
+        handles.push_back(streamer.Load(path));
+    // the tails come in without any requests
+    int tailFrames = 0;
+    bool tailsResident = false;
+    while (!tailsResident && tailFrames++ < MAX_FRAMES_PER_TEXTURE)
+    {
+        frame();
+        tailsResident = streamer.Stats.Loading == 0;
+        for (StreamedTexture handle : handles)
+            tailsResident = tailsResident && streamer.GetTexture(handle) != 0;
+    }
+
+    printf("%d BC5 textures of %ux%u (%.0f KB above a %.1f KB tail), budget %.1f MB, upload cap %zu KB\n",
+           textureCount, size, size, streamedBytes / 1024.0, tailBytes / 1024.0,
+           streamer.ResidentBudgetBytes / (1024.0 * 1024.0), uploadKB);
+    printf("tails resident after %d frames\n", tailFrames);
+
+    // draw each texture in turn until it is sharp; older textures must lose their levels first
+    size_t orderErrors = 0;
+    for (int current = 0; current < textureCount; ++current)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        int sharpFrames = 0;
+        while (sharpFrames < MAX_FRAMES_PER_TEXTURE)
+        {
+            streamer.Request(handles[current], (float)size);
+            frame();
+            sharpFrames++;
+            if (streamer.GetResidentLevel(handles[current]) == 0 && streamer.Stats.Loading == 0)
+                break;
+        }
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // a texture drawn earlier than one that lost levels must be down to its tail
+        for (int newer = 1; newer < current; ++newer)
+        {
+            if (streamer.GetResidentLevel(handles[newer]) == 0)
+                continue;
+            for (int older = 0; older < newer; ++older)
+                orderErrors += streamer.GetResidentLevel(handles[older]) != tailLevel;
+        }
+        // never drawn, never sharpened
+        for (int later = current + 1; later < textureCount; ++later)
+            orderErrors += streamer.GetResidentLevel(handles[later]) != tailLevel;
+        bool sharp = streamer.GetResidentLevel(handles[current]) == 0;
+        orderErrors += !sharp;
+
+        printf("texture %d: %s after %d frames (%.1f ms), levels now", current, sharp ? "sharp" : "NOT sharp", sharpFrames, ms);
+        for (int t = 0; t <= current; ++t)
+            printf(" %u", streamer.GetResidentLevel(handles[t]));
+        printf("\n");
+    }
+
+    // everything at once, a quarter of the size: several loads finish together and share the cap
+    uint32_t quarterLevel = 2;
+    int quarterFrames = 0;
+    bool quarterSharp = false;
+    while (!quarterSharp && quarterFrames++ < MAX_FRAMES_PER_TEXTURE)
+    {
+        for (StreamedTexture handle : handles)
+            streamer.Request(handle, (float)(size / 4));
+        frame();
+        quarterSharp = streamer.Stats.Loading == 0;
+        for (StreamedTexture handle : handles)
+            quarterSharp = quarterSharp && streamer.GetResidentLevel(handle) <= quarterLevel;
+    }
+    orderErrors += !quarterSharp;
+    printf("all textures at %u pixels: %s after %d frames\n", size / 4, quarterSharp ? "sharp" : "NOT sharp", quarterFrames);
+
+    printf("%d frames, update average %.3f ms, max %.3f ms; largest upload %.0f KB in %u levels, %u evictions\n",
+           frames, updateMs / frames, maxUpdateMs, maxUploaded / 1024.0, maxUploads, streamer.Stats.Evictions);
+    printf("%zu frames over the upload cap, %zu over the resident budget, %zu eviction order errors\n",
+           overCap, overBudget, orderErrors);
+
+    streamer.Delete();
+    jobs.Delete();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    std::filesystem::remove_all(directory, error);
+    return overCap == 0 && overBudget == 0 && orderErrors == 0 && tailsResident ? 0 : 1;
+}
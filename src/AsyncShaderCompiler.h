@@ -0,0 +1,278 @@
+#ifndef ASYNC_SHADER_COMPILER_H
+#define ASYNC_SHADER_COMPILER_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GLExtensions.h"
+
+// A program built off the render path. On success Program is linked and owned by the receiver.
+struct CompiledProgram
+{
+    int Id = 0;
+    GLuint Program = 0;
+    bool Success = false;
+    std::string Log;
+};
+
+// Compiles and links programs without stalling the render loop. With KHR_parallel_shader_compile the
+// driver compiles on its own threads and completion is polled; otherwise a worker thread with a
+// context shared with the main window does the work and hands back the finished program.
+class AsyncShaderCompiler
+{
+public:
+    bool Init(GLFWwindow* mainWindow)
+    {
+        GLExtensions& extensions = GetGLExtensions();
+        if (extensions.ParallelShaderCompile)
+        {
+            // let the driver pick the thread count
+            extensions.MaxShaderCompilerThreads(0xFFFFFFFFu);
+            return true;
+        }
+
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        workerWindow = glfwCreateWindow(1, 1, "shader compiler", nullptr, mainWindow);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (workerWindow == nullptr)
+        {
+            std::cerr << "Failed to create shader compiler context, hot reload disabled" << std::endl;
+            return false;
+        }
+        running = true;
+        worker = std::thread(&AsyncShaderCompiler::workerLoop, this);
+        return true;
+    }
+
+    // must be called while the main context is still alive
+    void Delete()
+    {
+        if (worker.joinable())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                running = false;
+            }
+            wake.notify_one();
+            worker.join();
+        }
+        if (workerWindow)
+            glfwDestroyWindow(workerWindow);
+        workerWindow = nullptr;
+
+        for (Job& job : pending)
+            deleteJob(job);
+        pending.clear();
+        for (auto& entry : finishedSerials)
+            glDeleteProgram(entry.first.Program);
+        finishedSerials.clear();
+    }
+
+    bool IsParallel() const
+    {
+        return GetGLExtensions().ParallelShaderCompile;
+    }
+
+    // queues a build of the program identified by id; a newer request for the same id supersedes it
+    void Request(int id, const std::string& vertexSrc, const std::string& fragmentSrc)
+    {
+        Job job;
+        job.Id = id;
+        job.Serial = ++latest[id];
+        job.VertexSrc = vertexSrc;
+        job.FragmentSrc = fragmentSrc;
+
+        if (IsParallel())
+        {
+            // with the extension these calls return without waiting for the compiler
+            job.Vertex = startCompile(GL_VERTEX_SHADER, vertexSrc);
+            job.Fragment = startCompile(GL_FRAGMENT_SHADER, fragmentSrc);
+            job.Program = glCreateProgram();
+            glAttachShader(job.Program, job.Vertex);
+            glAttachShader(job.Program, job.Fragment);
+            glLinkProgram(job.Program);
+            pending.push_back(job);
+            return;
+        }
+
+        if (!worker.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(job);
+        }
+        wake.notify_one();
+    }
+
+    // programs that finished since the last call; never waits on the driver or the worker
+    std::vector<CompiledProgram> Poll()
+    {
+        std::vector<CompiledProgram> results;
+
+        if (IsParallel())
+        {
+            for (size_t i = 0; i < pending.size();)
+            {
+                Job& job = pending[i];
+                GLint done = GL_FALSE;
+                glGetProgramiv(job.Program, GL_COMPLETION_STATUS_KHR, &done);
+                if (!done)
+                {
+                    ++i;
+                    continue;
+                }
+                CompiledProgram result = finish(job);
+                deliver(results, result, job.Serial);
+                pending.erase(pending.begin() + i);
+            }
+            return results;
+        }
+
+        std::vector<std::pair<CompiledProgram, unsigned int>> done;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.swap(finishedSerials);
+        }
+        for (auto& entry : done)
+            deliver(results, entry.first, entry.second);
+        return results;
+    }
+
+private:
+    struct Job
+    {
+        int Id = 0;
+        unsigned int Serial = 0;
+        std::string VertexSrc;
+        std::string FragmentSrc;
+        GLuint Vertex = 0;
+        GLuint Fragment = 0;
+        GLuint Program = 0;
+    };
+
+    std::map<int, unsigned int> latest;
+    std::vector<Job> pending;
+
+    GLFWwindow* workerWindow = nullptr;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> queue;
+    std::vector<std::pair<CompiledProgram, unsigned int>> finishedSerials;
+    bool running = false;
+
+    static GLuint startCompile(GLenum type, const std::string& source)
+    {
+        GLuint shader = glCreateShader(type);
+        const char* src = source.c_str();
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+        return shader;
+    }
+
+    static void appendLog(std::string& log, GLuint object, bool program)
+    {
+        GLint length = 0;
+        if (program)
+            glGetProgramiv(object, GL_INFO_LOG_LENGTH, &length);
+        else
+            glGetShaderiv(object, GL_INFO_LOG_LENGTH, &length);
+        if (length <= 1)
+            return;
+        std::string info(length, '\0');
+        if (program)
+            glGetProgramInfoLog(object, length, nullptr, &info[0]);
+        else
+            glGetShaderInfoLog(object, length, nullptr, &info[0]);
+        log += info.c_str();
+    }
+
+    static void deleteJob(Job& job)
+    {
+        if (job.Vertex)
+            glDeleteShader(job.Vertex);
+        if (job.Fragment)
+            glDeleteShader(job.Fragment);
+        if (job.Program)
+            glDeleteProgram(job.Program);
+        job.Vertex = job.Fragment = job.Program = 0;
+    }
+
+    // reads the link status of a job whose compile has completed, frees the shader objects
+    static CompiledProgram finish(Job& job)
+    {
+        CompiledProgram result;
+        result.Id = job.Id;
+        result.Program = job.Program;
+
+        GLint linked = GL_FALSE;
+        glGetProgramiv(job.Program, GL_LINK_STATUS, &linked);
+        result.Success = linked == GL_TRUE;
+        if (!result.Success)
+        {
+            appendLog(result.Log, job.Vertex, false);
+            appendLog(result.Log, job.Fragment, false);
+            appendLog(result.Log, job.Program, true);
+            glDeleteProgram(job.Program);
+            result.Program = 0;
+        }
+
+        glDeleteShader(job.Vertex);
+        glDeleteShader(job.Fragment);
+        job.Vertex = job.Fragment = job.Program = 0;
+        return result;
+    }
+
+    // drops results that a newer request for the same program has already replaced
+    void deliver(std::vector<CompiledProgram>& results, CompiledProgram& result, unsigned int serial)
+    {
+        if (serial != latest[result.Id])
+        {
+            if (result.Program)
+                glDeleteProgram(result.Program);
+            return;
+        }
+        results.push_back(result);
+    }
+
+    void workerLoop()
+    {
+        glfwMakeContextCurrent(workerWindow);
+        for (;;)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return !running || !queue.empty(); });
+                if (!running)
+                    break;
+                job = queue.front();
+                queue.pop_front();
+            }
+
+            job.Vertex = startCompile(GL_VERTEX_SHADER, job.VertexSrc);
+            job.Fragment = startCompile(GL_FRAGMENT_SHADER, job.FragmentSrc);
+            job.Program = glCreateProgram();
+            glAttachShader(job.Program, job.Vertex);
+            glAttachShader(job.Program, job.Fragment);
+            glLinkProgram(job.Program);
+            CompiledProgram result = finish(job);
+            // the program must be complete before another context may use it
+            glFinish();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedSerials.push_back(std::make_pair(result, job.Serial));
+        }
+        glfwMakeContextCurrent(nullptr);
+    }
+};
+#endif
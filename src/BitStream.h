@@ -0,0 +1,134 @@
+#ifndef BIT_STREAM_H
+#define BIT_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bit-level packing for network messages. Bits are written least significant first into bytes,
+// so a stream is byte-identical on every platform.
+
+// number of bits needed to hold value, at least 1
+inline uint32_t BitsNeeded(uint32_t value)
+{
+    uint32_t bits = 1;
+    while (bits < 32 && (value >> bits) != 0)
+        bits++;
+    return bits;
+}
+
+// maps small negative and positive numbers to small unsigned ones: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+inline uint32_t ZigZag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+inline int32_t UnZigZag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+class BitWriter
+{
+public:
+    std::vector<uint8_t> Bytes;
+
+    void Reset()
+    {
+        Bytes.clear();
+        bitCount = 0;
+    }
+
+    void Write(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t written = 0; written < bits;)
+        {
+            uint32_t bit = bitCount & 7;
+            if (bit == 0)
+                Bytes.push_back(0);
+            uint32_t take = bits - written < 8 - bit ? bits - written : 8 - bit;
+            Bytes.back() |= (uint8_t)(((value >> written) & ((1u << take) - 1)) << bit);
+            written += take;
+            bitCount += take;
+        }
+    }
+
+    void WriteBool(bool value)
+    {
+        Write(value ? 1u : 0u, 1);
+    }
+
+    // 5-bit length, then the value: 6 bits for 0 or 1, 37 for the largest
+    void WriteVar(uint32_t value)
+    {
+        uint32_t bits = BitsNeeded(value);
+        Write(bits - 1, 5);
+        Write(value, bits);
+    }
+
+    void WriteSignedVar(int32_t value)
+    {
+        WriteVar(ZigZag(value));
+    }
+
+    size_t GetBitCount() const
+    {
+        return bitCount;
+    }
+
+private:
+    size_t bitCount = 0;
+};
+
+// Reads what a BitWriter wrote. Reading past the end yields zeros and sets Overflow, so a truncated
+// or hostile message can be rejected after decoding instead of checked at every read.
+class BitReader
+{
+public:
+    bool Overflow = false;
+
+    BitReader(const uint8_t* data, size_t size) : data(data), size(size)
+    {
+    }
+
+    uint32_t Read(uint32_t bits)
+    {
+        uint32_t value = 0;
+        for (uint32_t read = 0; read < bits;)
+        {
+            size_t byte = position >> 3;
+            if (byte >= size)
+            {
+                Overflow = true;
+                return 0;
+            }
+            uint32_t bit = (uint32_t)(position & 7);
+            uint32_t take = bits - read < 8 - bit ? bits - read : 8 - bit;
+            value |= (uint32_t)((data[byte] >> bit) & ((1u << take) - 1)) << read;
+            read += take;
+            position += take;
+        }
+        return value;
+    }
+
+    bool ReadBool()
+    {
+        return Read(1) != 0;
+    }
+
+    uint32_t ReadVar()
+    {
+        return Read(Read(5) + 1);
+    }
+
+    int32_t ReadSignedVar()
+    {
+        return UnZigZag(ReadVar());
+    }
+
+private:
+    const uint8_t* data;
+    size_t size;
+    size_t position = 0;
+};
+#endif
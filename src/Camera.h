@@ -21,6 +21,11 @@ const float PITCH       =  0.0f;
 const float SPEED       =  10.0f;
 const float SENSITIVITY =  0.1f;
 const float ZOOM        =  45.0f;
+const float NEAR_PLANE  =  0.1f;
+// the near plane moves out to this fraction of the height above the ground, up to MAX_NEAR_PLANE
+const float NEAR_PLANE_PER_HEIGHT = 0.1f;
+const float MAX_NEAR_PLANE = 10.0f;
+const float FAR_PLANE   =  100.0f;
 
 // An abstract camera class that processes input and calculates the corresponding Euler Angles, Vectors and Matrices for use in OpenGL
 class Camera
@@ -39,9 +44,12 @@ public:
     float MovementSpeed;
     float MouseSensitivity;
     float Zoom;
+    // clip planes used by the projection matrix
+    float NearPlane;
+    float FarPlane;
 
     // constructor with vectors
-    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), NearPlane(NEAR_PLANE), FarPlane(FAR_PLANE)
     {
         Position = position;
         WorldUp = up;
@@ -50,7 +58,7 @@ public:
         updateCameraVectors();
     }
     // constructor with scalar values
-    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM), NearPlane(NEAR_PLANE), FarPlane(FAR_PLANE)
     {
         Position = glm::vec3(posX, posY, posZ);
         WorldUp = glm::vec3(upX, upY, upZ);
@@ -65,6 +73,19 @@ public:
         return glm::lookAt(Position, Position + Front, Up);
     }
 
+    // returns the perspective projection for the given viewport aspect ratio (width / height)
+    glm::mat4 GetProjectionMatrix(float aspect)
+    {
+        return glm::perspective(glm::radians(Zoom), aspect, NearPlane, FarPlane);
+    }
+
+    // pushes the near plane out as the camera rises: nothing below it is closer than the ground, and
+    // with a far plane kilometres away a 0.1 near plane leaves distant terrain z-fighting
+    void FitNearPlane(float heightAboveGround)
+    {
+        NearPlane = glm::clamp(heightAboveGround * NEAR_PLANE_PER_HEIGHT, NEAR_PLANE, MAX_NEAR_PLANE);
+    }
+
     // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
     void ProcessKeyboard(Camera_Movement direction, float deltaTime)
     {
@@ -79,6 +100,20 @@ public:
             Position += Right * velocity;
     }
 
+    // same directions flattened onto the ground plane, for walking: looking up or down doesn't slow you
+    glm::vec3 GetWalkDirection(Camera_Movement direction) const
+    {
+        glm::vec3 forward = glm::normalize(glm::vec3(Front.x, 0.0f, Front.z));
+        glm::vec3 right = glm::normalize(glm::vec3(Right.x, 0.0f, Right.z));
+        if (direction == FORWARD)
+            return forward;
+        if (direction == BACKWARD)
+            return -forward;
+        if (direction == LEFT)
+            return -right;
+        return right;
+    }
+
     // processes input received from a mouse input system. Expects the offset value in both the x and y direction.
     void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true)
     {
@@ -0,0 +1,132 @@
+#ifndef CHARACTER_CONTROLLER_H
+#define CHARACTER_CONTROLLER_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "Collision.h"
+
+// one player's controls for one tick
+struct PlayerInput
+{
+    // horizontal walking velocity; y is ignored
+    glm::vec3 Move = glm::vec3(0.0f);
+    bool Jump = false;
+};
+
+// fastest a player walks; the client's controls stop here and the server slows commands down to it
+const float MAX_WALK_SPEED = 10.0f;
+
+// makes input from the wire safe to move with: false when the move isn't finite, otherwise a walk
+// faster than MAX_WALK_SPEED is slowed to it. Within a rounding error of the limit the move keeps its
+// exact bits, so a client that already stops there replays the very input the server applied
+inline bool LimitPlayerInput(PlayerInput& input)
+{
+    if (!std::isfinite(input.Move.x) || !std::isfinite(input.Move.z))
+        return false;
+    input.Move.y = 0.0f;
+    double length = std::sqrt((double)input.Move.x * input.Move.x + (double)input.Move.z * input.Move.z);
+    if (length > MAX_WALK_SPEED * 1.001)
+    {
+        input.Move.x = (float)(input.Move.x * (MAX_WALK_SPEED / length));
+        input.Move.z = (float)(input.Move.z * (MAX_WALK_SPEED / length));
+    }
+    return true;
+}
+
+// Upright capsule that walks, falls and jumps through a CollisionWorld. Position is the point
+// between the feet; the capsule's lower sphere rests on whatever is below it.
+class CharacterController
+{
+public:
+    float Radius = 0.35f;
+    float Height = 1.8f;
+    float EyeHeight = 1.6f;
+    float Gravity = 20.0f;
+    float JumpSpeed = 7.0f;
+    // contacts whose normal has at least this much y count as ground (about 45 degrees)
+    float MaxSlope = 0.7f;
+
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Velocity = glm::vec3(0.0f);
+    bool OnGround = false;
+
+    Capsule GetCapsule() const
+    {
+        Capsule capsule;
+        capsule.A = Position + glm::vec3(0.0f, Radius, 0.0f);
+        capsule.B = Position + glm::vec3(0.0f, Height - Radius, 0.0f);
+        capsule.Radius = Radius;
+        return capsule;
+    }
+
+    glm::vec3 GetEyePosition() const
+    {
+        return Position + glm::vec3(0.0f, EyeHeight, 0.0f);
+    }
+
+    void Move(const PlayerInput& input, float dt, const CollisionWorld& world)
+    {
+        Velocity.x = input.Move.x;
+        Velocity.z = input.Move.z;
+        if (input.Jump && OnGround)
+        {
+            Velocity.y = JumpSpeed;
+            OnGround = false;
+        }
+        Velocity.y -= Gravity * dt;
+
+        // substeps keep each move under half a radius so fast falls can't tunnel through thin boxes
+        float distance = glm::length(Velocity) * dt;
+        int steps = std::min(16, std::max(1, (int)std::ceil(distance / (Radius * 0.5f))));
+        float stepDt = dt / (float)steps;
+        bool wasOnGround = OnGround;
+        OnGround = false;
+        for (int step = 0; step < steps; ++step)
+        {
+            Position += Velocity * stepDt;
+            resolve(world);
+        }
+
+        // walking down a slope or off a step: stay glued instead of hopping along
+        if (wasOnGround && !OnGround && Velocity.y <= 0.0f)
+            snapToGround(world);
+    }
+
+private:
+    void resolve(const CollisionWorld& world)
+    {
+        for (int iteration = 0; iteration < 4; ++iteration)
+        {
+            glm::vec3 push(0.0f);
+            int contacts = world.ForEachContact(GetCapsule(), [&](const Contact& contact) {
+                push += contact.Normal * contact.Depth;
+                // drop the velocity into the surface, keep the rest so walls slide
+                float into = glm::dot(Velocity, contact.Normal);
+                if (into < 0.0f)
+                    Velocity -= contact.Normal * into;
+                if (contact.Normal.y >= MaxSlope)
+                    OnGround = true;
+            });
+            if (contacts == 0)
+                break;
+            Position += push;
+        }
+        // standing still on a slope shouldn't slide
+        if (OnGround && Velocity.y < 0.0f)
+            Velocity.y = 0.0f;
+    }
+
+    void snapToGround(const CollisionWorld& world)
+    {
+        const float SNAP_DISTANCE = 0.3f;
+        glm::vec3 start = Position;
+        Position.y -= SNAP_DISTANCE;
+        resolve(world);
+        if (!OnGround)
+            Position = start;
+    }
+};
+#endif
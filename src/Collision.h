@@ -0,0 +1,448 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Collision shapes, a uniform-grid broadphase and capsule narrowphase tests. GL-free like the
+// components, so the simulation can use it without a renderer.
+
+struct AABB
+{
+    glm::vec3 Min = glm::vec3(0.0f);
+    glm::vec3 Max = glm::vec3(0.0f);
+};
+
+inline bool Overlaps(const AABB& a, const AABB& b)
+{
+    return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x &&
+           a.Min.y <= b.Max.y && a.Max.y >= b.Min.y &&
+           a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+}
+
+// segment A-B swept by a sphere
+struct Capsule
+{
+    glm::vec3 A = glm::vec3(0.0f);
+    glm::vec3 B = glm::vec3(0.0f);
+    float Radius = 0.0f;
+
+    AABB GetBounds() const
+    {
+        AABB box;
+        box.Min = glm::min(A, B) - glm::vec3(Radius);
+        box.Max = glm::max(A, B) + glm::vec3(Radius);
+        return box;
+    }
+};
+
+// Normal points from the other shape towards the capsule; moving the capsule by Normal * Depth separates them
+struct Contact
+{
+    glm::vec3 Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    float Depth = 0.0f;
+};
+
+// height of the ground at a point; the context is whatever the function needs (e.g. the terrain)
+struct Heightfield
+{
+    const void* Context = nullptr;
+    float (*Height)(const void* context, float x, float z) = nullptr;
+
+    float GetHeight(float x, float z) const
+    {
+        return Height(Context, x, z);
+    }
+};
+
+inline glm::vec3 ClampToBox(const glm::vec3& p, const AABB& box)
+{
+    return glm::min(glm::max(p, box.Min), box.Max);
+}
+
+inline bool CapsuleVsAABB(const Capsule& capsule, const AABB& box, Contact& contact)
+{
+    // squared distance from the segment to the box is convex along the segment, so a golden-section
+    // search finds the closest point
+    glm::vec3 axis = capsule.B - capsule.A;
+    auto distance2 = [&](float t) {
+        glm::vec3 p = capsule.A + axis * t;
+        glm::vec3 d = p - ClampToBox(p, box);
+        return glm::dot(d, d);
+    };
+    const float INVERSE_PHI = 0.618034f;
+    float lo = 0.0f, hi = 1.0f;
+    float t1 = hi - (hi - lo) * INVERSE_PHI, t2 = lo + (hi - lo) * INVERSE_PHI;
+    float d1 = distance2(t1), d2 = distance2(t2);
+    for (int i = 0; i < 16; ++i)
+    {
+        if (d1 <= d2)
+        {
+            hi = t2;
+            t2 = t1;
+            d2 = d1;
+            t1 = hi - (hi - lo) * INVERSE_PHI;
+            d1 = distance2(t1);
+        }
+        else
+        {
+            lo = t1;
+            t1 = t2;
+            d1 = d2;
+            t2 = lo + (hi - lo) * INVERSE_PHI;
+            d2 = distance2(t2);
+        }
+    }
+    // the ends are candidates too, the search never evaluates them exactly
+    float t = (lo + hi) * 0.5f;
+    if (distance2(0.0f) < distance2(t)) t = 0.0f;
+    if (distance2(1.0f) < distance2(t)) t = 1.0f;
+
+    glm::vec3 p = capsule.A + axis * t;
+    glm::vec3 q = ClampToBox(p, box);
+    glm::vec3 d = p - q;
+    float dist2 = glm::dot(d, d);
+    if (dist2 > capsule.Radius * capsule.Radius)
+        return false;
+    if (dist2 > 1e-12f)
+    {
+        float dist = std::sqrt(dist2);
+        contact.Normal = d / dist;
+        contact.Depth = capsule.Radius - dist;
+        return true;
+    }
+
+    // the segment itself is inside: leave through the nearest face
+    float best = 1e30f;
+    for (int k = 0; k < 3; ++k)
+    {
+        float toMin = p[k] - box.Min[k], toMax = box.Max[k] - p[k];
+        if (toMin < best)
+        {
+            best = toMin;
+            contact.Normal = glm::vec3(0.0f);
+            contact.Normal[k] = -1.0f;
+        }
+        if (toMax < best)
+        {
+            best = toMax;
+            contact.Normal = glm::vec3(0.0f);
+            contact.Normal[k] = 1.0f;
+        }
+    }
+    contact.Depth = best + capsule.Radius;
+    return true;
+}
+
+// lower sphere of the capsule (at A) against the ground, treated as the local tangent plane
+inline bool CapsuleVsHeightfield(const Capsule& capsule, const Heightfield& ground, Contact& contact)
+{
+    const glm::vec3& center = capsule.A.y <= capsule.B.y ? capsule.A : capsule.B;
+    const float STEP = 0.25f;
+    float height = ground.GetHeight(center.x, center.z);
+    float dx = ground.GetHeight(center.x + STEP, center.z) - ground.GetHeight(center.x - STEP, center.z);
+    float dz = ground.GetHeight(center.x, center.z + STEP) - ground.GetHeight(center.x, center.z - STEP);
+    glm::vec3 normal = glm::normalize(glm::vec3(-dx, 2.0f * STEP, -dz));
+    float distance = (center.y - height) * normal.y;
+    if (distance >= capsule.Radius)
+        return false;
+    contact.Normal = normal;
+    contact.Depth = capsule.Radius - distance;
+    return true;
+}
+
+struct BroadphaseStats
+{
+    unsigned int Colliders = 0;
+    // collider-cell entries; colliders larger than a cell sit in several
+    unsigned int Entries = 0;
+    unsigned int Pairs = 0;
+    double BuildMs = 0.0;
+    double PairsMs = 0.0;
+};
+
+// Uniform grid over unbounded space: cells are hashed into a table that is rebuilt from scratch with
+// a counting sort every time, which for colliders that all move is cheaper than updating in place.
+// Cells should be about the size of a typical collider; bigger ones just occupy more cells.
+class BroadphaseGrid
+{
+public:
+    float CellSize = 2.0f;
+    // optional; cell ranges and the pair search then run on all worker threads
+    JobSystem* Jobs = nullptr;
+    BroadphaseStats Stats;
+
+    void Build(const AABB* boxes, uint32_t count)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        inverseCellSize = 1.0f / CellSize;
+        colliders.assign(boxes, boxes + count);
+
+        // cell range of every collider; the prefix sum of the entry counts places each collider's
+        // entries, so they can be written in parallel
+        ranges.resize(count);
+        firstEntry.resize(count + 1);
+        parallelFor(count, 4096, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                CellRange& range = ranges[i];
+                range.Min = cellOf(boxes[i].Min);
+                range.Max = cellOf(boxes[i].Max);
+                firstEntry[i + 1] = (uint32_t)(range.Max.x - range.Min.x + 1) * (range.Max.y - range.Min.y + 1) * (range.Max.z - range.Min.z + 1);
+            }
+        });
+        firstEntry[0] = 0;
+        for (uint32_t i = 0; i < count; ++i)
+            firstEntry[i + 1] += firstEntry[i];
+        uint32_t entryCount = firstEntry[count];
+
+        uint32_t bucketCount = 1;
+        while (bucketCount < entryCount)
+            bucketCount *= 2;
+        bucketMask = bucketCount - 1;
+
+        // hash every (cell, collider) entry once
+        keyed.resize(entryCount);
+        parallelFor(count, 4096, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                const CellRange& range = ranges[i];
+                KeyedEntry* out = &keyed[firstEntry[i]];
+                for (int z = range.Min.z; z <= range.Max.z; ++z)
+                    for (int y = range.Min.y; y <= range.Max.y; ++y)
+                        for (int x = range.Min.x; x <= range.Max.x; ++x)
+                        {
+                            out->Cell = packCell(x, y, z);
+                            out->Bucket = hashCell(out->Cell) & bucketMask;
+                            out->Collider = i;
+                            out++;
+                        }
+            }
+        });
+
+        // counting sort by bucket; entries carry their box so the pair search reads them in order
+        bucketStart.assign(bucketCount + 1, 0);
+        for (const KeyedEntry& entry : keyed)
+            bucketStart[entry.Bucket + 1]++;
+        for (uint32_t b = 0; b < bucketCount; ++b)
+            bucketStart[b + 1] += bucketStart[b];
+        entries.resize(entryCount);
+        fill.assign(bucketStart.begin(), bucketStart.end() - 1);
+        for (const KeyedEntry& entry : keyed)
+        {
+            Entry& sorted = entries[fill[entry.Bucket]++];
+            sorted.Box = colliders[entry.Collider];
+            sorted.Cell = entry.Cell;
+            sorted.Collider = entry.Collider;
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.Colliders = count;
+        Stats.Entries = entryCount;
+        Stats.BuildMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // indices of the colliders overlapping the box, each once
+    void Query(const AABB& box, std::vector<uint32_t>& out) const
+    {
+        out.clear();
+        if (entries.empty())
+            return;
+        glm::ivec3 lo = cellOf(box.Min), hi = cellOf(box.Max);
+        for (int z = lo.z; z <= hi.z; ++z)
+            for (int y = lo.y; y <= hi.y; ++y)
+                for (int x = lo.x; x <= hi.x; ++x)
+                {
+                    uint64_t key = packCell(x, y, z);
+                    uint32_t bucket = hashCell(key) & bucketMask;
+                    for (uint32_t e = bucketStart[bucket]; e < bucketStart[bucket + 1]; ++e)
+                    {
+                        if (entries[e].Cell == key && Overlaps(entries[e].Box, box))
+                            out.push_back(entries[e].Collider);
+                    }
+                }
+        // a collider spanning several of the cells was found in each
+        if (lo != hi)
+        {
+            std::sort(out.begin(), out.end());
+            out.erase(std::unique(out.begin(), out.end()), out.end());
+        }
+    }
+
+    // every overlapping pair once, lower index first. A pair sharing several cells is reported only
+    // by the cell holding the min corner of the two boxes' overlap.
+    void FindPairs(std::vector<std::pair<uint32_t, uint32_t>>& out)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        out.clear();
+        // buckets are split into slices with a pair list each, concatenated in order afterwards
+        uint32_t bucketCount = entries.empty() ? 0 : bucketMask + 1;
+        uint32_t slices = Jobs && Jobs->GetThreadCount() > 1 ? std::min(bucketCount, Jobs->GetThreadCount() * 8) : 1;
+        slicePairs.resize(slices);
+        parallelFor(slices, 1, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t slice = begin; slice < end; ++slice)
+            {
+                uint32_t first = (uint32_t)((uint64_t)bucketCount * slice / slices);
+                uint32_t last = (uint32_t)((uint64_t)bucketCount * (slice + 1) / slices);
+                findPairs(first, last, slicePairs[slice]);
+            }
+        });
+        for (const auto& pairs : slicePairs)
+            out.insert(out.end(), pairs.begin(), pairs.end());
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.Pairs = (unsigned int)out.size();
+        Stats.PairsMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    const AABB& GetCollider(uint32_t index) const
+    {
+        return colliders[index];
+    }
+
+    uint32_t GetColliderCount() const
+    {
+        return (uint32_t)colliders.size();
+    }
+
+private:
+    struct CellRange
+    {
+        glm::ivec3 Min;
+        glm::ivec3 Max;
+    };
+
+    struct KeyedEntry
+    {
+        uint64_t Cell;
+        uint32_t Bucket;
+        uint32_t Collider;
+    };
+
+    struct Entry
+    {
+        AABB Box;
+        uint32_t Collider;
+        uint64_t Cell;
+    };
+
+    float inverseCellSize = 0.5f;
+    std::vector<AABB> colliders;
+    std::vector<CellRange> ranges;
+    std::vector<uint32_t> firstEntry;
+    std::vector<KeyedEntry> keyed;
+    std::vector<Entry> entries;
+    std::vector<uint32_t> bucketStart;
+    std::vector<uint32_t> fill;
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> slicePairs;
+    uint32_t bucketMask = 0;
+
+    // truncation plus a fix-up for negatives is much cheaper than std::floor
+    static int floorToInt(float value)
+    {
+        int i = (int)value;
+        return i - (value < (float)i ? 1 : 0);
+    }
+
+    glm::ivec3 cellOf(const glm::vec3& p) const
+    {
+        return glm::ivec3(floorToInt(p.x * inverseCellSize), floorToInt(p.y * inverseCellSize), floorToInt(p.z * inverseCellSize));
+    }
+
+    // 21 bits per axis, enough for +-1M cells
+    static uint64_t packCell(int x, int y, int z)
+    {
+        const uint64_t MASK = (1u << 21) - 1;
+        return ((uint64_t)(uint32_t)x & MASK) | (((uint64_t)(uint32_t)y & MASK) << 21) | (((uint64_t)(uint32_t)z & MASK) << 42);
+    }
+
+    static uint32_t hashCell(uint64_t key)
+    {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return (uint32_t)key;
+    }
+
+    template <typename F>
+    void parallelFor(uint32_t count, uint32_t minChunk, F&& body)
+    {
+        if (Jobs)
+            Jobs->ParallelFor(count, body, minChunk);
+        else
+            body(0u, count);
+    }
+
+    void findPairs(uint32_t firstBucket, uint32_t lastBucket, std::vector<std::pair<uint32_t, uint32_t>>& out) const
+    {
+        out.clear();
+        for (uint32_t b = firstBucket; b < lastBucket; ++b)
+        {
+            uint32_t first = bucketStart[b], last = bucketStart[b + 1];
+            for (uint32_t i = first; i + 1 < last; ++i)
+            {
+                const Entry& a = entries[i];
+                for (uint32_t j = i + 1; j < last; ++j)
+                {
+                    const Entry& e = entries[j];
+                    if (e.Cell != a.Cell || !Overlaps(a.Box, e.Box))
+                        continue;
+                    glm::ivec3 owner = cellOf(glm::max(a.Box.Min, e.Box.Min));
+                    if (packCell(owner.x, owner.y, owner.z) != a.Cell)
+                        continue;
+                    out.push_back(std::make_pair(std::min(a.Collider, e.Collider), std::max(a.Collider, e.Collider)));
+                }
+            }
+        }
+    }
+};
+
+// Everything a character collides with: boxes in the broadphase plus optional ground
+class CollisionWorld
+{
+public:
+    BroadphaseGrid Broadphase;
+    // filled by the owner, then Rebuild()
+    std::vector<AABB> Colliders;
+    Heightfield Ground;
+
+    void Rebuild()
+    {
+        Broadphase.Build(Colliders.data(), (uint32_t)Colliders.size());
+    }
+
+    // deepest contacts first is not needed for a capsule pushing itself out a few times per step,
+    // so contacts are visited in broadphase order
+    template <typename F>
+    int ForEachContact(const Capsule& capsule, F&& visit) const
+    {
+        int count = 0;
+        Contact contact;
+        if (Ground.Height && CapsuleVsHeightfield(capsule, Ground, contact))
+        {
+            visit(contact);
+            count++;
+        }
+        Broadphase.Query(capsule.GetBounds(), candidates);
+        for (uint32_t collider : candidates)
+        {
+            if (CapsuleVsAABB(capsule, Broadphase.GetCollider(collider), contact))
+            {
+                visit(contact);
+                count++;
+            }
+        }
+        return count;
+    }
+
+private:
+    mutable std::vector<uint32_t> candidates;
+};
+#endif
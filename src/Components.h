@@ -0,0 +1,97 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstdint>
+
+#include "ECS.h"
+
+// Components are plain data and GL-free so the simulation can run without a renderer
+
+struct Transform
+{
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::quat Rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 Scale = glm::vec3(1.0f);
+
+    // translate * rotate * scale written out directly, without the three intermediate matrices
+    glm::mat4 ToMatrix() const
+    {
+        const glm::quat& q = Rotation;
+        float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+        float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+        float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+        glm::mat4 m;
+        m[0] = glm::vec4((1.0f - 2.0f * (yy + zz)) * Scale.x, 2.0f * (xy + wz) * Scale.x, 2.0f * (xz - wy) * Scale.x, 0.0f);
+        m[1] = glm::vec4(2.0f * (xy - wz) * Scale.y, (1.0f - 2.0f * (xx + zz)) * Scale.y, 2.0f * (yz + wx) * Scale.y, 0.0f);
+        m[2] = glm::vec4(2.0f * (xz + wy) * Scale.z, 2.0f * (yz - wx) * Scale.z, (1.0f - 2.0f * (xx + yy)) * Scale.z, 0.0f);
+        m[3] = glm::vec4(Position, 1.0f);
+        return m;
+    }
+};
+
+// the Transform one simulation step earlier, so rendering can blend between the last two steps
+struct PreviousTransform
+{
+    Transform Value;
+};
+
+// position and scale blended linearly, rotation along the shorter arc
+inline Transform InterpolateTransform(const Transform& from, const Transform& to, float alpha)
+{
+    Transform result;
+    result.Position = glm::mix(from.Position, to.Position, alpha);
+    result.Rotation = glm::slerp(from.Rotation, to.Rotation, alpha);
+    result.Scale = glm::mix(from.Scale, to.Scale, alpha);
+    return result;
+}
+
+struct Velocity
+{
+    glm::vec3 Linear = glm::vec3(0.0f);
+};
+
+// What to draw for an entity: indices into the scene's mesh table and the render queue's materials
+struct MeshRenderer
+{
+    uint32_t MeshId = 0;
+    uint32_t Material = 0;
+};
+
+// Handle to a node of a TransformHierarchy. The generation changes when the node is destroyed, so a
+// stale handle is caught instead of silently reaching whatever node reuses the slot.
+struct TransformNode
+{
+    uint32_t Index = 0xFFFFFFFFu;
+    uint32_t Generation = 0;
+
+    bool operator==(const TransformNode& other) const { return Index == other.Index && Generation == other.Generation; }
+    bool operator!=(const TransformNode& other) const { return !(*this == other); }
+};
+
+const TransformNode INVALID_TRANSFORM_NODE = TransformNode();
+
+// Entity placed by a node of the scene's TransformHierarchy instead of its own Transform
+struct HierarchyNode
+{
+    TransformNode Node;
+};
+
+// Entity whose Transform is sent to network clients; Kind tells them what it is (and what to draw)
+struct Replicated
+{
+    uint32_t Kind = 0;
+};
+
+// moves every entity with a velocity; runs once per simulation tick
+inline void IntegrateVelocities(World& world, float tickSeconds)
+{
+    world.EachChunk<Transform, const Velocity>([tickSeconds](uint32_t count, const Entity*, Transform* transforms, const Velocity* velocities) {
+        for (uint32_t i = 0; i < count; ++i)
+            transforms[i].Position += velocities[i].Linear * tickSeconds;
+    });
+}
+#endif
@@ -0,0 +1,312 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Frustum.h"
+
+// Pick the widest SIMD path the compiler is allowed to emit. AVX2 needs GE_ENABLE_AVX2 in CMake,
+// SSE2 is always available on x86-64, everything else falls back to scalar code.
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GE_CULL_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GE_CULL_SSE2 1
+#endif
+
+// Culling counters for the last frame, shown in the Debug Info window
+struct CullStats
+{
+    unsigned int Tested = 0;
+    unsigned int Visible = 0;
+    double CullMs = 0.0;
+
+    void Reset()
+    {
+        Tested = 0;
+        Visible = 0;
+        CullMs = 0.0;
+    }
+};
+
+inline CullStats& GetCullStats()
+{
+    static CullStats stats;
+    return stats;
+}
+
+// Bounding spheres in structure-of-arrays form, so SIMD lanes load 4/8 objects at a time
+struct SphereBoundsSoA
+{
+    std::vector<float> X, Y, Z, Radius;
+
+    void Clear()
+    {
+        X.clear(); Y.clear(); Z.clear(); Radius.clear();
+    }
+
+    void Add(const glm::vec3& center, float radius)
+    {
+        X.push_back(center.x); Y.push_back(center.y); Z.push_back(center.z); Radius.push_back(radius);
+    }
+
+    void Set(size_t index, const glm::vec3& center, float radius)
+    {
+        X[index] = center.x; Y[index] = center.y; Z[index] = center.z; Radius[index] = radius;
+    }
+
+    void Resize(size_t count)
+    {
+        X.resize(count); Y.resize(count); Z.resize(count); Radius.resize(count);
+    }
+
+    size_t Size() const { return X.size(); }
+};
+
+// Axis-aligned boxes as center + half extents in structure-of-arrays form
+struct AABBBoundsSoA
+{
+    std::vector<float> CenterX, CenterY, CenterZ;
+    std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+    void Clear()
+    {
+        CenterX.clear(); CenterY.clear(); CenterZ.clear();
+        ExtentX.clear(); ExtentY.clear(); ExtentZ.clear();
+    }
+
+    void Add(const glm::vec3& min, const glm::vec3& max)
+    {
+        glm::vec3 center = (min + max) * 0.5f;
+        glm::vec3 extents = (max - min) * 0.5f;
+        CenterX.push_back(center.x); CenterY.push_back(center.y); CenterZ.push_back(center.z);
+        ExtentX.push_back(extents.x); ExtentY.push_back(extents.y); ExtentZ.push_back(extents.z);
+    }
+
+    size_t Size() const { return CenterX.size(); }
+};
+
+// writes base + i for every set bit i of the lane mask. Branch-free: every lane is stored and the
+// cursor only advances past the visible ones, so random visibility patterns cost no mispredictions.
+template<int Lanes>
+inline uint32_t* AppendVisible(uint32_t mask, uint32_t base, uint32_t* out)
+{
+    for (int lane = 0; lane < Lanes; ++lane)
+    {
+        *out = base + lane;
+        out += (mask >> lane) & 1u;
+    }
+    return out;
+}
+
+#if defined(GE_CULL_AVX2)
+// a * b + c, fused when the compiler may emit FMA; AVX2 alone doesn't guarantee it
+inline __m256 CullMultiplyAdd(__m256 a, __m256 b, __m256 c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// For every 8-bit lane mask, the permutation that packs the set lanes to the front
+struct CompactionTable
+{
+    alignas(32) uint32_t Lanes[256][8];
+    uint32_t Counts[256];
+
+    CompactionTable()
+    {
+        for (uint32_t mask = 0; mask < 256; ++mask)
+        {
+            uint32_t count = 0;
+            for (uint32_t lane = 0; lane < 8; ++lane)
+            {
+                if (mask & (1u << lane))
+                    Lanes[mask][count++] = lane;
+            }
+            for (uint32_t fill = count; fill < 8; ++fill)
+                Lanes[mask][fill] = 0;
+            Counts[mask] = count;
+        }
+    }
+};
+
+inline const CompactionTable& GetCompactionTable()
+{
+    static const CompactionTable table;
+    return table;
+}
+
+// 8-wide version: one permute and one unaligned store per group instead of eight scalar stores.
+// The store always writes 8 lanes, so the output needs 8 slots of slack past the last visible index.
+inline uint32_t* AppendVisible8(const CompactionTable& table, uint32_t mask, __m256i base, uint32_t* out)
+{
+    __m256i permutation = _mm256_load_si256((const __m256i*)table.Lanes[mask]);
+    __m256i indices = _mm256_add_epi32(base, permutation);
+    _mm256_storeu_si256((__m256i*)out, indices);
+    return out + table.Counts[mask];
+}
+#endif
+
+// Writes the indices of all spheres touching the frustum to visible (grown as needed, never shrunk)
+// and returns how many there are
+inline size_t CullSpheres(const Frustum& frustum, const SphereBoundsSoA& bounds, std::vector<uint32_t>& visible)
+{
+    const size_t count = bounds.Size();
+    // 8 slots of slack for the full-width stores of the AVX2 compaction
+    if (visible.size() < count + 8)
+        visible.resize(count + 8);
+
+    const float* xs = bounds.X.data();
+    const float* ys = bounds.Y.data();
+    const float* zs = bounds.Z.data();
+    const float* rs = bounds.Radius.data();
+    uint32_t* out = visible.data();
+    size_t i = 0;
+
+#if defined(GE_CULL_AVX2)
+    __m256 nx[6], ny[6], nz[6], d[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        nx[p] = _mm256_set1_ps(frustum.Planes[p].Normal.x);
+        ny[p] = _mm256_set1_ps(frustum.Planes[p].Normal.y);
+        nz[p] = _mm256_set1_ps(frustum.Planes[p].Normal.z);
+        d[p]  = _mm256_set1_ps(frustum.Planes[p].D);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+    const CompactionTable& table = GetCompactionTable();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 x = _mm256_loadu_ps(xs + i);
+        __m256 y = _mm256_loadu_ps(ys + i);
+        __m256 z = _mm256_loadu_ps(zs + i);
+        __m256 negRadius = _mm256_sub_ps(zero, _mm256_loadu_ps(rs + i));
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            __m256 dist = CullMultiplyAdd(x, nx[p], CullMultiplyAdd(y, ny[p], CullMultiplyAdd(z, nz[p], d[p])));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, negRadius, _CMP_GE_OQ));
+        }
+        out = AppendVisible8(table, (uint32_t)_mm256_movemask_ps(inside), _mm256_set1_epi32((int)i), out);
+    }
+#elif defined(GE_CULL_SSE2)
+    __m128 nx[6], ny[6], nz[6], d[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        nx[p] = _mm_set1_ps(frustum.Planes[p].Normal.x);
+        ny[p] = _mm_set1_ps(frustum.Planes[p].Normal.y);
+        nz[p] = _mm_set1_ps(frustum.Planes[p].Normal.z);
+        d[p]  = _mm_set1_ps(frustum.Planes[p].D);
+    }
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(xs + i);
+        __m128 y = _mm_loadu_ps(ys + i);
+        __m128 z = _mm_loadu_ps(zs + i);
+        __m128 negRadius = _mm_sub_ps(zero, _mm_loadu_ps(rs + i));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, nx[p]), _mm_mul_ps(y, ny[p])), _mm_add_ps(_mm_mul_ps(z, nz[p]), d[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(dist, negRadius));
+        }
+        out = AppendVisible<4>((uint32_t)_mm_movemask_ps(inside), (uint32_t)i, out);
+    }
+#endif
+
+    // scalar tail (or the whole range without SIMD)
+    for (; i < count; ++i)
+    {
+        if (frustum.IntersectsSphere(glm::vec3(xs[i], ys[i], zs[i]), rs[i]))
+            *out++ = (uint32_t)i;
+    }
+
+    return (size_t)(out - visible.data());
+}
+
+// Same as CullSpheres for boxes; the box is projected onto each plane normal to get its radius
+inline size_t CullAABBs(const Frustum& frustum, const AABBBoundsSoA& bounds, std::vector<uint32_t>& visible)
+{
+    const size_t count = bounds.Size();
+    // 8 slots of slack for the full-width stores of the AVX2 compaction
+    if (visible.size() < count + 8)
+        visible.resize(count + 8);
+
+    const float* cxs = bounds.CenterX.data();
+    const float* cys = bounds.CenterY.data();
+    const float* czs = bounds.CenterZ.data();
+    const float* exs = bounds.ExtentX.data();
+    const float* eys = bounds.ExtentY.data();
+    const float* ezs = bounds.ExtentZ.data();
+    uint32_t* out = visible.data();
+    size_t i = 0;
+
+#if defined(GE_CULL_AVX2)
+    __m256 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        const Plane& plane = frustum.Planes[p];
+        nx[p] = _mm256_set1_ps(plane.Normal.x); ax[p] = _mm256_set1_ps(std::fabs(plane.Normal.x));
+        ny[p] = _mm256_set1_ps(plane.Normal.y); ay[p] = _mm256_set1_ps(std::fabs(plane.Normal.y));
+        nz[p] = _mm256_set1_ps(plane.Normal.z); az[p] = _mm256_set1_ps(std::fabs(plane.Normal.z));
+        d[p]  = _mm256_set1_ps(plane.D);
+    }
+    const CompactionTable& table = GetCompactionTable();
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(cxs + i), cy = _mm256_loadu_ps(cys + i), cz = _mm256_loadu_ps(czs + i);
+        __m256 ex = _mm256_loadu_ps(exs + i), ey = _mm256_loadu_ps(eys + i), ez = _mm256_loadu_ps(ezs + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            __m256 dist = CullMultiplyAdd(cx, nx[p], CullMultiplyAdd(cy, ny[p], CullMultiplyAdd(cz, nz[p], d[p])));
+            __m256 radius = CullMultiplyAdd(ex, ax[p], CullMultiplyAdd(ey, ay[p], _mm256_mul_ps(ez, az[p])));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(dist, radius), _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        out = AppendVisible8(table, (uint32_t)_mm256_movemask_ps(inside), _mm256_set1_epi32((int)i), out);
+    }
+#elif defined(GE_CULL_SSE2)
+    __m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+    for (int p = 0; p < 6; ++p)
+    {
+        const Plane& plane = frustum.Planes[p];
+        nx[p] = _mm_set1_ps(plane.Normal.x); ax[p] = _mm_set1_ps(std::fabs(plane.Normal.x));
+        ny[p] = _mm_set1_ps(plane.Normal.y); ay[p] = _mm_set1_ps(std::fabs(plane.Normal.y));
+        nz[p] = _mm_set1_ps(plane.Normal.z); az[p] = _mm_set1_ps(std::fabs(plane.Normal.z));
+        d[p]  = _mm_set1_ps(plane.D);
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(cxs + i), cy = _mm_loadu_ps(cys + i), cz = _mm_loadu_ps(czs + i);
+        __m128 ex = _mm_loadu_ps(exs + i), ey = _mm_loadu_ps(eys + i), ez = _mm_loadu_ps(ezs + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx[p]), _mm_mul_ps(cy, ny[p])), _mm_add_ps(_mm_mul_ps(cz, nz[p]), d[p]));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ax[p]), _mm_mul_ps(ey, ay[p])), _mm_mul_ps(ez, az[p]));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+        out = AppendVisible<4>((uint32_t)_mm_movemask_ps(inside), (uint32_t)i, out);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        glm::vec3 center(cxs[i], cys[i], czs[i]);
+        glm::vec3 extents(exs[i], eys[i], ezs[i]);
+        if (frustum.IntersectsAABB(center - extents, center + extents))
+            *out++ = (uint32_t)i;
+    }
+
+    return (size_t)(out - visible.data());
+}
+#endif
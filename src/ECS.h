@@ -0,0 +1,445 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Archetype ECS. Entities with the same set of components share an archetype, which stores them in
+// fixed-size chunks; inside a chunk every component type has its own contiguous array (SoA), so a
+// query walks tightly packed arrays of exactly the components it asked for.
+
+typedef uint64_t ComponentMask;
+const uint32_t MAX_COMPONENT_TYPES = 64;
+const size_t ECS_CHUNK_BYTES = 16 * 1024;
+
+struct Entity
+{
+    uint32_t Index = 0xFFFFFFFFu;
+    uint32_t Generation = 0;
+
+    bool operator==(const Entity& other) const { return Index == other.Index && Generation == other.Generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+const Entity INVALID_ENTITY = Entity();
+
+struct ComponentTypeInfo
+{
+    size_t Size;
+    size_t Align;
+};
+
+inline std::vector<ComponentTypeInfo>& GetComponentTypes()
+{
+    static std::vector<ComponentTypeInfo> types;
+    return types;
+}
+
+// ids are handed out on first use, in whatever order the component types are first touched
+template <typename T>
+struct ComponentType
+{
+    static_assert(std::is_trivially_copyable<T>::value, "components are moved between chunks with memcpy");
+    static_assert(alignof(T) <= 16, "chunk columns are 16-byte aligned");
+
+    static uint32_t Id()
+    {
+        static const uint32_t id = [] {
+            std::vector<ComponentTypeInfo>& types = GetComponentTypes();
+            assert(types.size() < MAX_COMPONENT_TYPES);
+            types.push_back({ sizeof(T), alignof(T) });
+            return (uint32_t)types.size() - 1;
+        }();
+        return id;
+    }
+};
+
+// const-qualified types (read-only query columns) share the id of the plain type
+template <typename T>
+uint32_t GetComponentId()
+{
+    return ComponentType<typename std::remove_cv<T>::type>::Id();
+}
+
+template <typename... Ts>
+ComponentMask MakeComponentMask()
+{
+    ComponentMask mask = 0;
+    using expand = int[];
+    (void)expand{ 0, ((mask |= ComponentMask(1) << GetComponentId<Ts>()), 0)... };
+    return mask;
+}
+
+// Fixed-size block holding up to the archetype's ChunkCapacity entities
+struct EntityChunk
+{
+    std::unique_ptr<unsigned char[]> Data;
+    uint32_t Count = 0;
+};
+
+// All entities with one particular set of components
+class Archetype
+{
+public:
+    ComponentMask Mask = 0;
+    std::vector<uint32_t> Components;   // component ids, ascending
+    std::vector<size_t> ColumnOffsets;  // byte offset of each component's array inside a chunk
+    size_t EntityOffset = 0;            // the entity ids live in the first array
+    uint32_t ChunkCapacity = 0;
+    std::vector<EntityChunk> Chunks;
+    size_t EntityCount = 0;
+
+    // archetype reached by adding/removing one component, filled in lazily by World
+    uint32_t AddEdge[MAX_COMPONENT_TYPES];
+    uint32_t RemoveEdge[MAX_COMPONENT_TYPES];
+
+    explicit Archetype(ComponentMask mask) : Mask(mask)
+    {
+        for (uint32_t id = 0; id < MAX_COMPONENT_TYPES; ++id)
+        {
+            slots[id] = -1;
+            AddEdge[id] = RemoveEdge[id] = 0xFFFFFFFFu;
+            if (mask & (ComponentMask(1) << id))
+            {
+                slots[id] = (int)Components.size();
+                Components.push_back(id);
+            }
+        }
+
+        // largest capacity whose aligned columns still fit the chunk
+        const std::vector<ComponentTypeInfo>& types = GetComponentTypes();
+        size_t rowBytes = sizeof(Entity);
+        for (uint32_t id : Components)
+            rowBytes += types[id].Size;
+        ChunkCapacity = (uint32_t)(ECS_CHUNK_BYTES / rowBytes);
+        while (ChunkCapacity > 1 && layout(ChunkCapacity) > ECS_CHUNK_BYTES)
+            ChunkCapacity--;
+        layout(ChunkCapacity);
+    }
+
+    int GetSlot(uint32_t componentId) const
+    {
+        return slots[componentId];
+    }
+
+    void* GetColumn(EntityChunk& chunk, int slot) const
+    {
+        return chunk.Data.get() + ColumnOffsets[slot];
+    }
+
+    Entity* GetEntities(EntityChunk& chunk) const
+    {
+        return (Entity*)(chunk.Data.get() + EntityOffset);
+    }
+
+private:
+    int slots[MAX_COMPONENT_TYPES];
+
+    // computes column offsets for a capacity, returns the bytes needed
+    size_t layout(uint32_t capacity)
+    {
+        const std::vector<ComponentTypeInfo>& types = GetComponentTypes();
+        size_t offset = 0;
+        EntityOffset = 0;
+        offset += sizeof(Entity) * capacity;
+        ColumnOffsets.resize(Components.size());
+        for (size_t slot = 0; slot < Components.size(); ++slot)
+        {
+            const ComponentTypeInfo& type = types[Components[slot]];
+            offset = (offset + 15) & ~size_t(15);
+            ColumnOffsets[slot] = offset;
+            offset += type.Size * capacity;
+        }
+        return offset;
+    }
+};
+
+// Owns every entity and archetype. Adding or removing a component moves the entity to the matching
+// archetype; removal from an archetype swaps the last entity into the hole, so both are O(1).
+class World
+{
+public:
+    World()
+    {
+        // archetype 0 holds entities without components
+        archetypes.push_back(std::unique_ptr<Archetype>(new Archetype(0)));
+        archetypeByMask[0] = 0;
+    }
+
+    Entity Create()
+    {
+        Entity entity;
+        if (!freeList.empty())
+        {
+            entity.Index = freeList.back();
+            freeList.pop_back();
+        }
+        else
+        {
+            entity.Index = (uint32_t)records.size();
+            records.push_back(EntityRecord());
+        }
+        EntityRecord& record = records[entity.Index];
+        entity.Generation = record.Generation;
+        insert(entity, 0);
+        return entity;
+    }
+
+    void Destroy(Entity entity)
+    {
+        if (!IsAlive(entity))
+            return;
+        EntityRecord& record = records[entity.Index];
+        removeRow(record.Archetype, record.Chunk, record.Row);
+        record.Generation++;
+        record.Archetype = 0xFFFFFFFFu;
+        freeList.push_back(entity.Index);
+    }
+
+    bool IsAlive(Entity entity) const
+    {
+        return entity.Index < records.size() && records[entity.Index].Generation == entity.Generation &&
+               records[entity.Index].Archetype != 0xFFFFFFFFu;
+    }
+
+    size_t GetEntityCount() const
+    {
+        return records.size() - freeList.size();
+    }
+
+    size_t GetArchetypeCount() const
+    {
+        return archetypes.size();
+    }
+
+    template <typename T>
+    T& Add(Entity entity, const T& value = T())
+    {
+        assert(IsAlive(entity));
+        uint32_t id = GetComponentId<T>();
+        EntityRecord& record = records[entity.Index];
+        if (!(archetypes[record.Archetype]->Mask & (ComponentMask(1) << id)))
+            move(entity, addEdge(record.Archetype, id));
+        T* component = Get<T>(entity);
+        *component = value;
+        return *component;
+    }
+
+    template <typename T>
+    void Remove(Entity entity)
+    {
+        if (!Has<T>(entity))
+            return;
+        move(entity, removeEdge(records[entity.Index].Archetype, GetComponentId<T>()));
+    }
+
+    template <typename T>
+    bool Has(Entity entity) const
+    {
+        return IsAlive(entity) && (archetypes[records[entity.Index].Archetype]->Mask & (ComponentMask(1) << GetComponentId<T>()));
+    }
+
+    // nullptr when the entity is gone or lacks the component; valid until the next structural change
+    template <typename T>
+    T* Get(Entity entity)
+    {
+        if (!IsAlive(entity))
+            return nullptr;
+        const EntityRecord& record = records[entity.Index];
+        Archetype& archetype = *archetypes[record.Archetype];
+        int slot = archetype.GetSlot(GetComponentId<T>());
+        if (slot < 0)
+            return nullptr;
+        return (T*)archetype.GetColumn(archetype.Chunks[record.Chunk], slot) + record.Row;
+    }
+
+    // calls f(count, entities, Ts*...) once per chunk that has all of Ts, with pointers to the
+    // chunk's arrays. Components must not be added or removed inside the callback.
+    template <typename... Ts, typename F>
+    void EachChunk(F&& f)
+    {
+        ComponentMask mask = MakeComponentMask<Ts...>();
+        for (std::unique_ptr<Archetype>& archetype : archetypes)
+        {
+            if ((archetype->Mask & mask) != mask)
+                continue;
+            for (EntityChunk& chunk : archetype->Chunks)
+            {
+                if (chunk.Count > 0)
+                    f(chunk.Count, (const Entity*)archetype->GetEntities(chunk),
+                      (Ts*)archetype->GetColumn(chunk, archetype->GetSlot(GetComponentId<Ts>()))...);
+            }
+        }
+    }
+
+    // calls f(entity, Ts&...) for every entity that has all of Ts
+    template <typename... Ts, typename F>
+    void Each(F&& f)
+    {
+        EachChunk<Ts...>([&](uint32_t count, const Entity* entities, Ts*... columns) {
+            for (uint32_t i = 0; i < count; ++i)
+                f(entities[i], columns[i]...);
+        });
+    }
+
+    // EachChunk with chunks spread over the job system's threads
+    template <typename... Ts, typename F>
+    void EachChunkParallel(JobSystem& jobs, F&& f)
+    {
+        ComponentMask mask = MakeComponentMask<Ts...>();
+        matchedChunks.clear();
+        for (std::unique_ptr<Archetype>& archetype : archetypes)
+        {
+            if ((archetype->Mask & mask) != mask)
+                continue;
+            for (EntityChunk& chunk : archetype->Chunks)
+            {
+                if (chunk.Count > 0)
+                    matchedChunks.push_back(std::make_pair(archetype.get(), &chunk));
+            }
+        }
+
+        jobs.ParallelFor((uint32_t)matchedChunks.size(), [&](uint32_t begin, uint32_t end) {
+            for (uint32_t c = begin; c < end; ++c)
+            {
+                Archetype* archetype = matchedChunks[c].first;
+                EntityChunk& chunk = *matchedChunks[c].second;
+                f(chunk.Count, (const Entity*)archetype->GetEntities(chunk),
+                  (Ts*)archetype->GetColumn(chunk, archetype->GetSlot(GetComponentId<Ts>()))...);
+            }
+        }, 4);
+    }
+
+private:
+    struct EntityRecord
+    {
+        uint32_t Archetype = 0xFFFFFFFFu;
+        uint32_t Chunk = 0;
+        uint32_t Row = 0;
+        uint32_t Generation = 0;
+    };
+
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, uint32_t> archetypeByMask;
+    std::vector<EntityRecord> records;
+    std::vector<uint32_t> freeList;
+    std::vector<std::pair<Archetype*, EntityChunk*>> matchedChunks;
+
+    uint32_t findOrCreate(ComponentMask mask)
+    {
+        auto found = archetypeByMask.find(mask);
+        if (found != archetypeByMask.end())
+            return found->second;
+        uint32_t index = (uint32_t)archetypes.size();
+        archetypes.push_back(std::unique_ptr<Archetype>(new Archetype(mask)));
+        archetypeByMask[mask] = index;
+        return index;
+    }
+
+    uint32_t addEdge(uint32_t from, uint32_t componentId)
+    {
+        uint32_t& edge = archetypes[from]->AddEdge[componentId];
+        if (edge == 0xFFFFFFFFu)
+        {
+            uint32_t to = findOrCreate(archetypes[from]->Mask | (ComponentMask(1) << componentId));
+            archetypes[from]->AddEdge[componentId] = to;
+            archetypes[to]->RemoveEdge[componentId] = from;
+        }
+        return archetypes[from]->AddEdge[componentId];
+    }
+
+    uint32_t removeEdge(uint32_t from, uint32_t componentId)
+    {
+        uint32_t& edge = archetypes[from]->RemoveEdge[componentId];
+        if (edge == 0xFFFFFFFFu)
+        {
+            uint32_t to = findOrCreate(archetypes[from]->Mask & ~(ComponentMask(1) << componentId));
+            archetypes[from]->RemoveEdge[componentId] = to;
+            archetypes[to]->AddEdge[componentId] = from;
+        }
+        return archetypes[from]->RemoveEdge[componentId];
+    }
+
+    // appends the entity to the archetype's last chunk; its components are left uninitialized
+    void insert(Entity entity, uint32_t archetypeIndex)
+    {
+        Archetype& archetype = *archetypes[archetypeIndex];
+        if (archetype.Chunks.empty() || archetype.Chunks.back().Count == archetype.ChunkCapacity)
+        {
+            archetype.Chunks.push_back(EntityChunk());
+            archetype.Chunks.back().Data.reset(new unsigned char[ECS_CHUNK_BYTES]);
+        }
+        EntityChunk& chunk = archetype.Chunks.back();
+        uint32_t row = chunk.Count++;
+        archetype.GetEntities(chunk)[row] = entity;
+        archetype.EntityCount++;
+
+        EntityRecord& record = records[entity.Index];
+        record.Archetype = archetypeIndex;
+        record.Chunk = (uint32_t)archetype.Chunks.size() - 1;
+        record.Row = row;
+    }
+
+    // fills the hole with the archetype's last entity
+    void removeRow(uint32_t archetypeIndex, uint32_t chunkIndex, uint32_t row)
+    {
+        Archetype& archetype = *archetypes[archetypeIndex];
+        EntityChunk& chunk = archetype.Chunks[chunkIndex];
+        EntityChunk& last = archetype.Chunks.back();
+        uint32_t lastRow = last.Count - 1;
+
+        if (&chunk != &last || row != lastRow)
+        {
+            const std::vector<ComponentTypeInfo>& types = GetComponentTypes();
+            for (size_t slot = 0; slot < archetype.Components.size(); ++slot)
+            {
+                size_t size = types[archetype.Components[slot]].Size;
+                memcpy((unsigned char*)archetype.GetColumn(chunk, (int)slot) + row * size,
+                       (unsigned char*)archetype.GetColumn(last, (int)slot) + lastRow * size, size);
+            }
+            Entity moved = archetype.GetEntities(last)[lastRow];
+            archetype.GetEntities(chunk)[row] = moved;
+            records[moved.Index].Chunk = chunkIndex;
+            records[moved.Index].Row = row;
+        }
+
+        last.Count--;
+        archetype.EntityCount--;
+        if (last.Count == 0)
+            archetype.Chunks.pop_back();
+    }
+
+    // moves the entity to another archetype, keeping the components both have
+    void move(Entity entity, uint32_t targetIndex)
+    {
+        EntityRecord source = records[entity.Index];
+        insert(entity, targetIndex);
+
+        Archetype& from = *archetypes[source.Archetype];
+        Archetype& to = *archetypes[targetIndex];
+        const EntityRecord& target = records[entity.Index];
+        const std::vector<ComponentTypeInfo>& types = GetComponentTypes();
+        for (size_t slot = 0; slot < to.Components.size(); ++slot)
+        {
+            uint32_t id = to.Components[slot];
+            int fromSlot = from.GetSlot(id);
+            size_t size = types[id].Size;
+            unsigned char* destination = (unsigned char*)to.GetColumn(to.Chunks[target.Chunk], (int)slot) + target.Row * size;
+            if (fromSlot >= 0)
+                memcpy(destination, (unsigned char*)from.GetColumn(from.Chunks[source.Chunk], fromSlot) + source.Row * size, size);
+            else
+                memset(destination, 0, size);
+        }
+
+        removeRow(source.Archetype, source.Chunk, source.Row);
+    }
+};
+#endif
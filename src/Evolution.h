@@ -0,0 +1,350 @@
+#ifndef EVOLUTION_H
+#define EVOLUTION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "JobSystem.h"
+
+// Evolving creature populations. Genomes, phenotypes and state live in structure-of-arrays pools,
+// one array per gene, trait and state field, so every pass streams just the columns it needs. A
+// generation expresses and scores every genome, then breeds the next one: tournament selection,
+// uniform crossover and mutation. Both passes run on all worker threads in fixed blocks of
+// creatures, each block with its own random stream seeded from the generation and the block index,
+// so a run gives the same creatures with any number of threads.
+
+const uint32_t GENE_COUNT = 16;
+static_assert(GENE_COUNT <= 32, "crossover picks each gene's parent from one bit of a 32-bit mask");
+// creatures per job and per random stream
+const uint32_t EVOLUTION_BLOCK = 4096;
+
+// PCG32: 8 bytes of state, fast, and streams seeded apart don't correlate
+struct EvolutionRandom
+{
+    uint64_t State = 0;
+    uint64_t Increment = 1;
+
+    static EvolutionRandom ForStream(uint64_t seed, uint64_t stream)
+    {
+        EvolutionRandom random;
+        random.Increment = (stream << 1) | 1u;
+        random.Next();
+        random.State += seed;
+        random.Next();
+        return random;
+    }
+
+    uint32_t Next()
+    {
+        uint64_t old = State;
+        State = old * 6364136223846793005ull + Increment;
+        uint32_t shifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rotation = (uint32_t)(old >> 59);
+        return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+    }
+
+    // [0, 1)
+    float NextFloat()
+    {
+        return (float)(Next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // [0, range), without a division
+    uint32_t NextBelow(uint32_t range)
+    {
+        return (uint32_t)(((uint64_t)Next() * range) >> 32);
+    }
+
+    // roughly normal with mean 0 and deviation 1: four uniforms summed, bounded at about 3.5
+    float NextNormal()
+    {
+        return (NextFloat() + NextFloat() + NextFloat() + NextFloat() - 2.0f) * 1.7320508f;
+    }
+};
+
+// every creature of a generation, one array per field
+struct Population
+{
+    uint32_t Count = 0;
+    // genome: Genes[g][i] is gene g of creature i, in [-GENE_LIMIT, GENE_LIMIT]
+    std::vector<float> Genes[GENE_COUNT];
+    // phenotype, expressed from the genome
+    std::vector<float> Size;
+    std::vector<float> Speed;
+    std::vector<float> Sense;
+    std::vector<float> Metabolism;
+    // state after living one lifetime
+    std::vector<float> Energy;
+    std::vector<float> Fitness;
+
+    void Resize(uint32_t count)
+    {
+        Count = count;
+        for (std::vector<float>& gene : Genes)
+            gene.resize(count);
+        Size.resize(count);
+        Speed.resize(count);
+        Sense.resize(count);
+        Metabolism.resize(count);
+        Energy.resize(count);
+        Fitness.resize(count);
+    }
+};
+
+struct EvolutionSettings
+{
+    uint64_t Seed = 1;
+    // parents are the fittest of this many creatures drawn at random
+    uint32_t TournamentSize = 4;
+    // parents come from a window of this many slots around the child's; overlapping local
+    // populations keep the gathers in cache and the population diverse. 0 draws from everyone.
+    uint32_t DemeSize = 4096;
+    float CrossoverRate = 0.9f;
+    // chance for each gene to mutate, and the deviation of a mutation
+    float MutationRate = 0.02f;
+    float MutationScale = 0.2f;
+    // how much food the environment offers
+    float FoodDensity = 1.0f;
+};
+
+struct EvolutionStats
+{
+    uint32_t Generation = 0;
+    // of the generation last evaluated
+    float BestFitness = 0.0f;
+    float MeanFitness = 0.0f;
+    double EvaluateMs = 0.0;
+    double BreedMs = 0.0;
+    double GenerationMs = 0.0;
+};
+
+class Evolution
+{
+public:
+    static constexpr float GENE_LIMIT = 4.0f;
+
+    EvolutionSettings Settings;
+    // optional; both passes then run on all worker threads
+    JobSystem* Jobs = nullptr;
+    Population Creatures;
+    EvolutionStats Stats;
+
+    // a population of random genomes
+    void Init(uint32_t count)
+    {
+        Creatures.Resize(count);
+        next.Resize(count);
+        Stats = EvolutionStats();
+        forEachBlock([&](uint32_t block, uint32_t begin, uint32_t end) {
+            // generation 0's streams, see breed()
+            EvolutionRandom random = EvolutionRandom::ForStream(Settings.Seed, block);
+            for (uint32_t g = 0; g < GENE_COUNT; ++g)
+                for (uint32_t i = begin; i < end; ++i)
+                    Creatures.Genes[g][i] = random.NextFloat() * 2.0f - 1.0f;
+        });
+        initExpression();
+    }
+
+    // lives and scores the current generation, then replaces it with its offspring
+    void Step()
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        Evaluate();
+        auto evaluated = std::chrono::high_resolution_clock::now();
+        breed();
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.Generation++;
+        Stats.EvaluateMs = std::chrono::duration<double, std::milli>(evaluated - start).count();
+        Stats.BreedMs = std::chrono::duration<double, std::milli>(end - evaluated).count();
+        Stats.GenerationMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    // expresses every genome into its phenotype and scores one lifetime in the environment
+    void Evaluate()
+    {
+        uint32_t blocks = getBlockCount();
+        blockBest.assign(blocks, 0.0f);
+        blockSum.assign(blocks, 0.0);
+        forEachBlock([&](uint32_t block, uint32_t begin, uint32_t end) {
+            express(begin, end);
+            live(begin, end);
+            const float* fitness = Creatures.Fitness.data();
+            float best = 0.0f;
+            double sum = 0.0;
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                best = std::max(best, fitness[i]);
+                sum += fitness[i];
+            }
+            blockBest[block] = best;
+            blockSum[block] = sum;
+        });
+        // summed in block order so the mean doesn't depend on the thread count either
+        float best = 0.0f;
+        double sum = 0.0;
+        for (uint32_t block = 0; block < blocks; ++block)
+        {
+            best = std::max(best, blockBest[block]);
+            sum += blockSum[block];
+        }
+        Stats.BestFitness = best;
+        Stats.MeanFitness = Creatures.Count ? (float)(sum / Creatures.Count) : 0.0f;
+    }
+
+private:
+    static const uint32_t TRAIT_COUNT = 4;
+
+    // the generation being bred, swapped in when done
+    Population next;
+    // developmental map: how strongly each gene pushes each trait
+    float expression[TRAIT_COUNT][GENE_COUNT];
+    std::vector<float> blockBest;
+    std::vector<double> blockSum;
+
+    uint32_t getBlockCount() const
+    {
+        return (Creatures.Count + EVOLUTION_BLOCK - 1) / EVOLUTION_BLOCK;
+    }
+
+    // body(block, begin, end) for every block of creatures; blocks never depend on the thread count
+    template <typename F>
+    void forEachBlock(F&& body)
+    {
+        uint32_t count = Creatures.Count;
+        auto run = [&](uint32_t first, uint32_t last) {
+            for (uint32_t block = first; block < last; ++block)
+                body(block, block * EVOLUTION_BLOCK, std::min(count, (block + 1) * EVOLUTION_BLOCK));
+        };
+        if (Jobs)
+            Jobs->ParallelFor(getBlockCount(), run, 1);
+        else
+            run(0, getBlockCount());
+    }
+
+    void initExpression()
+    {
+        // fixed for all runs: part of the species, not of the seed
+        EvolutionRandom random = EvolutionRandom::ForStream(0x5eed, 0);
+        for (uint32_t t = 0; t < TRAIT_COUNT; ++t)
+            for (uint32_t g = 0; g < GENE_COUNT; ++g)
+                expression[t][g] = (random.NextFloat() - 0.5f) * 0.8f;
+    }
+
+    // gene-major: each trait accumulates one gene column at a time, which vectorizes
+    void express(uint32_t begin, uint32_t end)
+    {
+        std::vector<float>* traits[TRAIT_COUNT] = { &Creatures.Size, &Creatures.Speed, &Creatures.Sense, &Creatures.Metabolism };
+        // each trait's range
+        const float LOW[TRAIT_COUNT] = { 0.5f, 0.5f, 1.0f, 0.2f };
+        const float HIGH[TRAIT_COUNT] = { 2.0f, 5.0f, 20.0f, 2.0f };
+        for (uint32_t t = 0; t < TRAIT_COUNT; ++t)
+        {
+            float* trait = traits[t]->data();
+            std::fill(trait + begin, trait + end, 0.0f);
+            for (uint32_t g = 0; g < GENE_COUNT; ++g)
+            {
+                const float* gene = Creatures.Genes[g].data();
+                float weight = expression[t][g];
+                for (uint32_t i = begin; i < end; ++i)
+                    trait[i] += weight * gene[i];
+            }
+            // squashed into the trait's range
+            float low = LOW[t], span = HIGH[t] - LOW[t];
+            for (uint32_t i = begin; i < end; ++i)
+                trait[i] = low + span * (0.5f + 0.5f * trait[i] / (1.0f + std::fabs(trait[i])));
+        }
+    }
+
+    // food found grows with speed, senses and size; the upkeep of a big, fast body grows faster.
+    // Metabolism trades efficiency against cost. The best creatures sit somewhere in between.
+    void live(uint32_t begin, uint32_t end)
+    {
+        const float* size = Creatures.Size.data();
+        const float* speed = Creatures.Speed.data();
+        const float* sense = Creatures.Sense.data();
+        const float* metabolism = Creatures.Metabolism.data();
+        float* energy = Creatures.Energy.data();
+        float* fitness = Creatures.Fitness.data();
+        float food = Settings.FoodDensity;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            float found = food * speed[i] * sense[i] * std::sqrt(size[i] * metabolism[i]);
+            float upkeep = metabolism[i] * (0.1f * size[i] * size[i] * size[i] * speed[i] * speed[i] + 0.02f * sense[i] * sense[i]) + 0.5f;
+            energy[i] = found - upkeep;
+            fitness[i] = std::max(0.0f, energy[i]);
+        }
+    }
+
+    uint32_t tournament(EvolutionRandom& random, const float* fitness, uint32_t windowStart, uint32_t windowSize) const
+    {
+        uint32_t best = windowStart + random.NextBelow(windowSize);
+        for (uint32_t round = 1; round < Settings.TournamentSize; ++round)
+        {
+            uint32_t other = windowStart + random.NextBelow(windowSize);
+            if (fitness[other] > fitness[best])
+                best = other;
+        }
+        return best;
+    }
+
+    void breed()
+    {
+        uint32_t count = Creatures.Count;
+        uint32_t deme = Settings.DemeSize == 0 ? count : std::min(Settings.DemeSize, count);
+        uint32_t generation = Stats.Generation + 1;
+        // mutations are rare, so instead of rolling for every gene the gap to the next one is drawn
+        float skipScale = Settings.MutationRate >= 1.0f ? 0.0f : 1.0f / std::log(1.0f - std::max(Settings.MutationRate, 1e-9f));
+        forEachBlock([&](uint32_t block, uint32_t begin, uint32_t end) {
+            // one stream per (generation, block): seed + generation would replay the next seed's streams
+            EvolutionRandom random = EvolutionRandom::ForStream(Settings.Seed, ((uint64_t)generation << 32) | block);
+            uint32_t size = end - begin;
+            // pick both parents of every child in the block first
+            uint32_t mothers[EVOLUTION_BLOCK], fathers[EVOLUTION_BLOCK], masks[EVOLUTION_BLOCK];
+            const float* fitness = Creatures.Fitness.data();
+            for (uint32_t c = 0; c < size; ++c)
+            {
+                // the window is centred on the child's slot, shifted to stay inside the population
+                uint32_t i = begin + c;
+                uint32_t windowStart = std::min(count - deme, i > deme / 2 ? i - deme / 2 : 0u);
+                mothers[c] = tournament(random, fitness, windowStart, deme);
+                fathers[c] = tournament(random, fitness, windowStart, deme);
+                // a bit per gene picks the parent it comes from
+                masks[c] = random.NextFloat() < Settings.CrossoverRate ? random.Next() : 0xFFFFFFFFu;
+            }
+            // then copy one gene column at a time
+            for (uint32_t g = 0; g < GENE_COUNT; ++g)
+            {
+                const float* gene = Creatures.Genes[g].data();
+                float* child = next.Genes[g].data() + begin;
+                for (uint32_t c = 0; c < size; ++c)
+                {
+                    // branchless: the mask bits are coin flips, which a branch would mispredict half the time
+                    uint32_t pick = 0u - ((masks[c] >> g) & 1u);
+                    child[c] = gene[fathers[c] ^ ((mothers[c] ^ fathers[c]) & pick)];
+                }
+            }
+            // and mutate: slot s is gene s / size of child s % size
+            uint64_t slots = (uint64_t)size * GENE_COUNT;
+            for (uint64_t slot = skip(random, skipScale); slot < slots; slot += 1 + skip(random, skipScale))
+            {
+                float& gene = next.Genes[slot / size][begin + slot % size];
+                gene = std::min(GENE_LIMIT, std::max(-GENE_LIMIT, gene + random.NextNormal() * Settings.MutationScale));
+            }
+        });
+        for (uint32_t g = 0; g < GENE_COUNT; ++g)
+            Creatures.Genes[g].swap(next.Genes[g]);
+    }
+
+    // genes passed over before the next mutation: geometric with the mutation rate
+    static uint64_t skip(EvolutionRandom& random, float scale)
+    {
+        if (scale == 0.0f)
+            return 0;
+        float gap = std::log(1.0f - random.NextFloat()) * scale;
+        return gap < 1e18f ? (uint64_t)gap : UINT64_MAX / 2;
+    }
+};
+#endif
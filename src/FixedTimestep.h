@@ -0,0 +1,79 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+#include <glm/glm.hpp>
+
+// Turns variable frame times into a whole number of fixed simulation ticks. The leftover time is
+// kept for the next frame and exposed as Alpha, the render-side blend factor between the last two
+// simulation states.
+class FixedTimestep
+{
+public:
+    float TickRate = 60.0f;       // ticks per second
+    int MaxTicksPerFrame = 8;     // after a long stall, drop time instead of trying to catch up forever
+    unsigned long long Tick = 0;  // ticks run since start
+    int TicksThisFrame = 0;
+    unsigned int DroppedTicks = 0;
+
+    float GetTickSeconds() const
+    {
+        return 1.0f / TickRate;
+    }
+
+    // adds one frame's worth of time; returns how many ticks to run before rendering
+    int Advance(double frameSeconds)
+    {
+        double tick = GetTickSeconds();
+        accumulator += frameSeconds;
+        TicksThisFrame = (int)(accumulator / tick);
+        if (TicksThisFrame > MaxTicksPerFrame)
+        {
+            DroppedTicks += TicksThisFrame - MaxTicksPerFrame;
+            accumulator -= (TicksThisFrame - MaxTicksPerFrame) * tick;
+            TicksThisFrame = MaxTicksPerFrame;
+        }
+        accumulator -= TicksThisFrame * tick;
+        Tick += TicksThisFrame;
+        return TicksThisFrame;
+    }
+
+    // how far the render time is between the previous and the current tick, in [0, 1)
+    float GetAlpha() const
+    {
+        return (float)(accumulator / GetTickSeconds());
+    }
+
+    // simulation time to render at: the current tick plus the interpolated part of the next one
+    double GetRenderTime() const
+    {
+        return (Tick + GetAlpha() - 1.0) * GetTickSeconds();
+    }
+
+private:
+    double accumulator = 0.0;
+};
+
+// The last two simulation states of a value, so rendering can blend between them
+template <typename T>
+struct Interpolated
+{
+    T Previous = T();
+    T Current = T();
+
+    void Reset(const T& value)
+    {
+        Previous = Current = value;
+    }
+
+    // call at the start of every tick, before the simulation changes Current
+    void BeginTick()
+    {
+        Previous = Current;
+    }
+
+    T Get(float alpha) const
+    {
+        return glm::mix(Previous, Current, alpha);
+    }
+};
+#endif
@@ -0,0 +1,134 @@
+#ifndef FRAME_CONSTANTS_H
+#define FRAME_CONSTANTS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstring>
+
+#include "Camera.h"
+#include "Shader.h"
+
+// Per-frame values shared by every program through the FrameConstants uniform block.
+// Member order and padding follow std140, see the matching block in the shaders.
+struct FrameConstants
+{
+    glm::mat4 View;
+    glm::mat4 Projection;
+    glm::mat4 ViewProj;
+    glm::vec4 CameraPosition; // w unused
+    glm::vec2 ViewportSize;
+    float Time;
+    float DeltaTime;
+};
+
+static_assert(sizeof(FrameConstants) == 224, "FrameConstants must match the std140 layout of the GLSL block");
+
+// Builds this frame's constants from the camera and the current framebuffer size
+inline FrameConstants MakeFrameConstants(Camera& camera, int width, int height, float time, float deltaTime)
+{
+    FrameConstants constants;
+    float aspect = height > 0 ? (float)width / (float)height : 1.0f;
+    constants.View = camera.GetViewMatrix();
+    constants.Projection = camera.GetProjectionMatrix(aspect);
+    constants.ViewProj = constants.Projection * constants.View;
+    constants.CameraPosition = glm::vec4(camera.Position, 1.0f);
+    constants.ViewportSize = glm::vec2((float)width, (float)height);
+    constants.Time = time;
+    constants.DeltaTime = deltaTime;
+    return constants;
+}
+
+// Ring of uniform buffers holding FrameConstants. Each buffer is fenced after the frame that used it,
+// so the CPU only ever writes a buffer the GPU has finished reading.
+class FrameConstantsBuffer
+{
+public:
+    static const int RING_SIZE = 3;
+
+    // number of times a write had to wait on the GPU, should stay at 0 with a deep enough ring
+    unsigned int Stalls = 0;
+
+    void Init()
+    {
+        glGenBuffers(RING_SIZE, buffers);
+        for (int i = 0; i < RING_SIZE; ++i)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffers[i]);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameConstants), nullptr, GL_DYNAMIC_DRAW);
+            fences[i] = nullptr;
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    void Delete()
+    {
+        for (int i = 0; i < RING_SIZE; ++i)
+        {
+            if (fences[i])
+                glDeleteSync(fences[i]);
+            fences[i] = nullptr;
+        }
+        glDeleteBuffers(RING_SIZE, buffers);
+    }
+
+    // writes the next buffer in the ring and binds it to FRAME_CONSTANTS_BINDING
+    void Update(const FrameConstants& constants)
+    {
+        current = (current + 1) % RING_SIZE;
+        waitForFence(current);
+
+        glBindBuffer(GL_UNIFORM_BUFFER, buffers[current]);
+        // the fence guarantees the GPU is done with this buffer, so skip the driver's own synchronization
+        void* dst = glMapBufferRange(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants),
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (dst)
+        {
+            std::memcpy(dst, &constants, sizeof(FrameConstants));
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+        }
+        else
+        {
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameConstants), &constants);
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_CONSTANTS_BINDING, buffers[current]);
+    }
+
+    // call once all draws reading this frame's constants have been issued
+    void EndFrame()
+    {
+        if (fences[current])
+            glDeleteSync(fences[current]);
+        fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+private:
+    GLuint buffers[RING_SIZE] = {};
+    GLsync fences[RING_SIZE] = {};
+    int current = 0;
+
+    void waitForFence(int index)
+    {
+        if (!fences[index])
+            return;
+
+        GLenum result = glClientWaitSync(fences[index], 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED)
+        {
+            Stalls++;
+            // flush on the first blocking wait so the fence is guaranteed to eventually signal
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            do
+            {
+                result = glClientWaitSync(fences[index], flags, 1000000); // 1 ms
+                flags = 0;
+            } while (result == GL_TIMEOUT_EXPIRED);
+        }
+
+        glDeleteSync(fences[index]);
+        fences[index] = nullptr;
+    }
+};
+#endif
@@ -0,0 +1,79 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+// Plane in the form dot(Normal, p) + D = 0, with the normal pointing into the frustum
+struct Plane
+{
+    glm::vec3 Normal;
+    float D;
+
+    float Distance(const glm::vec3& point) const
+    {
+        return glm::dot(Normal, point) + D;
+    }
+};
+
+// View frustum as six inward-facing planes: left, right, bottom, top, near, far
+class Frustum
+{
+public:
+    Plane Planes[6];
+
+    // extracts the planes from a view-projection matrix (Gribb/Hartmann). Planes are normalized so
+    // distances are in world units and sphere radii can be compared against them directly.
+    static Frustum FromMatrix(const glm::mat4& viewProj)
+    {
+        // glm is column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+        glm::vec4 rows[4];
+        for (int i = 0; i < 4; ++i)
+            rows[i] = glm::vec4(viewProj[0][i], viewProj[1][i], viewProj[2][i], viewProj[3][i]);
+
+        const glm::vec4 planes[6] = {
+            rows[3] + rows[0], // left
+            rows[3] - rows[0], // right
+            rows[3] + rows[1], // bottom
+            rows[3] - rows[1], // top
+            rows[3] + rows[2], // near
+            rows[3] - rows[2], // far
+        };
+
+        Frustum frustum;
+        for (int i = 0; i < 6; ++i)
+        {
+            glm::vec3 normal(planes[i].x, planes[i].y, planes[i].z);
+            float length = glm::length(normal);
+            frustum.Planes[i].Normal = normal / length;
+            frustum.Planes[i].D = planes[i].w / length;
+        }
+        return frustum;
+    }
+
+    bool IntersectsSphere(const glm::vec3& center, float radius) const
+    {
+        for (const Plane& plane : Planes)
+        {
+            if (plane.Distance(center) < -radius)
+                return false;
+        }
+        return true;
+    }
+
+    // conservative box test: only rejects boxes fully outside one of the planes
+    bool IntersectsAABB(const glm::vec3& min, const glm::vec3& max) const
+    {
+        glm::vec3 center = (min + max) * 0.5f;
+        glm::vec3 extents = (max - min) * 0.5f;
+        for (const Plane& plane : Planes)
+        {
+            float radius = extents.x * std::fabs(plane.Normal.x) + extents.y * std::fabs(plane.Normal.y) + extents.z * std::fabs(plane.Normal.z);
+            if (plane.Distance(center) < -radius)
+                return false;
+        }
+        return true;
+    }
+};
+#endif
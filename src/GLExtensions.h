@@ -0,0 +1,116 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// glad is generated for plain 3.3 core, so optional extensions are detected and loaded here
+
+// KHR/ARB_parallel_shader_compile share their enum values
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// ARB_get_program_binary (core in 4.1)
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+// block-compressed texture formats: S3TC (BC1/BC3) is an extension everywhere, BPTC (BC7) is core
+// in 4.2, RGTC (BC5) is core in 3.0
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT 0x8C4D
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
+typedef void (APIENTRYP PFNGEMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+typedef void (APIENTRYP PFNGEGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGEPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGEPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+struct GLExtensions
+{
+    // compiles and links return immediately; completion is polled with GL_COMPLETION_STATUS_KHR
+    bool ParallelShaderCompile = false;
+    PFNGEMAXSHADERCOMPILERTHREADSPROC MaxShaderCompilerThreads = nullptr;
+
+    // linked programs can be saved and restored; false as well when the driver offers no binary formats
+    bool ProgramBinary = false;
+    PFNGEGETPROGRAMBINARYPROC GetProgramBinary = nullptr;
+    PFNGEPROGRAMBINARYPROC ProgramBinaryLoad = nullptr;
+    PFNGEPROGRAMPARAMETERIPROC ProgramParameteri = nullptr;
+
+    // BC1/BC3 and BC7 textures can be uploaded; BC5 always can
+    bool TextureS3TC = false;
+    bool TextureBPTC = false;
+};
+
+inline GLExtensions& GetGLExtensions()
+{
+    static GLExtensions extensions;
+    return extensions;
+}
+
+inline bool HasGLExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// call once after gladLoadGLLoader, with the same loader
+inline void LoadGLExtensions(GLADloadproc load)
+{
+    GLExtensions& extensions = GetGLExtensions();
+
+    if (HasGLExtension("GL_KHR_parallel_shader_compile"))
+        extensions.MaxShaderCompilerThreads = (PFNGEMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsKHR");
+    else if (HasGLExtension("GL_ARB_parallel_shader_compile"))
+        extensions.MaxShaderCompilerThreads = (PFNGEMAXSHADERCOMPILERTHREADSPROC)load("glMaxShaderCompilerThreadsARB");
+    extensions.ParallelShaderCompile = extensions.MaxShaderCompilerThreads != nullptr;
+
+    if (HasGLExtension("GL_ARB_get_program_binary"))
+    {
+        extensions.GetProgramBinary = (PFNGEGETPROGRAMBINARYPROC)load("glGetProgramBinary");
+        extensions.ProgramBinaryLoad = (PFNGEPROGRAMBINARYPROC)load("glProgramBinary");
+        extensions.ProgramParameteri = (PFNGEPROGRAMPARAMETERIPROC)load("glProgramParameteri");
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        extensions.ProgramBinary = extensions.GetProgramBinary && extensions.ProgramBinaryLoad &&
+                                   extensions.ProgramParameteri && formats > 0;
+    }
+
+    extensions.TextureS3TC = HasGLExtension("GL_EXT_texture_compression_s3tc");
+    extensions.TextureBPTC = HasGLExtension("GL_ARB_texture_compression_bptc");
+}
+#endif
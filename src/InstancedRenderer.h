@@ -0,0 +1,136 @@
+#ifndef INSTANCED_RENDERER_H
+#define INSTANCED_RENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-frame draw counters, reset once per frame and shown in the Debug Info window
+struct RenderStats
+{
+    unsigned int DrawCalls = 0;
+    unsigned int Instances = 0;
+    double SubmitMs = 0.0;
+
+    void Reset()
+    {
+        DrawCalls = 0;
+        Instances = 0;
+        SubmitMs = 0.0;
+    }
+};
+
+inline RenderStats& GetRenderStats()
+{
+    static RenderStats stats;
+    return stats;
+}
+
+// Attribute locations used by instanced vertex shaders, after the per-vertex ones
+const GLuint INSTANCE_MODEL_LOCATION = 3; // mat4 takes locations 3..6
+const GLuint INSTANCE_COLOR_LOCATION = 7;
+
+// Everything a single instance needs, streamed to the GPU as one interleaved vertex buffer
+struct InstanceData
+{
+    glm::mat4 Model;
+    glm::vec4 Color;
+};
+
+// Instance buffer attached to a mesh VAO. Fill Instances on the CPU, Upload() once, then draw every
+// instance with a single glDraw*Instanced call.
+class InstanceBatch
+{
+public:
+    std::vector<InstanceData> Instances;
+
+    // attaches the instance attributes to an existing mesh VAO
+    void Init(GLuint vao)
+    {
+        VAO = vao;
+        glGenBuffers(1, &instanceVBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+        const GLsizei stride = sizeof(InstanceData);
+        for (GLuint column = 0; column < 4; ++column)
+        {
+            GLuint location = INSTANCE_MODEL_LOCATION + column;
+            glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, stride, (void*)(offsetof(InstanceData, Model) + column * sizeof(glm::vec4)));
+            glEnableVertexAttribArray(location);
+            glVertexAttribDivisor(location, 1);
+        }
+
+        glVertexAttribPointer(INSTANCE_COLOR_LOCATION, 4, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(InstanceData, Color));
+        glEnableVertexAttribArray(INSTANCE_COLOR_LOCATION);
+        glVertexAttribDivisor(INSTANCE_COLOR_LOCATION, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void Delete()
+    {
+        if (instanceVBO)
+            glDeleteBuffers(1, &instanceVBO);
+        instanceVBO = 0;
+        capacity = 0;
+    }
+
+    // streams the CPU instances into the instance buffer, orphaning the old storage so the upload
+    // never waits on draws from the previous frame
+    void Upload()
+    {
+        uploadedCount = (GLsizei)Instances.size();
+        if (uploadedCount == 0)
+            return;
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        if (Instances.size() > capacity)
+        {
+            capacity = Instances.size() + Instances.size() / 2;
+        }
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(InstanceData), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, Instances.size() * sizeof(InstanceData), Instances.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void DrawArrays(GLenum mode, GLint first, GLsizei vertexCount) const
+    {
+        if (uploadedCount == 0)
+            return;
+        glBindVertexArray(VAO);
+        glDrawArraysInstanced(mode, first, vertexCount, uploadedCount);
+        countDraw();
+    }
+
+    void DrawElements(GLenum mode, GLsizei indexCount, GLenum indexType, size_t indexOffset = 0) const
+    {
+        if (uploadedCount == 0)
+            return;
+        glBindVertexArray(VAO);
+        glDrawElementsInstanced(mode, indexCount, indexType, (void*)indexOffset, uploadedCount);
+        countDraw();
+    }
+
+    GLuint GetVAO() const { return VAO; }
+    GLsizei GetUploadedCount() const { return uploadedCount; }
+
+private:
+    GLuint VAO = 0;
+    GLuint instanceVBO = 0;
+    size_t capacity = 0;
+    GLsizei uploadedCount = 0;
+
+    void countDraw() const
+    {
+        RenderStats& stats = GetRenderStats();
+        stats.DrawCalls++;
+        stats.Instances += (unsigned int)uploadedCount;
+    }
+};
+#endif
@@ -0,0 +1,247 @@
+#ifndef INTEREST_H
+#define INTEREST_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Snapshot.h"
+
+// Area of interest for replication: which entities a client hears about, and how often, by their
+// distance from the client's camera along the ground. Each tick the snapshot is sorted into a
+// coarse grid once, then every client's view only looks at the cells around it. Nearby entities go
+// out every tick, farther ones every few ticks, and beyond the last ring not at all. An entity skipped on a tick keeps the
+// state the client last got for it, which the delta encoder sends as unchanged, for free.
+
+// entities within Distance of the viewer are sent every Period ticks
+struct InterestRing
+{
+    float Distance;
+    uint32_t Period;
+};
+
+struct InterestStats
+{
+    unsigned int Entities = 0;
+    // of the last tick, over all viewers
+    unsigned int Viewers = 0;
+    // entities in the cells looked at, within range, and sent with fresh state
+    unsigned int Candidates = 0;
+    unsigned int Relevant = 0;
+    unsigned int Fresh = 0;
+    double BuildMs = 0.0;
+    double SelectMs = 0.0;
+};
+
+class InterestGrid
+{
+public:
+    // nearest first; nothing beyond the last one is replicated
+    std::vector<InterestRing> Rings = { { 40.0f, 1 }, { 80.0f, 2 }, { 140.0f, 4 }, { 200.0f, 8 } };
+    // an entity the client already has is kept this much past the last ring, so one moving along
+    // the edge isn't removed and sent again every few ticks
+    float Hysteresis = 1.1f;
+    InterestStats Stats;
+
+    // sorts this tick's snapshot into the grid; call once per tick before Select
+    void Build(const Snapshot& snapshot)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        uint32_t count = (uint32_t)snapshot.Entities.size();
+        glm::vec2 lo(0.0f), hi(0.0f);
+        points.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const NetEntityState& state = snapshot.Entities[i];
+            glm::vec2 point(DequantizePosition(state.Position[0]), DequantizePosition(state.Position[2]));
+            points[i] = point;
+            lo = i == 0 ? point : glm::min(lo, point);
+            hi = i == 0 ? point : glm::max(hi, point);
+        }
+
+        // a few cells across the view keeps both the cells and the wasted candidates few; a world
+        // much wider than the view gets bigger cells rather than a huge grid
+        cellSize = std::max(1.0f, Rings.back().Distance * 0.25f);
+        glm::vec2 extent = hi - lo;
+        cellSize = std::max(cellSize, std::max(extent.x, extent.y) / (float)(MAX_CELLS_PER_SIDE - 1));
+        origin = lo;
+        columns = (int)(extent.x / cellSize) + 1;
+        rows = (int)(extent.y / cellSize) + 1;
+
+        // counting sort by cell, so every row of cells in a query is one contiguous run of entries
+        cellStart.assign((size_t)columns * rows + 1, 0);
+        cells.resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            cells[i] = cellOf(points[i]);
+            cellStart[cells[i] + 1]++;
+        }
+        for (size_t c = 0; c + 1 < cellStart.size(); ++c)
+            cellStart[c + 1] += cellStart[c];
+        entries.resize(count);
+        fill.assign(cellStart.begin(), cellStart.end() - 1);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            Entry& entry = entries[fill[cells[i]]++];
+            entry.Point = points[i];
+            entry.Index = i;
+        }
+        found.assign((count + 63) / 64, 0);
+        distances.resize(count);
+
+        Stats = InterestStats();
+        Stats.Entities = count;
+        Stats.BuildMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    // what a viewer gets this tick, sorted by Id: the entities within range on the ground plane,
+    // fresh when due or new to it, otherwise as they were in previous (the last snapshot selected
+    // for this viewer)
+    void Select(const Snapshot& snapshot, const glm::vec3& viewer, const Snapshot* previous, Snapshot& out)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        out.Tick = snapshot.Tick;
+        out.Entities.clear();
+        if (entries.empty())
+            return;
+
+        // a viewer farther than the reach from every cell sees nothing; this also keeps the cell
+        // math below in int range (and turns away NaN)
+        float reach = Rings.back().Distance * Hysteresis;
+        glm::vec2 center(viewer.x, viewer.z);
+        glm::vec2 far = origin + glm::vec2((float)columns, (float)rows) * cellSize;
+        if (!(center.x >= origin.x - reach && center.x <= far.x + reach && center.y >= origin.y - reach && center.y <= far.y + reach))
+            return;
+
+        // mark what is in reach; the marks come out in index order, which is Id order
+        int x0 = std::max(0, (int)std::floor((center.x - reach - origin.x) / cellSize));
+        int x1 = std::min(columns - 1, (int)std::floor((center.x + reach - origin.x) / cellSize));
+        int z0 = std::max(0, (int)std::floor((center.y - reach - origin.y) / cellSize));
+        int z1 = std::min(rows - 1, (int)std::floor((center.y + reach - origin.y) / cellSize));
+        uint32_t firstWord = (uint32_t)found.size(), lastWord = 0;
+        unsigned int looked = 0;
+        for (int z = z0; z <= z1 && x0 <= x1; ++z)
+        {
+            uint32_t begin = cellStart[(size_t)z * columns + x0], end = cellStart[(size_t)z * columns + x1 + 1];
+            looked += end - begin;
+            for (uint32_t e = begin; e < end; ++e)
+            {
+                glm::vec2 offset = entries[e].Point - center;
+                float distanceSquared = glm::dot(offset, offset);
+                if (distanceSquared > reach * reach)
+                    continue;
+                uint32_t index = entries[e].Index;
+                found[index >> 6] |= 1ull << (index & 63);
+                distances[index] = distanceSquared;
+                firstWord = std::min(firstWord, index >> 6);
+                lastWord = std::max(lastWord, index >> 6);
+            }
+        }
+
+        // both lists are sorted by Id, so finding what the viewer had is a merge
+        size_t known = 0;
+        const std::vector<NetEntityState>* had = previous ? &previous->Entities : nullptr;
+        for (uint32_t word = firstWord; word <= lastWord && word < found.size(); ++word)
+        {
+            uint64_t bits = found[word];
+            found[word] = 0;
+            while (bits)
+            {
+                uint32_t index = word * 64 + countTrailingZeros(bits);
+                bits &= bits - 1;
+                const NetEntityState& state = snapshot.Entities[index];
+                float distanceSquared = distances[index];
+
+                const NetEntityState* last = nullptr;
+                if (had)
+                {
+                    while (known < had->size() && (*had)[known].Id < state.Id)
+                        known++;
+                    if (known < had->size() && (*had)[known].Id == state.Id && (*had)[known].Generation == state.Generation)
+                        last = &(*had)[known];
+                }
+
+                uint32_t period = 0;
+                for (const InterestRing& ring : Rings)
+                {
+                    if (distanceSquared <= ring.Distance * ring.Distance)
+                    {
+                        period = ring.Period;
+                        break;
+                    }
+                }
+                // past the last ring only what the viewer already has stays, at the slowest rate
+                if (period == 0)
+                {
+                    if (!last)
+                        continue;
+                    period = Rings.back().Period;
+                }
+
+                // staggered by id, so the far entities' updates spread evenly over the ticks
+                if (!last || (snapshot.Tick + state.Id) % period == 0)
+                {
+                    out.Entities.push_back(state);
+                    Stats.Fresh++;
+                }
+                else
+                    out.Entities.push_back(*last);
+            }
+        }
+
+        Stats.Viewers++;
+        Stats.Candidates += looked;
+        Stats.Relevant += (unsigned int)out.Entities.size();
+        Stats.SelectMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+private:
+    static constexpr int MAX_CELLS_PER_SIDE = 1024;
+
+    struct Entry
+    {
+        glm::vec2 Point;
+        uint32_t Index;
+    };
+
+    // x/z of every snapshot entity, and the cell it is in
+    std::vector<glm::vec2> points;
+    std::vector<uint32_t> cells;
+    glm::vec2 origin = glm::vec2(0.0f);
+    float cellSize = 1.0f;
+    int columns = 0;
+    int rows = 0;
+    std::vector<uint32_t> cellStart;
+    std::vector<uint32_t> fill;
+    std::vector<Entry> entries;
+    // per Select: a bit per entity in reach, and its squared distance
+    std::vector<uint64_t> found;
+    std::vector<float> distances;
+
+    uint32_t cellOf(const glm::vec2& point) const
+    {
+        int x = std::min(columns - 1, (int)((point.x - origin.x) / cellSize));
+        int z = std::min(rows - 1, (int)((point.y - origin.y) / cellSize));
+        return (uint32_t)(z * columns + x);
+    }
+
+    static uint32_t countTrailingZeros(uint64_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return (uint32_t)index;
+#else
+        return (uint32_t)__builtin_ctzll(bits);
+#endif
+    }
+};
+#endif
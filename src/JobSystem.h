@@ -0,0 +1,327 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Counts unfinished jobs; a job group is done when its counter reaches zero
+struct JobCounter
+{
+    std::atomic<int> Value{ 0 };
+
+    bool IsDone() const
+    {
+        return Value.load(std::memory_order_acquire) == 0;
+    }
+};
+
+typedef void (*JobFunction)(void* data, uint32_t begin, uint32_t end);
+
+// One unit of work: a function over the range [Begin, End) of some shared data
+struct Job
+{
+    JobFunction Function = nullptr;
+    void* Data = nullptr;
+    uint32_t Begin = 0;
+    uint32_t End = 0;
+    JobCounter* Counter = nullptr;          // decremented when the job finishes
+    const JobCounter* Dependency = nullptr; // job only starts once this is done
+    std::atomic<bool> InFlight{ false };    // queued or running; the slot can't be reused yet
+};
+
+// Chase-Lev work-stealing deque. The owning thread pushes and pops at the bottom, other threads
+// steal from the top. Fixed capacity; Push() fails when full and the caller runs jobs until it fits.
+class JobDeque
+{
+public:
+    static const int64_t CAPACITY = 4096;
+
+    bool Push(Job* job)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= CAPACITY)
+            return false;
+        buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+        // publishes the job's fields to thieves that acquire bottom
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    // owner only
+    Job* Pop()
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        Job* job = nullptr;
+        if (t <= b)
+        {
+            job = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+            if (t == b)
+            {
+                // last item, race the thieves for it
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    job = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    // any thread
+    Job* Steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        Job* job = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return job;
+    }
+
+private:
+    // top and bottom on separate cache lines, thieves hammer one and the owner the other
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    alignas(64) std::atomic<Job*> buffer[CAPACITY];
+};
+
+// Work-stealing scheduler with one deque per thread. Thread 0 is the thread that called Init(); it
+// runs jobs too while it waits, so Init(n) uses n threads in total. Only those threads may queue
+// jobs: each deque has a single owner. Other threads get ParallelFor run inline and nothing else.
+class JobSystem
+{
+public:
+    // threadCount 0 = one per hardware thread
+    void Init(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        running = true;
+        queues.clear();
+        for (unsigned int i = 0; i < threadCount; ++i)
+            queues.push_back(std::unique_ptr<ThreadQueue>(new ThreadQueue()));
+
+        getThreadIndex() = 0;
+        for (unsigned int i = 1; i < threadCount; ++i)
+            workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+
+    void Delete()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            running = false;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers)
+            worker.join();
+        workers.clear();
+        queues.clear();
+        getThreadIndex() = NOT_A_WORKER;
+    }
+
+    unsigned int GetThreadCount() const
+    {
+        return (unsigned int)queues.size();
+    }
+
+    // queues fn(data, begin, end); counter (optional) is incremented now and decremented when it ran.
+    // A dependency holds the job back until that counter is zero, so queue the jobs it counts first.
+    void Run(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter* counter = nullptr,
+             const JobCounter* dependency = nullptr)
+    {
+        assert(IsOwnThread() && "jobs can only be queued from the thread that called Init() or a worker");
+        ThreadQueue& queue = *queues[getThreadIndex()];
+        // the ring wrapped onto a job that hasn't finished: help out until it has
+        Job* job = &queue.Pool[queue.NextJob & (JOB_POOL_SIZE - 1)];
+        while (job->InFlight.load(std::memory_order_acquire))
+            help();
+        queue.NextJob++;
+        job->Function = function;
+        job->Data = data;
+        job->Begin = begin;
+        job->End = end;
+        job->Counter = counter;
+        job->Dependency = dependency;
+        job->InFlight.store(true, std::memory_order_relaxed);
+        if (counter)
+            counter->Value.fetch_add(1, std::memory_order_relaxed);
+
+        // a full deque drains through the usual path, so the dependency and counter still hold
+        while (!queue.Jobs.Push(job))
+            help();
+        if (sleeping.load(std::memory_order_relaxed) > 0)
+            wake.notify_one();
+    }
+
+    // true on the thread that called Init() and on the workers
+    bool IsOwnThread() const
+    {
+        return getThreadIndex() < queues.size();
+    }
+
+    // runs other jobs until the counter reaches zero
+    void Wait(const JobCounter& counter)
+    {
+        while (!counter.IsDone())
+        {
+            if (!IsOwnThread() || !runOne())
+                std::this_thread::yield();
+        }
+    }
+
+    // calls body(begin, end) over [0, count) split into chunks, and returns when all chunks ran.
+    // Chunks are sized for a few per thread so stealing can balance uneven work.
+    template <typename F>
+    void ParallelFor(uint32_t count, F&& body, uint32_t minChunk = 1024)
+    {
+        if (count == 0)
+            return;
+        // from a foreign thread the whole range runs inline
+        uint32_t threads = IsOwnThread() ? GetThreadCount() : 1;
+        uint32_t chunk = threads > 1 ? std::max(minChunk, (count + threads * 4 - 1) / (threads * 4)) : count;
+        if (chunk >= count)
+        {
+            body(0u, count);
+            return;
+        }
+
+        JobCounter counter;
+        typedef typename std::remove_reference<F>::type Body;
+        for (uint32_t begin = 0; begin < count; begin += chunk)
+            Run(&invokeRange<Body>, (void*)&body, begin, std::min(count, begin + chunk), &counter);
+        Wait(counter);
+    }
+
+private:
+    // jobs are recycled in a ring, so no more than this many may be in flight per submitting thread
+    static const uint32_t JOB_POOL_SIZE = 8192;
+    static const unsigned int NOT_A_WORKER = ~0u;
+
+    struct ThreadQueue
+    {
+        JobDeque Jobs;
+        std::unique_ptr<Job[]> Pool{ new Job[JOB_POOL_SIZE] };
+        uint32_t NextJob = 0;
+        // jobs taken by this thread whose dependency was not done yet
+        std::vector<Job*> Deferred;
+    };
+
+    std::vector<std::unique_ptr<ThreadQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> sleeping{ 0 };
+    std::atomic<bool> running{ false };
+
+    template <typename Body>
+    static void invokeRange(void* data, uint32_t begin, uint32_t end)
+    {
+        (*(Body*)data)(begin, end);
+    }
+
+    static unsigned int& getThreadIndex()
+    {
+        static thread_local unsigned int index = NOT_A_WORKER;
+        return index;
+    }
+
+    static void execute(Job* job)
+    {
+        job->Function(job->Data, job->Begin, job->End);
+        JobCounter* counter = job->Counter;
+        // the slot may be reused as soon as it is released, so read it first
+        job->InFlight.store(false, std::memory_order_release);
+        if (counter)
+            counter->Value.fetch_sub(1, std::memory_order_release);
+    }
+
+    void help()
+    {
+        if (!runOne())
+            std::this_thread::yield();
+    }
+
+    // pops local work first, then steals from the others; false when there was nothing to run
+    bool runOne()
+    {
+        unsigned int self = getThreadIndex();
+        std::vector<Job*>& deferred = queues[self]->Deferred;
+        for (size_t i = 0; i < deferred.size(); ++i)
+        {
+            if (deferred[i]->Dependency->IsDone())
+            {
+                Job* ready = deferred[i];
+                deferred[i] = deferred.back();
+                deferred.pop_back();
+                execute(ready);
+                return true;
+            }
+        }
+
+        Job* job = queues[self]->Jobs.Pop();
+        if (!job)
+        {
+            unsigned int count = (unsigned int)queues.size();
+            for (unsigned int i = 1; i < count && !job; ++i)
+                job = queues[(self + i) % count]->Jobs.Steal();
+        }
+        if (!job)
+            return false;
+
+        // not ready yet: park it and let the jobs it depends on run first
+        if (job->Dependency && !job->Dependency->IsDone())
+            deferred.push_back(job);
+        else
+            execute(job);
+        return true;
+    }
+
+    void workerLoop(unsigned int index)
+    {
+        getThreadIndex() = index;
+        int idleSpins = 0;
+        while (running.load(std::memory_order_relaxed))
+        {
+            if (runOne())
+            {
+                idleSpins = 0;
+                continue;
+            }
+            if (++idleSpins < 64 || !queues[index]->Deferred.empty())
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // nothing to steal for a while, sleep until new work is queued
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleeping.fetch_add(1);
+            wake.wait_for(lock, std::chrono::milliseconds(2));
+            sleeping.fetch_sub(1);
+            idleSpins = 0;
+        }
+    }
+};
+#endif
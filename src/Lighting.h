@@ -0,0 +1,353 @@
+#ifndef LIGHTING_H
+#define LIGHTING_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Culling.h"
+#include "FrameConstants.h"
+#include "Shader.h"
+
+struct PointLight
+{
+    glm::vec3 Position = glm::vec3(0.0f);
+    float Radius = 5.0f;      // no light at all past this distance
+    glm::vec3 Color = glm::vec3(1.0f);
+    float Intensity = 1.0f;
+};
+
+// Light assignment counters for the last frame, shown in the Debug Info window
+struct LightingStats
+{
+    unsigned int Lights = 0;
+    unsigned int Visible = 0;
+    unsigned int Entries = 0;       // light indices over all clusters
+    unsigned int MaxPerCluster = 0;
+    unsigned int Dropped = 0;       // lights skipped because the index buffer was full
+    double AssignMs = 0.0;
+};
+
+// Cluster layout for the fragment shader. Member order and padding follow std140, see the
+// LightingConstants block in fragment.glsl.
+struct LightingConstants
+{
+    uint32_t ClusterCounts[4]; // grid x, y, z, unused
+    glm::vec4 ClusterDepth;    // near, far, slice scale, slice bias: slice = log(depth) * scale + bias
+};
+
+static_assert(sizeof(LightingConstants) == 32, "LightingConstants must match the std140 layout of the GLSL block");
+
+// Clustered forward lighting. The view frustum is cut into a grid of froxels (screen tiles times
+// exponential depth slices); every frame each light's bounding sphere is projected to a froxel range
+// on the CPU, four lights per SSE step, and the per-cluster light lists go to the GPU as texture
+// buffers. The fragment shader finds its cluster and loops over that list only.
+class ClusteredLighting
+{
+public:
+    static const int GRID_X = 16;
+    static const int GRID_Y = 9;
+    static const int GRID_Z = 24;
+    static const int CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+    // light indices are stored as 16 bits
+    static const int MAX_LIGHTS = 65535;
+    // the three light textures use units FIRST_TEXTURE_UNIT .. +2; unit 0 stays free for materials
+    static const int FIRST_TEXTURE_UNIT = 1;
+
+    // filled by the caller before Update(), every frame if the lights move
+    std::vector<PointLight> Lights;
+    LightingStats Stats;
+
+    void Init()
+    {
+        // GL 3.3 only guarantees 64K texels per texture buffer; most drivers allow far more
+        GLint maxTexels = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+        maxEntries = (uint32_t)std::max(maxTexels, 65536);
+
+        const GLenum formats[3] = { GL_RG32UI, GL_R16UI, GL_RGBA32F };
+        glGenBuffers(3, buffers);
+        glGenTextures(3, textures);
+        for (int i = 0; i < 3; ++i)
+        {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffers[i]);
+            glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers[i]);
+        }
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        glGenBuffers(1, &constantsBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, constantsBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(LightingConstants), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        clusterRanges.resize(CLUSTER_COUNT * 2);
+        clusterCursor.resize(CLUSTER_COUNT);
+    }
+
+    void Delete()
+    {
+        glDeleteTextures(3, textures);
+        glDeleteBuffers(3, buffers);
+        glDeleteBuffers(1, &constantsBuffer);
+        for (int i = 0; i < 3; ++i)
+            textures[i] = buffers[i] = 0;
+        constantsBuffer = 0;
+    }
+
+    // points the program's light samplers at the light texture units; call once after (re)linking
+    void BindSamplers(Shader& program)
+    {
+        program.Use();
+        program.SetInt("clusterRanges", FIRST_TEXTURE_UNIT);
+        program.SetInt("lightIndices", FIRST_TEXTURE_UNIT + 1);
+        program.SetInt("lightData", FIRST_TEXTURE_UNIT + 2);
+    }
+
+    // assigns Lights to clusters for this frame's camera, uploads everything and binds it for drawing
+    void Update(const FrameConstants& frame, float nearPlane, float farPlane)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        const uint32_t count = (uint32_t)std::min(Lights.size(), (size_t)MAX_LIGHTS);
+
+        bounds.Resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+            bounds.Set(i, Lights[i].Position, Lights[i].Radius);
+        computeRanges(frame, nearPlane, farPlane, count);
+        assign(count);
+
+        LightingConstants constants;
+        constants.ClusterCounts[0] = GRID_X;
+        constants.ClusterCounts[1] = GRID_Y;
+        constants.ClusterCounts[2] = GRID_Z;
+        constants.ClusterCounts[3] = 0;
+        float sliceScale = (float)GRID_Z / std::log(farPlane / nearPlane);
+        constants.ClusterDepth = glm::vec4(nearPlane, farPlane, sliceScale, -std::log(nearPlane) * sliceScale);
+
+        lightTexels.resize(std::max(count, 1u) * 2);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const PointLight& light = Lights[i];
+            lightTexels[i * 2] = glm::vec4(light.Position, light.Radius);
+            lightTexels[i * 2 + 1] = glm::vec4(light.Color, light.Intensity);
+        }
+        if (lightIndices.empty())
+            lightIndices.push_back(0);
+
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.Lights = count;
+        Stats.AssignMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        // whole-buffer glBufferData orphans last frame's storage instead of waiting for the GPU
+        upload(0, clusterRanges.data(), clusterRanges.size() * sizeof(uint32_t));
+        upload(1, lightIndices.data(), lightIndices.size() * sizeof(uint16_t));
+        upload(2, lightTexels.data(), lightTexels.size() * sizeof(glm::vec4));
+
+        glBindBuffer(GL_UNIFORM_BUFFER, constantsBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightingConstants), &constants);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTING_CONSTANTS_BINDING, constantsBuffer);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + i);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    GLuint buffers[3] = {};
+    GLuint textures[3] = {};
+    GLuint constantsBuffer = 0;
+    uint32_t maxEntries = 65536;
+
+    SphereBoundsSoA bounds;
+    // cluster range of every light, inclusive; visible is 0 for lights outside the frustum
+    std::vector<int32_t> minX, maxX, minY, maxY, minZ, maxZ, visible;
+
+    std::vector<uint32_t> clusterRanges; // first index, count
+    std::vector<uint32_t> clusterCursor;
+    std::vector<uint16_t> lightIndices;
+    std::vector<glm::vec4> lightTexels;
+
+    void upload(int buffer, const void* data, size_t bytes)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffers[buffer]);
+        glBufferData(GL_TEXTURE_BUFFER, bytes, data, GL_STREAM_DRAW);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    }
+
+    // projects every light's sphere into view space and finds the tiles and depth slices it covers
+    void computeRanges(const FrameConstants& frame, float nearPlane, float farPlane, uint32_t count)
+    {
+        minX.resize(count); maxX.resize(count);
+        minY.resize(count); maxY.resize(count);
+        minZ.resize(count); maxZ.resize(count);
+        visible.resize(count);
+
+        // depths where slices 1 .. GRID_Z - 1 begin
+        float sliceStart[GRID_Z - 1];
+        for (int k = 1; k < GRID_Z; ++k)
+            sliceStart[k - 1] = nearPlane * std::pow(farPlane / nearPlane, (float)k / (float)GRID_Z);
+
+        const glm::mat4& view = frame.View;
+        const float scaleX = frame.Projection[0][0];
+        const float scaleY = frame.Projection[1][1];
+        uint32_t i = 0;
+
+#if defined(GE_CULL_AVX2) || defined(GE_CULL_SSE2)
+        __m128 m[4][3];
+        for (int c = 0; c < 4; ++c)
+        {
+            for (int r = 0; r < 3; ++r)
+                m[c][r] = _mm_set1_ps(view[c][r]);
+        }
+        const __m128 nearV = _mm_set1_ps(nearPlane), farV = _mm_set1_ps(farPlane);
+        const __m128 one = _mm_set1_ps(1.0f), minusOne = _mm_set1_ps(-1.0f), half = _mm_set1_ps(0.5f);
+        const __m128 gridX = _mm_set1_ps((float)GRID_X), gridY = _mm_set1_ps((float)GRID_Y);
+        const __m128 lastX = _mm_set1_ps((float)(GRID_X - 1)), lastY = _mm_set1_ps((float)(GRID_Y - 1));
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 sx = _mm_set1_ps(scaleX), sy = _mm_set1_ps(scaleY);
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(bounds.X.data() + i);
+            __m128 y = _mm_loadu_ps(bounds.Y.data() + i);
+            __m128 z = _mm_loadu_ps(bounds.Z.data() + i);
+            __m128 r = _mm_loadu_ps(bounds.Radius.data() + i);
+
+            __m128 vx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], x), _mm_mul_ps(m[1][0], y)), _mm_add_ps(_mm_mul_ps(m[2][0], z), m[3][0]));
+            __m128 vy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][1], x), _mm_mul_ps(m[1][1], y)), _mm_add_ps(_mm_mul_ps(m[2][1], z), m[3][1]));
+            __m128 vz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][2], x), _mm_mul_ps(m[1][2], y)), _mm_add_ps(_mm_mul_ps(m[2][2], z), m[3][2]));
+            __m128 depth = _mm_sub_ps(zero, vz);
+            __m128 nearDepth = _mm_max_ps(_mm_sub_ps(depth, r), nearV);
+            __m128 farDepth = _mm_max_ps(_mm_min_ps(_mm_add_ps(depth, r), farV), nearDepth);
+            __m128 inside = _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(depth, r), nearV), _mm_cmplt_ps(_mm_sub_ps(depth, r), farV));
+
+            // x / depth is monotonic in depth, so the box's screen extent comes from its nearest and farthest depth
+            __m128 invNear = _mm_div_ps(one, nearDepth), invFar = _mm_div_ps(one, farDepth);
+            __m128 lowX = _mm_mul_ps(_mm_sub_ps(vx, r), sx), highX = _mm_mul_ps(_mm_add_ps(vx, r), sx);
+            __m128 lowY = _mm_mul_ps(_mm_sub_ps(vy, r), sy), highY = _mm_mul_ps(_mm_add_ps(vy, r), sy);
+            __m128 ndcMinX = _mm_min_ps(_mm_mul_ps(lowX, invNear), _mm_mul_ps(lowX, invFar));
+            __m128 ndcMaxX = _mm_max_ps(_mm_mul_ps(highX, invNear), _mm_mul_ps(highX, invFar));
+            __m128 ndcMinY = _mm_min_ps(_mm_mul_ps(lowY, invNear), _mm_mul_ps(lowY, invFar));
+            __m128 ndcMaxY = _mm_max_ps(_mm_mul_ps(highY, invNear), _mm_mul_ps(highY, invFar));
+            inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpgt_ps(ndcMaxX, minusOne), _mm_cmplt_ps(ndcMinX, one)));
+            inside = _mm_and_ps(inside, _mm_and_ps(_mm_cmpgt_ps(ndcMaxY, minusOne), _mm_cmplt_ps(ndcMinY, one)));
+
+            // ndc -> tile, clamped so truncation works as floor
+            auto tile = [&](__m128 ndc, __m128 grid, __m128 last) {
+                __m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndc, half), half), grid);
+                return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(t, zero), last));
+            };
+            _mm_storeu_si128((__m128i*)(minX.data() + i), tile(ndcMinX, gridX, lastX));
+            _mm_storeu_si128((__m128i*)(maxX.data() + i), tile(ndcMaxX, gridX, lastX));
+            _mm_storeu_si128((__m128i*)(minY.data() + i), tile(ndcMinY, gridY, lastY));
+            _mm_storeu_si128((__m128i*)(maxY.data() + i), tile(ndcMaxY, gridY, lastY));
+
+            // slice = number of slice starts at or before the depth; compare masks are -1, so subtract them
+            __m128i sliceMin = _mm_setzero_si128(), sliceMax = _mm_setzero_si128();
+            for (int k = 0; k < GRID_Z - 1; ++k)
+            {
+                __m128 boundary = _mm_set1_ps(sliceStart[k]);
+                sliceMin = _mm_sub_epi32(sliceMin, _mm_castps_si128(_mm_cmpge_ps(nearDepth, boundary)));
+                sliceMax = _mm_sub_epi32(sliceMax, _mm_castps_si128(_mm_cmpge_ps(farDepth, boundary)));
+            }
+            _mm_storeu_si128((__m128i*)(minZ.data() + i), sliceMin);
+            _mm_storeu_si128((__m128i*)(maxZ.data() + i), sliceMax);
+            _mm_storeu_si128((__m128i*)(visible.data() + i), _mm_castps_si128(inside));
+        }
+#endif
+        // scalar tail, and the whole loop without SSE
+        for (; i < count; ++i)
+        {
+            float x = bounds.X[i], y = bounds.Y[i], z = bounds.Z[i], r = bounds.Radius[i];
+            float vx = view[0][0] * x + view[1][0] * y + view[2][0] * z + view[3][0];
+            float vy = view[0][1] * x + view[1][1] * y + view[2][1] * z + view[3][1];
+            float depth = -(view[0][2] * x + view[1][2] * y + view[2][2] * z + view[3][2]);
+            float nearDepth = std::max(depth - r, nearPlane);
+            float farDepth = std::max(std::min(depth + r, farPlane), nearDepth);
+
+            float ndcMinX = std::min((vx - r) * scaleX / nearDepth, (vx - r) * scaleX / farDepth);
+            float ndcMaxX = std::max((vx + r) * scaleX / nearDepth, (vx + r) * scaleX / farDepth);
+            float ndcMinY = std::min((vy - r) * scaleY / nearDepth, (vy - r) * scaleY / farDepth);
+            float ndcMaxY = std::max((vy + r) * scaleY / nearDepth, (vy + r) * scaleY / farDepth);
+            visible[i] = depth + r > nearPlane && depth - r < farPlane && ndcMaxX > -1.0f && ndcMinX < 1.0f && ndcMaxY > -1.0f && ndcMinY < 1.0f ? -1 : 0;
+
+            auto tile = [](float ndc, int grid) {
+                return (int32_t)std::min(std::max((ndc * 0.5f + 0.5f) * (float)grid, 0.0f), (float)(grid - 1));
+            };
+            minX[i] = tile(ndcMinX, GRID_X); maxX[i] = tile(ndcMaxX, GRID_X);
+            minY[i] = tile(ndcMinY, GRID_Y); maxY[i] = tile(ndcMaxY, GRID_Y);
+            minZ[i] = (int32_t)(std::upper_bound(sliceStart, sliceStart + GRID_Z - 1, nearDepth) - sliceStart);
+            maxZ[i] = (int32_t)(std::upper_bound(sliceStart, sliceStart + GRID_Z - 1, farDepth) - sliceStart);
+        }
+    }
+
+    // counting sort of (cluster, light) pairs: count per cluster, prefix sum, then scatter
+    void assign(uint32_t count)
+    {
+        std::fill(clusterCursor.begin(), clusterCursor.end(), 0u);
+        uint32_t total = 0, visibleCount = 0;
+        Stats.Dropped = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (!visible[i])
+                continue;
+            uint32_t cells = (uint32_t)((maxX[i] - minX[i] + 1) * (maxY[i] - minY[i] + 1) * (maxZ[i] - minZ[i] + 1));
+            if (total + cells > maxEntries)
+            {
+                visible[i] = 0;
+                Stats.Dropped++;
+                continue;
+            }
+            total += cells;
+            visibleCount++;
+            forEachCluster(i, [&](uint32_t cluster) { clusterCursor[cluster]++; });
+        }
+
+        uint32_t offset = 0, maxPerCluster = 0;
+        for (uint32_t c = 0; c < (uint32_t)CLUSTER_COUNT; ++c)
+        {
+            uint32_t n = clusterCursor[c];
+            clusterRanges[c * 2] = offset;
+            clusterRanges[c * 2 + 1] = n;
+            clusterCursor[c] = offset;
+            offset += n;
+            maxPerCluster = std::max(maxPerCluster, n);
+        }
+
+        lightIndices.resize(total);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (visible[i])
+                forEachCluster(i, [&](uint32_t cluster) { lightIndices[clusterCursor[cluster]++] = (uint16_t)i; });
+        }
+
+        Stats.Visible = visibleCount;
+        Stats.Entries = total;
+        Stats.MaxPerCluster = maxPerCluster;
+    }
+
+    template<typename F>
+    void forEachCluster(uint32_t light, F&& f)
+    {
+        for (int32_t z = minZ[light]; z <= maxZ[light]; ++z)
+        {
+            for (int32_t y = minY[light]; y <= maxY[light]; ++y)
+            {
+                uint32_t row = (uint32_t)((z * GRID_Y + y) * GRID_X);
+                for (int32_t x = minX[light]; x <= maxX[light]; ++x)
+                    f(row + (uint32_t)x);
+            }
+        }
+    }
+};
+#endif
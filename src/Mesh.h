@@ -0,0 +1,415 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "InstancedRenderer.h"
+
+// What a vertex attribute means. Each semantic has a fixed attribute location shared by every shader.
+enum VertexSemantic
+{
+    POSITION = 0,
+    COLOR    = 1,
+    NORMAL   = 2
+};
+
+struct VertexAttribute
+{
+    VertexSemantic Semantic;
+    GLint Components;
+    GLenum Type;          // GL_FLOAT, GL_HALF_FLOAT, GL_UNSIGNED_BYTE, GL_INT_2_10_10_10_REV, ...
+    GLboolean Normalized;
+    GLuint Offset;
+};
+
+// float -> IEEE 754 half, round to nearest, with overflow to infinity and flush of tiny values to zero
+inline uint16_t PackHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000u;
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFFu) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent <= 0)
+        return (uint16_t)sign;
+    if (exponent >= 31)
+        return (uint16_t)(sign | 0x7C00u);
+
+    uint16_t half = (uint16_t)(sign | ((uint32_t)exponent << 10) | (mantissa >> 13));
+    if (mantissa & 0x1000u)
+        half++; // carries into the exponent correctly when the mantissa overflows
+    return half;
+}
+
+// signed normalized float in [-1, 1] -> n-bit two's complement field
+inline uint32_t PackSnorm(float value, int bits)
+{
+    float maxValue = (float)((1 << (bits - 1)) - 1);
+    int32_t v = (int32_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * maxValue);
+    return (uint32_t)v & ((1u << bits) - 1u);
+}
+
+inline uint32_t PackUnorm(float value, int bits)
+{
+    float maxValue = (float)((1u << bits) - 1u);
+    return (uint32_t)std::lround(std::min(std::max(value, 0.0f), 1.0f) * maxValue);
+}
+
+// Describes how vertices are laid out in the vertex buffer. Declared once per mesh format; drives both
+// the packing of source data and the VAO attribute setup.
+class VertexLayout
+{
+public:
+    std::vector<VertexAttribute> Attributes;
+    GLsizei Stride = 0;
+
+    VertexLayout& Add(VertexSemantic semantic, GLint components, GLenum type, GLboolean normalized = GL_FALSE)
+    {
+        VertexAttribute attribute = { semantic, components, type, normalized, (GLuint)Stride };
+        Attributes.push_back(attribute);
+        // keep every attribute 4-byte aligned, which some drivers need for fast vertex fetch
+        Stride += (AttributeSize(attribute) + 3) & ~3;
+        return *this;
+    }
+
+    // 40 bytes: float position, float normal, float color
+    static VertexLayout Full()
+    {
+        VertexLayout layout;
+        layout.Add(POSITION, 3, GL_FLOAT)
+              .Add(NORMAL, 3, GL_FLOAT)
+              .Add(COLOR, 4, GL_FLOAT);
+        return layout;
+    }
+
+    // 16 bytes: half position (w padded), 10_10_10_2 snorm normal, unorm8 color
+    static VertexLayout Compact()
+    {
+        VertexLayout layout;
+        layout.Add(POSITION, 4, GL_HALF_FLOAT)
+              .Add(NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE)
+              .Add(COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE);
+        return layout;
+    }
+
+    // 16 bytes: unorm16 position inside the mesh bounds (see Mesh::Dequantize), 10_10_10_2 snorm
+    // normal, unorm8 color. Keeps 16 bits over the whole mesh where half floats lose precision
+    // away from the origin.
+    static VertexLayout Quantized()
+    {
+        VertexLayout layout;
+        layout.Add(POSITION, 4, GL_UNSIGNED_SHORT, GL_TRUE)
+              .Add(NORMAL, 4, GL_INT_2_10_10_10_REV, GL_TRUE)
+              .Add(COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE);
+        return layout;
+    }
+
+    // sets up the attribute pointers for the vertex buffer currently bound to GL_ARRAY_BUFFER
+    void Apply() const
+    {
+        for (const VertexAttribute& attribute : Attributes)
+        {
+            glVertexAttribPointer(attribute.Semantic, attribute.Components, attribute.Type, attribute.Normalized, Stride, (void*)(size_t)attribute.Offset);
+            glEnableVertexAttribArray(attribute.Semantic);
+        }
+    }
+
+    // writes up to four source components into the attribute's storage format
+    static void Encode(const VertexAttribute& attribute, const float* src, uint8_t* dst)
+    {
+        switch (attribute.Type)
+        {
+        case GL_FLOAT:
+            std::memcpy(dst, src, attribute.Components * sizeof(float));
+            break;
+        case GL_HALF_FLOAT:
+            for (GLint i = 0; i < attribute.Components; ++i)
+            {
+                uint16_t half = PackHalf(src[i]);
+                std::memcpy(dst + i * 2, &half, 2);
+            }
+            break;
+        case GL_UNSIGNED_BYTE:
+            for (GLint i = 0; i < attribute.Components; ++i)
+                dst[i] = (uint8_t)PackUnorm(src[i], 8);
+            break;
+        case GL_BYTE:
+            for (GLint i = 0; i < attribute.Components; ++i)
+                dst[i] = (uint8_t)PackSnorm(src[i], 8);
+            break;
+        case GL_UNSIGNED_SHORT:
+            for (GLint i = 0; i < attribute.Components; ++i)
+            {
+                uint16_t v = (uint16_t)PackUnorm(src[i], 16);
+                std::memcpy(dst + i * 2, &v, 2);
+            }
+            break;
+        case GL_INT_2_10_10_10_REV:
+        {
+            uint32_t packed = PackSnorm(src[0], 10) | (PackSnorm(src[1], 10) << 10) | (PackSnorm(src[2], 10) << 20) | (PackSnorm(src[3], 2) << 30);
+            std::memcpy(dst, &packed, 4);
+            break;
+        }
+        }
+    }
+
+    static GLsizei AttributeSize(const VertexAttribute& attribute)
+    {
+        switch (attribute.Type)
+        {
+        case GL_FLOAT:              return 4 * attribute.Components;
+        case GL_HALF_FLOAT:         return 2 * attribute.Components;
+        case GL_UNSIGNED_SHORT:     return 2 * attribute.Components;
+        case GL_UNSIGNED_BYTE:
+        case GL_BYTE:               return attribute.Components;
+        case GL_INT_2_10_10_10_REV: return 4;
+        }
+        return 0;
+    }
+};
+
+// Source geometry in full precision, before it is packed into a VertexLayout
+struct MeshData
+{
+    std::vector<glm::vec3> Positions;
+    std::vector<glm::vec3> Normals;
+    std::vector<glm::vec4> Colors;
+    std::vector<uint32_t> Indices;
+
+    uint32_t AddVertex(const glm::vec3& position, const glm::vec3& normal, const glm::vec4& color)
+    {
+        Positions.push_back(position);
+        Normals.push_back(normal);
+        Colors.push_back(color);
+        return (uint32_t)Positions.size() - 1;
+    }
+
+    // packs every vertex into the layout's interleaved format
+    std::vector<uint8_t> Pack(const VertexLayout& layout) const
+    {
+        std::vector<uint8_t> bytes(Positions.size() * layout.Stride, 0);
+        for (size_t v = 0; v < Positions.size(); ++v)
+        {
+            uint8_t* vertex = bytes.data() + v * layout.Stride;
+            for (const VertexAttribute& attribute : layout.Attributes)
+            {
+                float src[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                if (attribute.Semantic == POSITION)
+                {
+                    src[0] = Positions[v].x; src[1] = Positions[v].y; src[2] = Positions[v].z;
+                }
+                else if (attribute.Semantic == NORMAL && v < Normals.size())
+                {
+                    src[0] = Normals[v].x; src[1] = Normals[v].y; src[2] = Normals[v].z; src[3] = 0.0f;
+                }
+                else if (attribute.Semantic == COLOR && v < Colors.size())
+                {
+                    src[0] = Colors[v].x; src[1] = Colors[v].y; src[2] = Colors[v].z; src[3] = Colors[v].w;
+                }
+                VertexLayout::Encode(attribute, src, vertex + attribute.Offset);
+            }
+        }
+        return bytes;
+    }
+};
+
+// GPU memory held by all live meshes, shown in the Debug Info window
+struct MeshStats
+{
+    size_t VertexBytes = 0;
+    size_t IndexBytes = 0;
+};
+
+inline MeshStats& GetMeshStats()
+{
+    static MeshStats stats;
+    return stats;
+}
+
+// Indexed mesh living in a VAO with its own vertex and index buffers
+class Mesh
+{
+public:
+    GLuint VAO = 0;
+    GLsizei IndexCount = 0;
+    GLenum IndexType = GL_UNSIGNED_SHORT;
+    GLsizei VertexStride = 0;
+    // maps quantized positions back to model space; identity unless the positions are normalized integers
+    glm::mat4 Dequantize = glm::mat4(1.0f);
+
+    void Init(const MeshData& data, const VertexLayout& layout)
+    {
+        std::vector<uint8_t> vertices = data.Pack(layout);
+
+        // 16-bit indices whenever the vertex count allows it
+        std::vector<uint16_t> shortIndices;
+        if (data.Positions.size() <= 65536)
+        {
+            shortIndices.assign(data.Indices.begin(), data.Indices.end());
+            Init(vertices.data(), vertices.size(), shortIndices.data(), (GLsizei)shortIndices.size(), GL_UNSIGNED_SHORT, layout);
+        }
+        else
+            Init(vertices.data(), vertices.size(), data.Indices.data(), (GLsizei)data.Indices.size(), GL_UNSIGNED_INT, layout);
+    }
+
+    // buffers already in the layout's format, uploaded as they are (e.g. straight from a mapped mesh file)
+    void Init(const void* vertices, size_t vertexSize, const void* indices, GLsizei indexCount, GLenum indexType, const VertexLayout& layout)
+    {
+        VertexStride = layout.Stride;
+        IndexCount = indexCount;
+        IndexType = indexType;
+        size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertexSize, vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, IndexCount * indexSize, indices, GL_STATIC_DRAW);
+
+        layout.Apply();
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        vertexBytes = vertexSize;
+        indexBytes = IndexCount * indexSize;
+        GetMeshStats().VertexBytes += vertexBytes;
+        GetMeshStats().IndexBytes += indexBytes;
+    }
+
+    void Delete()
+    {
+        if (VAO == 0)
+            return;
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+        GetMeshStats().VertexBytes -= vertexBytes;
+        GetMeshStats().IndexBytes -= indexBytes;
+    }
+
+    void Draw() const
+    {
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, IndexCount, IndexType, (void*)0);
+        GetRenderStats().DrawCalls++;
+    }
+
+    // draws a contiguous sub-range of the index buffer, for meshes laid out in independent sections
+    void DrawRange(GLsizei firstIndex, GLsizei count) const
+    {
+        size_t indexSize = IndexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, count, IndexType, (void*)(firstIndex * indexSize));
+        GetRenderStats().DrawCalls++;
+    }
+
+    // draws every instance of the batch, which must have been initialized with this mesh's VAO
+    void DrawInstanced(const InstanceBatch& batch) const
+    {
+        batch.DrawElements(GL_TRIANGLES, IndexCount, IndexType);
+    }
+
+private:
+    GLuint VBO = 0;
+    GLuint EBO = 0;
+    size_t vertexBytes = 0;
+    size_t indexBytes = 0;
+};
+
+// Triangle with red/green/blue corners, facing +z
+inline MeshData CreateTriangleMeshData()
+{
+    MeshData data;
+    glm::vec3 normal(0.0f, 0.0f, 1.0f);
+    data.AddVertex(glm::vec3(-0.5f, -0.5f, -0.5f), normal, glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+    data.AddVertex(glm::vec3( 0.5f, -0.5f, -0.5f), normal, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+    data.AddVertex(glm::vec3( 0.0f,  0.5f, -0.5f), normal, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+    data.Indices = { 0, 1, 2 };
+    return data;
+}
+
+// Flat square on the xz plane, spanning [-halfExtent, halfExtent]
+inline MeshData CreatePlaneMeshData(float halfExtent, const glm::vec4& color)
+{
+    MeshData data;
+    glm::vec3 up(0.0f, 1.0f, 0.0f);
+    data.AddVertex(glm::vec3(-halfExtent, 0.0f,  halfExtent), up, color);
+    data.AddVertex(glm::vec3( halfExtent, 0.0f,  halfExtent), up, color);
+    data.AddVertex(glm::vec3( halfExtent, 0.0f, -halfExtent), up, color);
+    data.AddVertex(glm::vec3(-halfExtent, 0.0f, -halfExtent), up, color);
+    data.Indices = { 0, 1, 2, 2, 3, 0 };
+    return data;
+}
+
+// Unit cube with per-face normals. Faces get a fixed shade so they stay readable without lighting.
+inline MeshData CreateCubeMeshData()
+{
+    struct Face { glm::vec3 Normal; glm::vec3 U; glm::vec3 V; float Shade; };
+    const Face faces[6] = {
+        { glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.6f }, // back
+        { glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3( 1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.8f }, // front
+        { glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3( 0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.7f }, // left
+        { glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3( 0.0f, 0.0f,-1.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.7f }, // right
+        { glm::vec3( 0.0f, -1.0f,  0.0f), glm::vec3( 1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), 0.4f }, // bottom
+        { glm::vec3( 0.0f,  1.0f,  0.0f), glm::vec3( 1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f,-1.0f), 1.0f }, // top
+    };
+
+    MeshData data;
+    for (const Face& face : faces)
+    {
+        glm::vec4 color(face.Shade, face.Shade, face.Shade, 1.0f);
+        glm::vec3 center = face.Normal * 0.5f;
+        uint32_t base = data.AddVertex(center - face.U * 0.5f - face.V * 0.5f, face.Normal, color);
+        data.AddVertex(center + face.U * 0.5f - face.V * 0.5f, face.Normal, color);
+        data.AddVertex(center + face.U * 0.5f + face.V * 0.5f, face.Normal, color);
+        data.AddVertex(center - face.U * 0.5f + face.V * 0.5f, face.Normal, color);
+        data.Indices.insert(data.Indices.end(), { base, base + 1, base + 2, base + 2, base + 3, base });
+    }
+    return data;
+}
+// Square pyramid on the xz plane with its apex at y = 1, per-face normals
+inline MeshData CreatePyramidMeshData()
+{
+    const glm::vec3 apex(0.0f, 1.0f, 0.0f);
+    const glm::vec3 base[4] = {
+        glm::vec3(-0.5f, 0.0f,  0.5f), glm::vec3( 0.5f, 0.0f,  0.5f),
+        glm::vec3( 0.5f, 0.0f, -0.5f), glm::vec3(-0.5f, 0.0f, -0.5f),
+    };
+
+    MeshData data;
+    for (int i = 0; i < 4; ++i)
+    {
+        const glm::vec3& a = base[i];
+        const glm::vec3& b = base[(i + 1) % 4];
+        glm::vec3 normal = glm::normalize(glm::cross(b - a, apex - a));
+        glm::vec4 color(0.6f + 0.1f * i, 0.6f + 0.1f * i, 0.6f + 0.1f * i, 1.0f);
+        uint32_t first = data.AddVertex(a, normal, color);
+        data.AddVertex(b, normal, color);
+        data.AddVertex(apex, normal, color);
+        data.Indices.insert(data.Indices.end(), { first, first + 1, first + 2 });
+    }
+
+    glm::vec3 down(0.0f, -1.0f, 0.0f);
+    glm::vec4 shade(0.4f, 0.4f, 0.4f, 1.0f);
+    uint32_t first = data.AddVertex(base[0], down, shade);
+    data.AddVertex(base[3], down, shade);
+    data.AddVertex(base[2], down, shade);
+    data.AddVertex(base[1], down, shade);
+    data.Indices.insert(data.Indices.end(), { first, first + 1, first + 2, first + 2, first + 3, first });
+    return data;
+}
+#endif
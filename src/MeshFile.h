@@ -0,0 +1,223 @@
+#ifndef MESH_FILE_H
+#define MESH_FILE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Mesh.h"
+
+// Cooked mesh files (.gemesh), written by tools/ge_cook. A fixed header is followed by the vertex
+// and index sections exactly as the GPU wants them, so loading is mapping the file and handing both
+// sections to glBufferData. Little-endian; sections start on MESH_FILE_ALIGNMENT boundaries.
+
+const char MESH_FILE_MAGIC[4] = { 'G', 'E', 'M', 'F' };
+// bump whenever the header or a section's layout changes; older files are rejected and re-cooked
+const uint32_t MESH_FILE_VERSION = 1;
+const uint32_t MESH_FILE_MAX_ATTRIBUTES = 4;
+const uint32_t MESH_FILE_ALIGNMENT = 64;
+
+struct MeshFileAttribute
+{
+    uint32_t Semantic;
+    uint32_t Components;
+    uint32_t Type;
+    uint32_t Normalized;
+    uint32_t Offset;
+};
+
+struct MeshFileHeader
+{
+    char Magic[4];
+    uint32_t Version;
+    uint32_t VertexCount;
+    uint32_t IndexCount;
+    uint32_t VertexStride;
+    // 2 or 4 bytes
+    uint32_t IndexSize;
+    uint32_t AttributeCount;
+    uint32_t Reserved;
+    // model position = PositionOffset + quantized position * PositionScale (the same scale on every
+    // axis, so normals need no correction)
+    float PositionOffset[3];
+    float PositionScale;
+    float BoundsMin[3];
+    float BoundsMax[3];
+    uint64_t VertexOffset;
+    uint64_t VertexBytes;
+    uint64_t IndexOffset;
+    uint64_t IndexBytes;
+    MeshFileAttribute Attributes[MESH_FILE_MAX_ATTRIBUTES];
+};
+static_assert(sizeof(MeshFileHeader) == 184, "mesh file header layout changed, bump MESH_FILE_VERSION");
+
+// Read-only view of a whole file
+class MappedFile
+{
+public:
+    const uint8_t* Data = nullptr;
+    size_t Size = 0;
+
+    bool Open(const std::string& path)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        {
+            Close();
+            return false;
+        }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping)
+            Data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!Data)
+        {
+            Close();
+            return false;
+        }
+        Size = (size_t)size.QuadPart;
+#else
+        file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size == 0)
+        {
+            Close();
+            return false;
+        }
+        void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view == MAP_FAILED)
+        {
+            Close();
+            return false;
+        }
+        Data = (const uint8_t*)view;
+        Size = (size_t)info.st_size;
+        // the whole file is read right away, so start paging it in
+        madvise(view, Size, MADV_WILLNEED);
+#endif
+        return true;
+    }
+
+    void Close()
+    {
+#ifdef _WIN32
+        if (Data)
+            UnmapViewOfFile(Data);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (Data)
+            munmap((void*)Data, Size);
+        if (file >= 0)
+            close(file);
+        file = -1;
+#endif
+        Data = nullptr;
+        Size = 0;
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#else
+    int file = -1;
+#endif
+};
+
+// where the time of the last LoadMeshFile went
+struct MeshLoadStats
+{
+    double MapMs = 0.0;
+    double UploadMs = 0.0;
+    size_t FileBytes = 0;
+};
+
+// checks that the header is ours and that both sections lie inside the file
+inline bool ValidateMeshFile(const uint8_t* data, size_t size, const MeshFileHeader*& header)
+{
+    if (size < sizeof(MeshFileHeader))
+        return false;
+    header = (const MeshFileHeader*)data;
+    if (memcmp(header->Magic, MESH_FILE_MAGIC, 4) != 0 || header->Version != MESH_FILE_VERSION)
+        return false;
+    if (header->AttributeCount == 0 || header->AttributeCount > MESH_FILE_MAX_ATTRIBUTES)
+        return false;
+    if (header->IndexSize != 2 && header->IndexSize != 4)
+        return false;
+    if ((uint64_t)header->VertexCount * header->VertexStride != header->VertexBytes ||
+        (uint64_t)header->IndexCount * header->IndexSize != header->IndexBytes)
+        return false;
+    return header->VertexOffset + header->VertexBytes <= size && header->IndexOffset + header->IndexBytes <= size;
+}
+
+// maps a cooked mesh and uploads it; no per-vertex work happens on the CPU
+inline bool LoadMeshFile(const std::string& path, Mesh& mesh, MeshLoadStats* stats = nullptr)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    MappedFile file;
+    if (!file.Open(path))
+        return false;
+    const MeshFileHeader* header = nullptr;
+    if (!ValidateMeshFile(file.Data, file.Size, header))
+    {
+        file.Close();
+        return false;
+    }
+
+    VertexLayout layout;
+    for (uint32_t i = 0; i < header->AttributeCount; ++i)
+    {
+        const MeshFileAttribute& attribute = header->Attributes[i];
+        VertexAttribute entry = { (VertexSemantic)attribute.Semantic, (GLint)attribute.Components, (GLenum)attribute.Type,
+                                  (GLboolean)(attribute.Normalized ? GL_TRUE : GL_FALSE), attribute.Offset };
+        layout.Attributes.push_back(entry);
+    }
+    layout.Stride = (GLsizei)header->VertexStride;
+    auto mapped = std::chrono::high_resolution_clock::now();
+
+    mesh.Init(file.Data + header->VertexOffset, (size_t)header->VertexBytes, file.Data + header->IndexOffset,
+              (GLsizei)header->IndexCount, header->IndexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, layout);
+    glm::mat4 dequantize(header->PositionScale);
+    dequantize[3] = glm::vec4(header->PositionOffset[0], header->PositionOffset[1], header->PositionOffset[2], 1.0f);
+    mesh.Dequantize = dequantize;
+    auto uploaded = std::chrono::high_resolution_clock::now();
+
+    if (stats)
+    {
+        stats->MapMs = std::chrono::duration<double, std::milli>(mapped - start).count();
+        stats->UploadMs = std::chrono::duration<double, std::milli>(uploaded - mapped).count();
+        stats->FileBytes = file.Size;
+    }
+    file.Close();
+    return true;
+}
+#endif
@@ -0,0 +1,180 @@
+#ifndef NET_SOCKET_H
+#define NET_SOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Non-blocking IPv4 UDP sockets, just enough for the replication layer
+
+// address and port in host byte order
+struct NetAddress
+{
+    uint32_t Ip = 0;
+    uint16_t Port = 0;
+
+    bool operator==(const NetAddress& other) const { return Ip == other.Ip && Port == other.Port; }
+    bool operator!=(const NetAddress& other) const { return !(*this == other); }
+
+    static NetAddress Loopback(uint16_t port)
+    {
+        NetAddress address;
+        address.Ip = 0x7F000001u;
+        address.Port = port;
+        return address;
+    }
+
+    // "a.b.c.d:port"; false if the text isn't one
+    static bool Parse(const char* text, NetAddress& address)
+    {
+        const char* colon = strrchr(text, ':');
+        if (!colon || colon - text >= 16)
+            return false;
+        char ip[16];
+        memcpy(ip, text, colon - text);
+        ip[colon - text] = 0;
+        in_addr parsed;
+        int port = atoi(colon + 1);
+        if (inet_pton(AF_INET, ip, &parsed) != 1 || port <= 0 || port > 65535)
+            return false;
+        address.Ip = ntohl(parsed.s_addr);
+        address.Port = (uint16_t)port;
+        return true;
+    }
+};
+
+class UdpSocket
+{
+public:
+    // port 0 lets the system pick one; GetPort() tells which
+    bool Open(uint16_t port = 0)
+    {
+#ifdef _WIN32
+        WSADATA data;
+        if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+            return false;
+        started = true;
+#endif
+        handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (handle == INVALID)
+        {
+            Close();
+            return false;
+        }
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (bind(handle, (const sockaddr*)&address, sizeof(address)) != 0)
+        {
+            Close();
+            return false;
+        }
+
+        // a full snapshot to many clients goes out in one burst, so give both directions room
+        int bufferBytes = 4 << 20;
+        setsockopt(handle, SOL_SOCKET, SO_SNDBUF, (const char*)&bufferBytes, sizeof(bufferBytes));
+        setsockopt(handle, SOL_SOCKET, SO_RCVBUF, (const char*)&bufferBytes, sizeof(bufferBytes));
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        if (ioctlsocket(handle, FIONBIO, &nonBlocking) != 0)
+#else
+        if (fcntl(handle, F_SETFL, fcntl(handle, F_GETFL, 0) | O_NONBLOCK) != 0)
+#endif
+        {
+            Close();
+            return false;
+        }
+
+        sockaddr_in bound;
+        socklen_t length = sizeof(bound);
+        getsockname(handle, (sockaddr*)&bound, &length);
+        boundPort = ntohs(bound.sin_port);
+        return true;
+    }
+
+    void Close()
+    {
+        if (handle != INVALID)
+        {
+#ifdef _WIN32
+            closesocket(handle);
+#else
+            close(handle);
+#endif
+        }
+        handle = INVALID;
+#ifdef _WIN32
+        if (started)
+            WSACleanup();
+        started = false;
+#endif
+    }
+
+    bool IsOpen() const
+    {
+        return handle != INVALID;
+    }
+
+    uint16_t GetPort() const
+    {
+        return boundPort;
+    }
+
+    bool Send(const NetAddress& to, const void* data, size_t size)
+    {
+        sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(to.Ip);
+        address.sin_port = htons(to.Port);
+        return sendto(handle, (const char*)data, (int)size, 0, (const sockaddr*)&address, sizeof(address)) == (int)size;
+    }
+
+    // bytes of the next datagram, or -1 when nothing is waiting
+    int Receive(NetAddress& from, void* data, size_t capacity)
+    {
+        sockaddr_in address;
+        socklen_t length = sizeof(address);
+        int received = (int)recvfrom(handle, (char*)data, (int)capacity, 0, (sockaddr*)&address, &length);
+        if (received < 0)
+            return -1;
+        from.Ip = ntohl(address.sin_addr.s_addr);
+        from.Port = ntohs(address.sin_port);
+        return received;
+    }
+
+private:
+#ifdef _WIN32
+    typedef SOCKET Handle;
+    typedef int socklen_t;
+    static const Handle INVALID = INVALID_SOCKET;
+    bool started = false;
+#else
+    typedef int Handle;
+    static const Handle INVALID = -1;
+#endif
+    Handle handle = INVALID;
+    uint16_t boundPort = 0;
+};
+#endif
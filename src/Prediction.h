@@ -0,0 +1,174 @@
+#ifndef PREDICTION_H
+#define PREDICTION_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "CharacterController.h"
+#include "Collision.h"
+#include "Replication.h"
+
+// Client-side prediction of the local player. Each tick's input is stamped with the tick number,
+// kept in a ring buffer and applied at once, so walking answers the keys immediately whatever the
+// latency. When the server reports where the player is after one of those commands, the prediction
+// made for that tick is checked against it. On a mismatch the player restarts from the server's
+// state and the commands the server hasn't applied yet are replayed. Only those are replayed, so a
+// correction costs about a round trip of ticks however large the buffer is.
+
+struct PredictionStats
+{
+    // server states that matched the prediction, and ones that didn't
+    unsigned int Confirmations = 0;
+    unsigned int Corrections = 0;
+    // commands the server hasn't applied yet
+    uint32_t Pending = 0;
+    // of the last correction
+    float LastError = 0.0f;
+    uint32_t LastReplayTicks = 0;
+    double LastReplayMs = 0.0;
+    uint32_t MaxReplayTicks = 0;
+    double MaxReplayMs = 0.0;
+};
+
+class PlayerPrediction
+{
+public:
+    // ticks of commands and predictions kept; 4 s at 60 Hz, far more than any round trip
+    static constexpr uint32_t HISTORY = 256;
+
+    // predictions within this distance of the server's count as right
+    float Tolerance = 0.001f;
+    // a correction replays at most this many commands, the newest ones
+    uint32_t MaxReplay = 64;
+    // corrections shorter than this are blended out instead of jumping; longer ones snap
+    float SmoothDistance = 1.0f;
+    // how fast the remaining correction fades, per second
+    float SmoothRate = 15.0f;
+    CharacterController Player;
+    PredictionStats Stats;
+
+    // forgets every command, e.g. after teleporting the player
+    void Reset()
+    {
+        confirmedTick = NO_TICK;
+        smoothing = glm::vec3(0.0f);
+        Stats.Pending = 0;
+    }
+
+    // stamps the input with the next tick and moves the player with it right away
+    const InputCommand& Predict(const PlayerInput& input, float tickSeconds, const CollisionWorld& world)
+    {
+        InputCommand& command = commands[nextTick % HISTORY];
+        command.Tick = nextTick;
+        command.Input = input;
+        Player.Move(input, tickSeconds, world);
+        store(nextTick);
+        nextTick++;
+        Stats.Pending = getPending();
+        smoothing *= std::exp(-SmoothRate * tickSeconds);
+        return command;
+    }
+
+    // up to max of the commands the server hasn't applied yet, oldest first; returns how many
+    size_t GetUnconfirmed(InputCommand* out, size_t max) const
+    {
+        uint32_t count = (uint32_t)std::min<size_t>(getPending(), max);
+        for (uint32_t i = 0; i < count; ++i)
+            out[i] = commands[(nextTick - count + i) % HISTORY];
+        return count;
+    }
+
+    // checks a state from the server against what was predicted for its tick, replays on a mismatch
+    void Reconcile(const PlayerState& state, float tickSeconds, const CollisionWorld& world)
+    {
+        // stale, reordered, or for a command this client never sent
+        if (state.InputTick == NO_TICK || (int32_t)(nextTick - state.InputTick) <= 0)
+            return;
+        if (confirmedTick != NO_TICK && (int32_t)(state.InputTick - confirmedTick) <= 0)
+            return;
+        confirmedTick = state.InputTick;
+        Stats.Pending = getPending();
+
+        const Predicted& predicted = predictions[state.InputTick % HISTORY];
+        float error = glm::length(predicted.Position - state.Position);
+        bool matches = nextTick - state.InputTick <= HISTORY && error <= Tolerance &&
+                       glm::length(predicted.Velocity - state.Velocity) * tickSeconds <= Tolerance &&
+                       predicted.OnGround == state.OnGround;
+        if (matches)
+        {
+            Stats.Confirmations++;
+            return;
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        glm::vec3 shown = Player.Position + smoothing;
+        Player.Position = state.Position;
+        Player.Velocity = state.Velocity;
+        Player.OnGround = state.OnGround;
+        store(state.InputTick);
+        uint32_t replay = std::min(Stats.Pending, MaxReplay);
+        for (uint32_t tick = nextTick - replay; tick != nextTick; ++tick)
+        {
+            Player.Move(commands[tick % HISTORY].Input, tickSeconds, world);
+            store(tick);
+        }
+
+        // keep drawing the player where it was and let the difference fade
+        glm::vec3 correction = shown - Player.Position;
+        smoothing = glm::length(correction) < SmoothDistance ? correction : glm::vec3(0.0f);
+
+        Stats.Corrections++;
+        Stats.LastError = error;
+        Stats.LastReplayTicks = replay;
+        Stats.LastReplayMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        Stats.MaxReplayTicks = std::max(Stats.MaxReplayTicks, replay);
+        Stats.MaxReplayMs = std::max(Stats.MaxReplayMs, Stats.LastReplayMs);
+    }
+
+    // where to draw the player: the prediction plus what is left of the last correction
+    glm::vec3 GetSmoothedPosition() const
+    {
+        return Player.Position + smoothing;
+    }
+
+    glm::vec3 GetSmoothedEyePosition() const
+    {
+        return Player.GetEyePosition() + smoothing;
+    }
+
+private:
+    struct Predicted
+    {
+        glm::vec3 Position = glm::vec3(0.0f);
+        glm::vec3 Velocity = glm::vec3(0.0f);
+        bool OnGround = false;
+    };
+
+    InputCommand commands[HISTORY];
+    // the player's state after each command
+    Predicted predictions[HISTORY];
+    uint32_t nextTick = 0;
+    // newest command the server has applied
+    uint32_t confirmedTick = NO_TICK;
+    glm::vec3 smoothing = glm::vec3(0.0f);
+
+    uint32_t getPending() const
+    {
+        uint32_t pending = confirmedTick == NO_TICK ? nextTick : nextTick - 1 - confirmedTick;
+        return std::min(pending, HISTORY);
+    }
+
+    void store(uint32_t tick)
+    {
+        Predicted& predicted = predictions[tick % HISTORY];
+        predicted.Position = Player.Position;
+        predicted.Velocity = Player.Velocity;
+        predicted.OnGround = Player.OnGround;
+    }
+};
+#endif
@@ -0,0 +1,212 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Phases of one frame, in the order the main loop runs them
+enum ProfilePhase
+{
+    PHASE_INPUT = 0,
+    PHASE_IMGUI_BUILD,
+    PHASE_SCENE,
+    PHASE_IMGUI_RENDER,
+    PHASE_SWAP,
+    PHASE_COUNT
+};
+
+inline const char* GetProfilePhaseName(int phase)
+{
+    static const char* names[PHASE_COUNT] = { "Input", "ImGui Build", "Scene", "ImGui Render", "Swap" };
+    return phase >= 0 && phase < PHASE_COUNT ? names[phase] : "?";
+}
+
+// GPU-only ranges inside a phase. They use timestamp queries, which unlike GL_TIME_ELAPSED can sit
+// inside a phase's query; a range that was not issued in a frame reads as 0.
+enum ProfileRange
+{
+    RANGE_SHADOW_CASCADE_0 = 0,
+    RANGE_SHADOW_CASCADE_1,
+    RANGE_SHADOW_CASCADE_2,
+    RANGE_SHADOW_CASCADE_3,
+    RANGE_COUNT
+};
+
+inline const char* GetProfileRangeName(int range)
+{
+    static const char* names[RANGE_COUNT] = { "Shadow 0", "Shadow 1", "Shadow 2", "Shadow 3" };
+    return range >= 0 && range < RANGE_COUNT ? names[range] : "?";
+}
+
+// Last resolved timings of one phase
+struct PhaseTiming
+{
+    double CpuMs = 0.0;
+    double GpuMs = 0.0;
+};
+
+// CPU timers around each phase plus GL_TIME_ELAPSED queries for the GPU side. Queries are
+// double-buffered: the set written this frame is read back a frame later, and only once the driver
+// reports it available, so the readback never waits on the GPU.
+class Profiler
+{
+public:
+    static const int QUERY_SETS = 2;
+    static const int HISTORY_SIZE = 240;
+
+    PhaseTiming Phases[PHASE_COUNT];
+    double RangeGpuMs[RANGE_COUNT] = {};
+    // whole-frame CPU time, rolling; HistoryOffset is the oldest sample, as PlotLines expects
+    float History[HISTORY_SIZE] = {};
+    int HistoryOffset = 0;
+    int HistoryCount = 0;
+    double GpuFrameMs = 0.0;
+    // times a query set was still pending when its slot came round again
+    unsigned int MissedReadbacks = 0;
+
+    void Init()
+    {
+        glGenQueries(QUERY_SETS * PHASE_COUNT, &queries[0][0]);
+        glGenQueries(QUERY_SETS * RANGE_COUNT * 2, &rangeQueries[0][0][0]);
+        frameStart = std::chrono::high_resolution_clock::now();
+    }
+
+    void Delete()
+    {
+        glDeleteQueries(QUERY_SETS * PHASE_COUNT, &queries[0][0]);
+        glDeleteQueries(QUERY_SETS * RANGE_COUNT * 2, &rangeQueries[0][0][0]);
+    }
+
+    // closes the previous frame and starts a new one
+    void BeginFrame()
+    {
+        auto now = std::chrono::high_resolution_clock::now();
+        if (frameIndex > 0)
+            pushHistory((float)std::chrono::duration<double, std::milli>(now - frameStart).count());
+        frameStart = now;
+
+        // the set about to be reused was issued QUERY_SETS frames ago
+        current = frameIndex % QUERY_SETS;
+        if (frameIndex >= QUERY_SETS)
+            resolve(current);
+        for (int range = 0; range < RANGE_COUNT; ++range)
+            rangeIssued[current][range] = false;
+        frameIndex++;
+    }
+
+    void Begin(ProfilePhase phase)
+    {
+        phaseStart[phase] = std::chrono::high_resolution_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, queries[current][phase]);
+    }
+
+    void End(ProfilePhase phase)
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        auto end = std::chrono::high_resolution_clock::now();
+        Phases[phase].CpuMs = std::chrono::duration<double, std::milli>(end - phaseStart[phase]).count();
+    }
+
+    void BeginRange(ProfileRange range)
+    {
+        glQueryCounter(rangeQueries[current][range][0], GL_TIMESTAMP);
+    }
+
+    void EndRange(ProfileRange range)
+    {
+        glQueryCounter(rangeQueries[current][range][1], GL_TIMESTAMP);
+        rangeIssued[current][range] = true;
+    }
+
+    // percentile (0..100) of the frame time history in ms
+    float Percentile(float percent) const
+    {
+        if (HistoryCount == 0)
+            return 0.0f;
+        sorted.assign(History, History + HistoryCount);
+        size_t rank = (size_t)(percent / 100.0f * (HistoryCount - 1) + 0.5f);
+        std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+        return sorted[rank];
+    }
+
+private:
+    GLuint queries[QUERY_SETS][PHASE_COUNT] = {};
+    GLuint rangeQueries[QUERY_SETS][RANGE_COUNT][2] = {};
+    bool rangeIssued[QUERY_SETS][RANGE_COUNT] = {};
+    std::chrono::high_resolution_clock::time_point phaseStart[PHASE_COUNT];
+    std::chrono::high_resolution_clock::time_point frameStart;
+    unsigned long long frameIndex = 0;
+    int current = 0;
+    mutable std::vector<float> sorted;
+
+    void pushHistory(float ms)
+    {
+        if (HistoryCount < HISTORY_SIZE)
+        {
+            History[HistoryCount++] = ms;
+            return;
+        }
+        History[HistoryOffset] = ms;
+        HistoryOffset = (HistoryOffset + 1) % HISTORY_SIZE;
+    }
+
+    // reads the set back if the GPU is done with it, otherwise keeps the previous values
+    void resolve(int set)
+    {
+        // queries complete in order, so the last one being ready means all of them are
+        GLint available = 0;
+        glGetQueryObjectiv(queries[set][PHASE_COUNT - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            MissedReadbacks++;
+            return;
+        }
+
+        GpuFrameMs = 0.0;
+        for (int phase = 0; phase < PHASE_COUNT; ++phase)
+        {
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[set][phase], GL_QUERY_RESULT, &elapsed);
+            Phases[phase].GpuMs = elapsed / 1.0e6;
+            GpuFrameMs += Phases[phase].GpuMs;
+        }
+
+        // ranges end before the last phase does, so they are complete too
+        for (int range = 0; range < RANGE_COUNT; ++range)
+        {
+            RangeGpuMs[range] = 0.0;
+            if (!rangeIssued[set][range])
+                continue;
+            GLuint64 begin = 0, end = 0;
+            glGetQueryObjectui64v(rangeQueries[set][range][0], GL_QUERY_RESULT, &begin);
+            glGetQueryObjectui64v(rangeQueries[set][range][1], GL_QUERY_RESULT, &end);
+            RangeGpuMs[range] = (end - begin) / 1.0e6;
+        }
+    }
+};
+
+// Times the enclosing block as one phase
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler& profiler, ProfilePhase phase) : profiler(profiler), phase(phase)
+    {
+        profiler.Begin(phase);
+    }
+
+    ~ProfileScope()
+    {
+        profiler.End(phase);
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& profiler;
+    ProfilePhase phase;
+};
+#endif
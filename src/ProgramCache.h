@@ -0,0 +1,255 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "GLExtensions.h"
+#include "Shader.h"
+
+// FNV-1a, 64 bit, continued from a previous hash so several strings can be chained
+inline uint64_t HashProgramSource(const std::string& text, uint64_t hash = 14695981039346656037ull)
+{
+    for (unsigned char c : text)
+    {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // separator so ("ab", "c") and ("a", "bc") hash differently
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+// inserts #define lines right after the #version line
+inline std::string InjectShaderDefines(const std::string& source, const std::string& defines)
+{
+    if (defines.empty())
+        return source;
+    size_t version = source.find("#version");
+    size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return defines + "\n" + source;
+    return source.substr(0, lineEnd + 1) + defines + "\n" + source.substr(lineEnd + 1);
+}
+
+struct ProgramCacheStats
+{
+    unsigned int Hits = 0;
+    unsigned int Misses = 0;
+    unsigned int Rejected = 0; // cache entries the driver refused, e.g. after a driver update
+    double LoadMs = 0.0;
+};
+
+// Keeps linked program binaries on disk, keyed by the sources, defines and driver, so later launches
+// skip GLSL compilation. Anything that fails to load is compiled normally and the entry rewritten.
+class ProgramCache
+{
+public:
+    ProgramCacheStats Stats;
+
+    // returns false (and compiles every time) when the driver cannot save program binaries
+    bool Init(const std::string& directory)
+    {
+        if (!GetGLExtensions().ProgramBinary)
+            return false;
+
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (!std::filesystem::is_directory(directory, error))
+            return false;
+
+        this->directory = directory;
+        driver = std::string((const char*)glGetString(GL_VENDOR)) + "|" +
+                 (const char*)glGetString(GL_RENDERER) + "|" + (const char*)glGetString(GL_VERSION);
+        enabled = true;
+        return true;
+    }
+
+    bool IsEnabled() const
+    {
+        return enabled;
+    }
+
+    // a linked program for the sources, loaded from the cache when possible
+    Shader Load(const std::string& vertexSrc, const std::string& fragmentSrc, const std::string& defines = "")
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        std::string vertex = InjectShaderDefines(vertexSrc, defines);
+        std::string fragment = InjectShaderDefines(fragmentSrc, defines);
+
+        Shader shader;
+        if (!enabled)
+        {
+            shader = Shader(vertex, fragment);
+            Stats.Misses++;
+        }
+        else
+        {
+            uint64_t key = HashProgramSource(driver, HashProgramSource(fragment, HashProgramSource(vertex)));
+            std::string path = entryPath(key);
+
+            GLuint program = loadBinary(path, key);
+            if (program)
+            {
+                shader = Shader(program);
+                Stats.Hits++;
+            }
+            else
+            {
+                // a missing or rejected entry is rebuilt from source, never returned empty
+                shader = compile(vertex, fragment);
+                if (shader.ID)
+                    saveBinary(path, key, shader.ID);
+                Stats.Misses++;
+            }
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.LoadMs += std::chrono::duration<double, std::milli>(end - start).count();
+        return shader;
+    }
+
+private:
+    // file layout: header, then the driver's binary blob
+    struct EntryHeader
+    {
+        uint32_t Magic;
+        uint32_t Format;
+        uint64_t Key;
+        uint32_t Length;
+        uint32_t Padding;
+    };
+    static const uint32_t ENTRY_MAGIC = 0x47455042; // "GEPB"
+
+    std::string directory;
+    std::string driver;
+    bool enabled = false;
+
+    std::string entryPath(uint64_t key) const
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return (std::filesystem::path(directory) / name).string();
+    }
+
+    GLuint loadBinary(const std::string& path, uint64_t key)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open())
+            return 0;
+
+        EntryHeader header;
+        std::vector<char> blob;
+        if (file.read((char*)&header, sizeof(header)) && header.Magic == ENTRY_MAGIC && header.Key == key)
+        {
+            blob.resize(header.Length);
+            if (!file.read(blob.data(), header.Length))
+                blob.clear();
+        }
+        if (blob.empty())
+        {
+            file.close();
+            reject(path);
+            return 0;
+        }
+
+        GLuint program = glCreateProgram();
+        GetGLExtensions().ProgramBinaryLoad(program, header.Format, blob.data(), (GLsizei)blob.size());
+        // a format the driver no longer knows raises GL_INVALID_ENUM; it is handled here, not later
+        while (glGetError() != GL_NO_ERROR) {}
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            glDeleteProgram(program);
+            file.close();
+            reject(path);
+            return 0;
+        }
+        return program;
+    }
+
+    // drops an entry the driver refused, so it is rebuilt from source and can't be tried again
+    void reject(const std::string& path)
+    {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+        Stats.Rejected++;
+    }
+
+    // same as the Shader constructor, but asks the driver to keep the binary retrievable
+    static Shader compile(const std::string& vertexSrc, const std::string& fragmentSrc)
+    {
+        GLuint vertex = compileStage(GL_VERTEX_SHADER, vertexSrc);
+        GLuint fragment = compileStage(GL_FRAGMENT_SHADER, fragmentSrc);
+
+        GLuint program = glCreateProgram();
+        GetGLExtensions().ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            char info[512];
+            glGetProgramInfoLog(program, 512, nullptr, info);
+            std::cerr << "Shader link error: " << info << std::endl;
+            glDeleteProgram(program);
+            return Shader();
+        }
+        return Shader(program);
+    }
+
+    static GLuint compileStage(GLenum type, const std::string& source)
+    {
+        GLuint shader = glCreateShader(type);
+        const char* src = source.c_str();
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+
+        int success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            char info[512];
+            glGetShaderInfoLog(shader, 512, nullptr, info);
+            std::cerr << "Shader compile error: " << info << std::endl;
+        }
+        return shader;
+    }
+
+    void saveBinary(const std::string& path, uint64_t key, GLuint program) const
+    {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+
+        std::vector<char> blob(length);
+        GLenum format = 0;
+        GetGLExtensions().GetProgramBinary(program, length, nullptr, &format, blob.data());
+
+        EntryHeader header = { ENTRY_MAGIC, format, key, (uint32_t)length, 0 };
+        // written to a temporary first so a crash never leaves a truncated entry behind
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.write((const char*)&header, sizeof(header)) || !file.write(blob.data(), blob.size()))
+                return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+    }
+};
+#endif
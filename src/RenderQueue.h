@@ -0,0 +1,261 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "InstancedRenderer.h"
+#include "Mesh.h"
+#include "Shader.h"
+
+// Passes run in this order; within a pass items are grouped by state
+enum RenderPass
+{
+    PASS_OPAQUE      = 0,
+    PASS_TRANSPARENT = 1
+};
+
+// Uniform values applied once per material change
+struct Material
+{
+    glm::vec4 Tint = glm::vec4(1.0f);
+};
+
+// One draw, fully described so the queue can reorder it freely
+struct DrawItem
+{
+    uint64_t Key = 0;
+    Shader* Program = nullptr;
+    GLuint VAO = 0;
+    GLsizei IndexCount = 0;
+    GLenum IndexType = GL_UNSIGNED_SHORT;
+    GLsizei InstanceCount = 0; // 0 = plain draw using Model, otherwise instanced
+    uint32_t MaterialId = 0;
+    glm::mat4 Model = glm::mat4(1.0f);
+};
+
+// State changes caused by a sequence of draws, counted for the submission order and the sorted order
+struct StateChangeCounts
+{
+    unsigned int Programs = 0;
+    unsigned int VAOs = 0;
+    unsigned int Materials = 0;
+
+    unsigned int Total() const { return Programs + VAOs + Materials; }
+};
+
+// Sort key layout, most significant first:
+//   opaque:      pass (4) | program (12) | material (16) | vao (16) | depth (16)
+//   transparent: pass (4) | far-to-near depth (16) | program (12) | material (16) | vao (16)
+// so a sorted opaque pass binds each program once, then each material, then each VAO, and transparent
+// surfaces blend back to front, grouped by state only where their depths tie.
+inline uint64_t MakeSortKey(RenderPass pass, GLuint program, uint32_t material, GLuint vao, float depth01)
+{
+    uint64_t depthBits = (uint64_t)(glm::clamp(depth01, 0.0f, 1.0f) * 65535.0f);
+    uint64_t state = ((uint64_t)(program & 0xFFF) << 32) |
+                     ((uint64_t)(material & 0xFFFF) << 16) |
+                     (uint64_t)(vao & 0xFFFF);
+    if (pass == PASS_TRANSPARENT)
+        return ((uint64_t)(pass & 0xF) << 60) | ((65535 - depthBits) << 44) | state;
+    return ((uint64_t)(pass & 0xF) << 60) | (state << 16) | depthBits;
+}
+
+// Collects draw items during the frame, radix-sorts them by key and submits them with the minimum
+// number of program/material/VAO changes
+class RenderQueue
+{
+public:
+    std::vector<Material> Materials = { Material() };
+
+    StateChangeCounts UnsortedChanges;
+    StateChangeCounts SortedChanges;
+    double SortMs = 0.0;
+    size_t ItemCount = 0;
+
+    // camera used for the depth part of the key, set once per frame before submitting
+    void Begin(const glm::vec3& cameraPosition, float farPlane)
+    {
+        items.clear();
+        eye = cameraPosition;
+        depthScale = farPlane > 0.0f ? 1.0f / farPlane : 0.0f;
+    }
+
+    void Submit(const Mesh& mesh, Shader& program, uint32_t material, const glm::mat4& model, RenderPass pass = PASS_OPAQUE)
+    {
+        DrawItem item;
+        item.Program = &program;
+        item.VAO = mesh.VAO;
+        item.IndexCount = mesh.IndexCount;
+        item.IndexType = mesh.IndexType;
+        item.MaterialId = material;
+        item.Model = model;
+        float depth = glm::length(glm::vec3(model[3]) - eye) * depthScale;
+        item.Key = MakeSortKey(pass, program.ID, material, mesh.VAO, depth);
+        items.push_back(item);
+    }
+
+    // every instance of the batch in one item; the batch must already be uploaded
+    void SubmitInstanced(const Mesh& mesh, const InstanceBatch& batch, Shader& program, uint32_t material, RenderPass pass = PASS_OPAQUE)
+    {
+        if (batch.GetUploadedCount() == 0)
+            return;
+        DrawItem item;
+        item.Program = &program;
+        item.VAO = batch.GetVAO();
+        item.IndexCount = mesh.IndexCount;
+        item.IndexType = mesh.IndexType;
+        item.InstanceCount = batch.GetUploadedCount();
+        item.MaterialId = material;
+        item.Key = MakeSortKey(pass, program.ID, material, item.VAO, 0.0f);
+        items.push_back(item);
+    }
+
+    // sorts and submits everything queued since Begin()
+    void Execute()
+    {
+        ItemCount = items.size();
+        UnsortedChanges = countChanges(nullptr);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        radixSort();
+        auto end = std::chrono::high_resolution_clock::now();
+        SortMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        SortedChanges = countChanges(order.data());
+        auto submitStart = std::chrono::high_resolution_clock::now();
+
+        Shader* currentProgram = nullptr;
+        GLuint currentVAO = 0;
+        uint32_t currentMaterial = 0xFFFFFFFFu;
+        UniformHandle modelLoc = INVALID_UNIFORM, tintLoc = INVALID_UNIFORM;
+        RenderStats& stats = GetRenderStats();
+
+        for (uint32_t index : order)
+        {
+            const DrawItem& item = items[index];
+            if (item.Program != currentProgram)
+            {
+                currentProgram = item.Program;
+                currentProgram->Use();
+                modelLoc = currentProgram->FindUniform("model");
+                tintLoc = currentProgram->FindUniform("tint");
+                currentMaterial = 0xFFFFFFFFu;
+            }
+            if (item.MaterialId != currentMaterial)
+            {
+                currentMaterial = item.MaterialId;
+                const Material& material = currentMaterial < Materials.size() ? Materials[currentMaterial] : Materials[0];
+                currentProgram->SetVec4(tintLoc, material.Tint);
+            }
+            if (item.VAO != currentVAO)
+            {
+                currentVAO = item.VAO;
+                glBindVertexArray(currentVAO);
+            }
+
+            if (item.InstanceCount > 0)
+            {
+                glDrawElementsInstanced(GL_TRIANGLES, item.IndexCount, item.IndexType, (void*)0, item.InstanceCount);
+                stats.Instances += (unsigned int)item.InstanceCount;
+            }
+            else
+            {
+                currentProgram->SetMat4(modelLoc, item.Model);
+                glDrawElements(GL_TRIANGLES, item.IndexCount, item.IndexType, (void*)0);
+            }
+            stats.DrawCalls++;
+        }
+        glBindVertexArray(0);
+
+        auto submitEnd = std::chrono::high_resolution_clock::now();
+        stats.SubmitMs += std::chrono::duration<double, std::milli>(submitEnd - submitStart).count();
+    }
+
+private:
+    std::vector<DrawItem> items;
+    std::vector<uint32_t> order;
+    std::vector<uint64_t> keys;
+    std::vector<uint64_t> scratchKeys;
+    std::vector<uint32_t> scratchOrder;
+    glm::vec3 eye = glm::vec3(0.0f);
+    float depthScale = 0.0f;
+
+    // LSD radix sort on 8-bit digits. Passes where every key has the same digit are skipped, which
+    // is most of the high bits for a typical scene.
+    void radixSort()
+    {
+        const size_t count = items.size();
+        keys.resize(count);
+        order.resize(count);
+        scratchKeys.resize(count);
+        scratchOrder.resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            keys[i] = items[i].Key;
+            order[i] = (uint32_t)i;
+        }
+        if (count < 2)
+            return;
+
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t histogram[256] = {};
+            for (uint64_t key : keys)
+                histogram[(key >> shift) & 0xFF]++;
+            if (histogram[(keys[0] >> shift) & 0xFF] == count)
+                continue;
+
+            size_t offset = 0;
+            for (size_t& bucket : histogram)
+            {
+                size_t bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                size_t destination = histogram[(keys[i] >> shift) & 0xFF]++;
+                scratchKeys[destination] = keys[i];
+                scratchOrder[destination] = order[i];
+            }
+            keys.swap(scratchKeys);
+            order.swap(scratchOrder);
+        }
+    }
+
+    // counts the state changes the given order would cause (nullptr = submission order)
+    StateChangeCounts countChanges(const uint32_t* sequence) const
+    {
+        StateChangeCounts counts;
+        const Shader* program = nullptr;
+        GLuint vao = 0;
+        uint32_t material = 0xFFFFFFFFu;
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            const DrawItem& item = items[sequence ? sequence[i] : i];
+            if (item.Program != program)
+            {
+                program = item.Program;
+                material = 0xFFFFFFFFu;
+                counts.Programs++;
+            }
+            if (item.MaterialId != material)
+            {
+                material = item.MaterialId;
+                counts.Materials++;
+            }
+            if (item.VAO != vao)
+            {
+                vao = item.VAO;
+                counts.VAOs++;
+            }
+        }
+        return counts;
+    }
+};
+#endif
@@ -0,0 +1,664 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "BitStream.h"
+#include "CharacterController.h"
+#include "Interest.h"
+#include "NetSocket.h"
+#include "Snapshot.h"
+
+// Server -> client state replication over UDP. Every tick the server sends each client the
+// snapshot delta-compressed against the newest one that client acknowledged; clients ack every
+// snapshot they decode. Lost packets are never resent, the next snapshot simply carries the change
+// again against an older baseline. Snapshots larger than one datagram are split into fragments.
+//
+// The other way, clients send their player's input commands stamped with their own tick number.
+// The server applies one per tick and reports back where the player ended up and after which
+// command, which is what client-side prediction (Prediction.h) reconciles against.
+//
+// With an InterestGrid the server sends each client only what is near its camera (Interest.h), so
+// every client has its own snapshots and baselines instead of sharing the full ones.
+
+enum NetMessage
+{
+    NET_MESSAGE_CONNECT = 1,
+    NET_MESSAGE_DISCONNECT,
+    NET_MESSAGE_SNAPSHOT,
+    NET_MESSAGE_ACK,
+    NET_MESSAGE_INPUT,
+    NET_MESSAGE_PLAYER_STATE
+};
+
+// snapshots this many ticks old can still serve as a baseline; older acks mean a full snapshot
+const uint32_t REPLICATION_HISTORY = 64;
+const uint32_t NO_TICK = 0xFFFFFFFFu;
+// payload per snapshot datagram, under a typical path MTU with the IP/UDP headers
+const uint32_t SNAPSHOT_FRAGMENT_BYTES = 1200;
+// message, tick, baseline tick, fragment index, fragment count
+const uint32_t SNAPSHOT_HEADER_BYTES = 1 + 4 + 4 + 2 + 2;
+const uint32_t MAX_SNAPSHOT_FRAGMENTS = 1024;
+// input commands per datagram; each one also repeats the ones before, so a lost datagram costs nothing
+const uint32_t INPUT_REDUNDANCY = 8;
+// tick, move x and z, jump
+const uint32_t INPUT_COMMAND_BYTES = 4 + 4 + 4 + 1;
+// commands the server holds per client; a client running ahead loses its oldest ones
+const uint32_t MAX_QUEUED_INPUTS = 8;
+// with more than this many queued the server applies two a tick until the queue is short again
+const uint32_t INPUT_CATCH_UP = 2;
+// message, input tick, position, velocity, on ground
+const uint32_t PLAYER_STATE_BYTES = 1 + 4 + 12 + 12 + 1;
+// message, tick, camera position
+const uint32_t ACK_BYTES = 1 + 4 + 12;
+
+// a player's input for one of its client's ticks
+struct InputCommand
+{
+    uint32_t Tick = 0;
+    PlayerInput Input;
+};
+
+// where the server has a client's player after applying that client's commands up to InputTick
+struct PlayerState
+{
+    uint32_t InputTick = NO_TICK;
+    glm::vec3 Position = glm::vec3(0.0f);
+    glm::vec3 Velocity = glm::vec3(0.0f);
+    bool OnGround = false;
+};
+
+// message fields are little-endian, like everything else we write to disk or wire
+inline void netWriteU32(uint8_t* p, uint32_t value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+inline void netWriteU16(uint8_t* p, uint16_t value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+inline uint32_t netReadU32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint16_t netReadU16(const uint8_t* p)
+{
+    uint16_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// floats go as their exact bits, so the client replays the very input the server applied
+inline void netWriteF32(uint8_t* p, float value)
+{
+    memcpy(p, &value, sizeof(value));
+}
+
+inline float netReadF32(const uint8_t* p)
+{
+    float value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline void WriteInputCommand(uint8_t* p, const InputCommand& command)
+{
+    netWriteU32(p, command.Tick);
+    netWriteF32(p + 4, command.Input.Move.x);
+    netWriteF32(p + 8, command.Input.Move.z);
+    p[12] = command.Input.Jump ? 1 : 0;
+}
+
+// false for a command the server must drop; see LimitPlayerInput
+inline bool ReadInputCommand(const uint8_t* p, InputCommand& command)
+{
+    command.Tick = netReadU32(p);
+    command.Input.Move = glm::vec3(netReadF32(p + 4), 0.0f, netReadF32(p + 8));
+    command.Input.Jump = p[12] != 0;
+    return LimitPlayerInput(command.Input);
+}
+
+struct ReplicationServerStats
+{
+    unsigned int Clients = 0;
+    // of the last Send, over all clients
+    size_t BytesSent = 0;
+    unsigned int PacketsSent = 0;
+    unsigned int FullSnapshots = 0;
+    double EncodeMs = 0.0;
+    // choosing each client's entities, included in EncodeMs
+    double InterestMs = 0.0;
+    // input commands dropped for a move that isn't finite, since the server started
+    unsigned int RejectedInputs = 0;
+};
+
+class ReplicationServer
+{
+public:
+    // clients silent for this long are dropped
+    float TimeoutSeconds = 5.0f;
+    // for testing: fraction of outgoing datagrams thrown away
+    float PacketLoss = 0.0f;
+    // optional; without it every client gets every entity every tick
+    InterestGrid* Interest = nullptr;
+    ReplicationServerStats Stats;
+
+    bool Start(uint16_t port)
+    {
+        for (Snapshot& snapshot : history)
+            snapshot.Tick = NO_TICK;
+        return socket.Open(port);
+    }
+
+    void Stop()
+    {
+        uint8_t message = NET_MESSAGE_DISCONNECT;
+        for (const Client& client : clients)
+            socket.Send(client.Address, &message, 1);
+        clients.clear();
+        socket.Close();
+    }
+
+    uint16_t GetPort() const
+    {
+        return socket.GetPort();
+    }
+
+    size_t GetClientCount() const
+    {
+        return clients.size();
+    }
+
+    // clients are addressed by index until the next Receive; the id stays the client's while it is connected
+    uint32_t GetClientId(size_t client) const
+    {
+        return clients[client].Id;
+    }
+
+    // the client's next command, oldest first; false when none has arrived in time for this tick
+    bool PopInput(size_t client, InputCommand& command)
+    {
+        Client& owner = clients[client];
+        if (owner.Inputs.empty())
+            return false;
+        command = owner.Inputs.front();
+        owner.Inputs.erase(owner.Inputs.begin());
+        owner.InputTick = command.Tick;
+        return true;
+    }
+
+    size_t GetQueuedInputs(size_t client) const
+    {
+        return clients[client].Inputs.size();
+    }
+
+    // tells the client where its player is after the last command popped for it
+    void SendPlayerState(size_t client, const CharacterController& player)
+    {
+        const Client& owner = clients[client];
+        if (owner.InputTick == NO_TICK)
+            return;
+        uint8_t message[PLAYER_STATE_BYTES];
+        message[0] = NET_MESSAGE_PLAYER_STATE;
+        netWriteU32(message + 1, owner.InputTick);
+        for (int k = 0; k < 3; ++k)
+        {
+            netWriteF32(message + 5 + 4 * k, player.Position[k]);
+            netWriteF32(message + 17 + 4 * k, player.Velocity[k]);
+        }
+        message[29] = player.OnGround ? 1 : 0;
+        socket.Send(owner.Address, message, sizeof(message));
+    }
+
+    // handles connects, disconnects, acks and input; call once per tick before Send
+    void Receive()
+    {
+        auto now = std::chrono::steady_clock::now();
+        NetAddress from;
+        uint8_t packet[2 + INPUT_REDUNDANCY * INPUT_COMMAND_BYTES];
+        static_assert(sizeof(packet) >= ACK_BYTES, "acks must fit the receive buffer");
+        int size;
+        while ((size = socket.Receive(from, packet, sizeof(packet))) > 0)
+        {
+            Client* client = findClient(from);
+            if (packet[0] == NET_MESSAGE_CONNECT && !client)
+            {
+                clients.push_back(Client());
+                client = &clients.back();
+                client->Address = from;
+                client->Id = nextClientId++;
+            }
+            if (!client)
+                continue;
+            client->LastHeard = now;
+            if (packet[0] == NET_MESSAGE_DISCONNECT)
+                client->LastHeard = std::chrono::steady_clock::time_point();
+            else if (packet[0] == NET_MESSAGE_ACK && size >= 5)
+            {
+                // acks can arrive out of order; only a newer one moves the baseline
+                uint32_t tick = netReadU32(packet + 1);
+                if (client->AckedTick == NO_TICK || (int32_t)(tick - client->AckedTick) > 0)
+                {
+                    client->AckedTick = tick;
+                    if (size >= (int)ACK_BYTES)
+                        readView(*client, packet + 5);
+                }
+            }
+            else if (packet[0] == NET_MESSAGE_INPUT && size >= 2 && size >= 2 + packet[1] * (int)INPUT_COMMAND_BYTES)
+                queueInputs(*client, packet + 2, packet[1]);
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [&](const Client& client) {
+            return std::chrono::duration<float>(now - client.LastHeard).count() > TimeoutSeconds;
+        }), clients.end());
+    }
+
+    // where the client looks from, for the interest grid; clients report it with their acks, this
+    // overrides it until the next one
+    void SetClientView(size_t client, const glm::vec3& position)
+    {
+        clients[client].View = position;
+    }
+
+    // sends every client this tick's snapshot (entities sorted by Id), delta-compressed against its
+    // last acknowledged one
+    void Send(const Snapshot& snapshot)
+    {
+        Snapshot& stored = history[snapshot.Tick % REPLICATION_HISTORY];
+        stored.Tick = snapshot.Tick;
+        stored.Entities = snapshot.Entities;
+
+        Stats = ReplicationServerStats();
+        Stats.Clients = (unsigned int)clients.size();
+        Stats.RejectedInputs = rejectedInputs;
+        if (Interest)
+        {
+            Interest->Build(snapshot);
+            Stats.InterestMs = Interest->Stats.BuildMs;
+        }
+        for (Client& client : clients)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+            const Snapshot* sent = &snapshot;
+            const Snapshot* sentHistory = history;
+            if (Interest)
+            {
+                // the client's own snapshots: what it was sent last fills in the entities not due
+                if (client.History.empty())
+                {
+                    client.History.resize(REPLICATION_HISTORY);
+                    for (Snapshot& old : client.History)
+                        old.Tick = NO_TICK;
+                }
+                const Snapshot* previous = nullptr;
+                if (client.SentTick != NO_TICK && client.History[client.SentTick % REPLICATION_HISTORY].Tick == client.SentTick)
+                    previous = &client.History[client.SentTick % REPLICATION_HISTORY];
+                Snapshot& selected = client.History[snapshot.Tick % REPLICATION_HISTORY];
+                if (previous == &selected)
+                    previous = nullptr;
+                double before = Interest->Stats.SelectMs;
+                Interest->Select(snapshot, client.View, previous, selected);
+                Stats.InterestMs += Interest->Stats.SelectMs - before;
+                client.SentTick = snapshot.Tick;
+                sent = &selected;
+                sentHistory = client.History.data();
+            }
+            const Snapshot* baseline = nullptr;
+            if (client.AckedTick != NO_TICK && snapshot.Tick - client.AckedTick < REPLICATION_HISTORY &&
+                sentHistory[client.AckedTick % REPLICATION_HISTORY].Tick == client.AckedTick)
+                baseline = &sentHistory[client.AckedTick % REPLICATION_HISTORY];
+            if (!baseline)
+                Stats.FullSnapshots++;
+            writer.Reset();
+            EncodeSnapshot(*sent, baseline, writer);
+            Stats.EncodeMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            sendFragments(client.Address, snapshot.Tick, baseline ? baseline->Tick : NO_TICK, writer.Bytes);
+        }
+    }
+
+private:
+    struct Client
+    {
+        NetAddress Address;
+        uint32_t Id = 0;
+        uint32_t AckedTick = NO_TICK;
+        std::chrono::steady_clock::time_point LastHeard;
+        // received but not yet applied, by tick
+        std::vector<InputCommand> Inputs;
+        // last command applied
+        uint32_t InputTick = NO_TICK;
+        // camera position, and the snapshots selected for it when there is an interest grid
+        glm::vec3 View = glm::vec3(0.0f);
+        std::vector<Snapshot> History;
+        uint32_t SentTick = NO_TICK;
+    };
+
+    UdpSocket socket;
+    std::vector<Client> clients;
+    uint32_t nextClientId = 0;
+    unsigned int rejectedInputs = 0;
+    Snapshot history[REPLICATION_HISTORY];
+    BitWriter writer;
+    std::vector<uint8_t> packet;
+    std::mt19937 lossRng{ 7 };
+
+    Client* findClient(const NetAddress& address)
+    {
+        for (Client& client : clients)
+            if (client.Address == address)
+                return &client;
+        return nullptr;
+    }
+
+    // the view comes straight off the wire: one that isn't finite keeps the last good one, the rest
+    // is clamped to where snapshot positions can be
+    static void readView(Client& client, const uint8_t* data)
+    {
+        const float limit = (float)INT32_MAX / SNAPSHOT_POSITION_SCALE;
+        glm::vec3 view;
+        for (int k = 0; k < 3; ++k)
+        {
+            view[k] = netReadF32(data + 4 * k);
+            if (!std::isfinite(view[k]))
+                return;
+            view[k] = std::min(limit, std::max(-limit, view[k]));
+        }
+        client.View = view;
+    }
+
+    // commands come oldest first and mostly repeat ones already queued; keep only the new ones
+    void queueInputs(Client& client, const uint8_t* data, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i, data += INPUT_COMMAND_BYTES)
+        {
+            InputCommand command;
+            bool valid = ReadInputCommand(data, command);
+            uint32_t newest = client.Inputs.empty() ? client.InputTick : client.Inputs.back().Tick;
+            if (newest != NO_TICK && (int32_t)(command.Tick - newest) <= 0)
+                continue;
+            if (!valid)
+            {
+                rejectedInputs++;
+                continue;
+            }
+            client.Inputs.push_back(command);
+        }
+        if (client.Inputs.size() > MAX_QUEUED_INPUTS)
+            client.Inputs.erase(client.Inputs.begin(), client.Inputs.end() - MAX_QUEUED_INPUTS);
+    }
+
+    void sendFragments(const NetAddress& to, uint32_t tick, uint32_t baselineTick, const std::vector<uint8_t>& payload)
+    {
+        uint32_t fragments = std::max(1u, (uint32_t)((payload.size() + SNAPSHOT_FRAGMENT_BYTES - 1) / SNAPSHOT_FRAGMENT_BYTES));
+        if (fragments > MAX_SNAPSHOT_FRAGMENTS)
+            return;
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (uint32_t fragment = 0; fragment < fragments; ++fragment)
+        {
+            size_t offset = (size_t)fragment * SNAPSHOT_FRAGMENT_BYTES;
+            size_t bytes = std::min((size_t)SNAPSHOT_FRAGMENT_BYTES, payload.size() - std::min(payload.size(), offset));
+            packet.resize(SNAPSHOT_HEADER_BYTES + bytes);
+            packet[0] = NET_MESSAGE_SNAPSHOT;
+            netWriteU32(&packet[1], tick);
+            netWriteU32(&packet[5], baselineTick);
+            netWriteU16(&packet[9], (uint16_t)fragment);
+            netWriteU16(&packet[11], (uint16_t)fragments);
+            if (bytes)
+                memcpy(&packet[SNAPSHOT_HEADER_BYTES], &payload[offset], bytes);
+            Stats.BytesSent += packet.size();
+            Stats.PacketsSent++;
+            if (PacketLoss > 0.0f && unit(lossRng) < PacketLoss)
+                continue;
+            socket.Send(to, packet.data(), packet.size());
+        }
+    }
+};
+
+struct ReplicationClientStats
+{
+    unsigned int Snapshots = 0;
+    // of the last snapshot, headers included
+    size_t BytesReceived = 0;
+    size_t TotalBytes = 0;
+    double DecodeMs = 0.0;
+    // newer snapshot started before this one completed, or its baseline was gone
+    unsigned int Dropped = 0;
+};
+
+class ReplicationClient
+{
+public:
+    // while no snapshot has arrived the connect request is repeated this often
+    float ConnectRetrySeconds = 0.25f;
+    ReplicationClientStats Stats;
+
+    bool Connect(const NetAddress& server)
+    {
+        serverAddress = server;
+        for (Snapshot& snapshot : history)
+            snapshot.Tick = NO_TICK;
+        latest = nullptr;
+        assemblyTick = NO_TICK;
+        playerState = PlayerState();
+        newPlayerState = false;
+        if (!socket.Open(0))
+            return false;
+        sendConnect();
+        return true;
+    }
+
+    void Disconnect()
+    {
+        if (socket.IsOpen())
+        {
+            uint8_t message = NET_MESSAGE_DISCONNECT;
+            socket.Send(serverAddress, &message, 1);
+        }
+        socket.Close();
+        latest = nullptr;
+    }
+
+    // reads everything that arrived; true when a newer snapshot was completed
+    bool Receive()
+    {
+        if (!latest && std::chrono::duration<float>(std::chrono::steady_clock::now() - lastConnect).count() > ConnectRetrySeconds)
+            sendConnect();
+
+        bool updated = false;
+        NetAddress from;
+        int size;
+        while ((size = socket.Receive(from, buffer, sizeof(buffer))) > 0)
+        {
+            if (from != serverAddress)
+                continue;
+            if (buffer[0] == NET_MESSAGE_PLAYER_STATE && size >= (int)PLAYER_STATE_BYTES)
+            {
+                receivePlayerState(buffer);
+                continue;
+            }
+            if (size < (int)SNAPSHOT_HEADER_BYTES || buffer[0] != NET_MESSAGE_SNAPSHOT)
+                continue;
+            uint32_t tick = netReadU32(buffer + 1);
+            uint32_t baselineTick = netReadU32(buffer + 5);
+            uint32_t fragment = netReadU16(buffer + 9);
+            uint32_t fragments = netReadU16(buffer + 11);
+            if (fragments == 0 || fragments > MAX_SNAPSHOT_FRAGMENTS || fragment >= fragments)
+                continue;
+            // only snapshots newer than the last decoded one are worth assembling
+            if (latest && (int32_t)(tick - latest->Tick) <= 0)
+                continue;
+            if (assemblyTick == NO_TICK || (int32_t)(tick - assemblyTick) > 0)
+            {
+                if (assemblyTick != NO_TICK)
+                    Stats.Dropped++;
+                startAssembly(tick, baselineTick, fragments);
+            }
+            else if (tick != assemblyTick)
+                continue;
+            // every fragment but the last is full
+            uint32_t bytes = (uint32_t)size - SNAPSHOT_HEADER_BYTES;
+            if (received[fragment] || bytes > SNAPSHOT_FRAGMENT_BYTES || (fragment + 1 < fragments && bytes != SNAPSHOT_FRAGMENT_BYTES))
+                continue;
+            received[fragment] = true;
+            receivedCount++;
+            memcpy(&assembly[(size_t)fragment * SNAPSHOT_FRAGMENT_BYTES], buffer + SNAPSHOT_HEADER_BYTES, bytes);
+            assemblyBytes += size;
+            if (fragment + 1 == fragments)
+                assembly.resize((size_t)fragment * SNAPSHOT_FRAGMENT_BYTES + bytes);
+            if (receivedCount == fragments)
+                updated |= completeAssembly();
+        }
+        return updated;
+    }
+
+    // newest decoded snapshot, or nullptr before the first one
+    const Snapshot* GetSnapshot() const
+    {
+        return latest;
+    }
+
+    // sends commands, oldest first; only the newest INPUT_REDUNDANCY go out
+    void SendInputs(const InputCommand* commands, size_t count)
+    {
+        if (count > INPUT_REDUNDANCY)
+        {
+            commands += count - INPUT_REDUNDANCY;
+            count = INPUT_REDUNDANCY;
+        }
+        uint8_t message[2 + INPUT_REDUNDANCY * INPUT_COMMAND_BYTES];
+        message[0] = NET_MESSAGE_INPUT;
+        message[1] = (uint8_t)count;
+        uint8_t* p = message + 2;
+        for (size_t i = 0; i < count; ++i, p += INPUT_COMMAND_BYTES)
+            WriteInputCommand(p, commands[i]);
+        socket.Send(serverAddress, message, 2 + count * INPUT_COMMAND_BYTES);
+    }
+
+    // where the camera is; sent with every ack so the server knows what is near it
+    void SetView(const glm::vec3& position)
+    {
+        view = position;
+    }
+
+    // the newest player state the server reported, once; false if nothing newer arrived
+    bool TakePlayerState(PlayerState& state)
+    {
+        if (!newPlayerState)
+            return false;
+        state = playerState;
+        newPlayerState = false;
+        return true;
+    }
+
+private:
+    UdpSocket socket;
+    NetAddress serverAddress;
+    std::chrono::steady_clock::time_point lastConnect;
+    uint8_t buffer[SNAPSHOT_HEADER_BYTES + SNAPSHOT_FRAGMENT_BYTES + 64];
+
+    // decoded snapshots by tick, kept as baselines for the ones still coming
+    Snapshot history[REPLICATION_HISTORY];
+    const Snapshot* latest = nullptr;
+
+    uint32_t assemblyTick = NO_TICK;
+    uint32_t assemblyBaseline = NO_TICK;
+    std::vector<uint8_t> assembly;
+    std::vector<bool> received;
+    uint32_t receivedCount = 0;
+    size_t assemblyBytes = 0;
+
+    PlayerState playerState;
+    bool newPlayerState = false;
+    glm::vec3 view = glm::vec3(0.0f);
+
+    void sendConnect()
+    {
+        uint8_t message = NET_MESSAGE_CONNECT;
+        socket.Send(serverAddress, &message, 1);
+        lastConnect = std::chrono::steady_clock::now();
+    }
+
+    // states can arrive out of order; only a later input tick replaces the one held
+    void receivePlayerState(const uint8_t* message)
+    {
+        uint32_t inputTick = netReadU32(message + 1);
+        if (playerState.InputTick != NO_TICK && (int32_t)(inputTick - playerState.InputTick) <= 0)
+            return;
+        playerState.InputTick = inputTick;
+        for (int k = 0; k < 3; ++k)
+        {
+            playerState.Position[k] = netReadF32(message + 5 + 4 * k);
+            playerState.Velocity[k] = netReadF32(message + 17 + 4 * k);
+        }
+        playerState.OnGround = message[29] != 0;
+        newPlayerState = true;
+    }
+
+    void startAssembly(uint32_t tick, uint32_t baselineTick, uint32_t fragments)
+    {
+        assemblyTick = tick;
+        assemblyBaseline = baselineTick;
+        assembly.assign((size_t)fragments * SNAPSHOT_FRAGMENT_BYTES, 0);
+        received.assign(fragments, false);
+        receivedCount = 0;
+        assemblyBytes = 0;
+    }
+
+    bool completeAssembly()
+    {
+        uint32_t tick = assemblyTick;
+        assemblyTick = NO_TICK;
+        const Snapshot* baseline = nullptr;
+        if (assemblyBaseline != NO_TICK)
+        {
+            baseline = &history[assemblyBaseline % REPLICATION_HISTORY];
+            if (baseline->Tick != assemblyBaseline)
+            {
+                Stats.Dropped++;
+                return false;
+            }
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Snapshot& target = history[tick % REPLICATION_HISTORY];
+        // the baseline may sit in the slot being overwritten only if it is a full history old
+        if (baseline == &target)
+        {
+            Stats.Dropped++;
+            return false;
+        }
+        BitReader reader(assembly.data(), assembly.size());
+        if (!DecodeSnapshot(reader, baseline, target))
+        {
+            // the slot no longer holds a valid snapshot
+            target.Tick = NO_TICK;
+            Stats.Dropped++;
+            return false;
+        }
+        target.Tick = tick;
+        latest = &target;
+        Stats.DecodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        Stats.Snapshots++;
+        Stats.BytesReceived = assemblyBytes;
+        Stats.TotalBytes += assemblyBytes;
+
+        uint8_t ack[ACK_BYTES];
+        ack[0] = NET_MESSAGE_ACK;
+        netWriteU32(ack + 1, tick);
+        for (int k = 0; k < 3; ++k)
+            netWriteF32(ack + 5 + 4 * k, view[k]);
+        socket.Send(serverAddress, ack, sizeof(ack));
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,537 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Camera.h"
+#include "Components.h"
+#include "ECS.h"
+#include "FrameConstants.h"
+#include "Frustum.h"
+#include "Lighting.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "ProgramCache.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "Shadows.h"
+#include "StressScene.h"
+#include "Terrain.h"
+#include "TransformHierarchy.h"
+
+// Shader sources the scene is built from, read from src/shaders by the app and the benchmark. The app
+// exits when one is missing; only the shadow fragment has a fallback, an empty one written inline
+struct SceneShaderSources
+{
+    std::string Vertex;
+    std::string Fragment;
+    std::string InstancedVertex;
+    std::string TerrainVertex;
+    std::string ShadowFragment;
+};
+
+// Programs of the scene, and the files in src/shaders each one is built from
+enum SceneProgram
+{
+    SCENE_PROGRAM_BASIC = 0,
+    SCENE_PROGRAM_INSTANCED,
+    SCENE_PROGRAM_TERRAIN,
+    SCENE_PROGRAM_SHADOW,
+    SCENE_PROGRAM_SHADOW_INSTANCED,
+    SCENE_PROGRAM_SHADOW_TERRAIN,
+    SCENE_PROGRAM_COUNT
+};
+
+struct SceneProgramFiles
+{
+    const char* Vertex;
+    const char* Fragment;
+};
+
+const SceneProgramFiles SCENE_PROGRAM_FILES[SCENE_PROGRAM_COUNT] = {
+    { "vertex.glsl", "fragment.glsl" },
+    { "instanced_vertex.glsl", "fragment.glsl" },
+    { "terrain_vertex.glsl", "fragment.glsl" },
+    { "vertex.glsl", "shadow_fragment.glsl" },
+    { "instanced_vertex.glsl", "shadow_fragment.glsl" },
+    { "terrain_vertex.glsl", "shadow_fragment.glsl" },
+};
+
+// Everything drawn in the 3D view, shared by the app and the benchmark so both render the same frame
+class Scene
+{
+public:
+    Terrain Ground;
+    StressScene Stress;
+    RenderQueue Queue;
+    FrameConstantsBuffer Constants;
+    ClusteredLighting Lighting;
+    // wandering point lights scattered over the stress area
+    int LightCount = 1024;
+    CascadedShadowMaps Shadows;
+    Shader Program;
+    Shader InstancedProgram;
+    // depth-only programs for the shadow pass; the terrain keeps its own
+    Shader ShadowProgram;
+    Shader InstancedShadowProgram;
+    // scene objects; entities with Transform + MeshRenderer are drawn with Meshes[MeshId]
+    World Entities;
+    std::vector<Mesh> Meshes;
+    Entity Triangle;
+    // parent/child placement for articulated objects; entities with a HierarchyNode are drawn from it
+    TransformHierarchy Hierarchy;
+    // optional; the shadow pass then reports GPU time per cascade
+    Profiler* FrameProfiler = nullptr;
+    // optional; entities in it with Transform + PreviousTransform + Replicated (e.g. the simulation's
+    // wanderers) are drawn as cubes standing on their position, Kind picks the material
+    World* Simulated = nullptr;
+    // where between PreviousTransform and Transform the simulated entities are drawn
+    float SimulatedAlpha = 1.0f;
+
+    // programs come from the cache when it has them, otherwise they are compiled (and cached)
+    void Init(const SceneShaderSources& sources, ProgramCache& programCache)
+    {
+        // Point lights are binned into view-space clusters; every program shades with the same lists
+        Lighting.Init();
+        // Sun shadows from cascaded shadow maps; static casters are cached between frames
+        Shadows.Init();
+
+        Program = programCache.Load(sources.Vertex, sources.Fragment);
+        bindLightSamplers(Program);
+        // Instanced variant of the vertex shader, the model matrix comes from the instance buffer
+        InstancedProgram = programCache.Load(sources.InstancedVertex, sources.Fragment);
+        bindLightSamplers(InstancedProgram);
+        ShadowProgram = programCache.Load(sources.Vertex, sources.ShadowFragment);
+        InstancedShadowProgram = programCache.Load(sources.InstancedVertex, sources.ShadowFragment);
+
+        // Triangle uses the compact vertex format: half positions, packed normals, byte colors
+        Mesh triangleMesh;
+        triangleMesh.Init(CreateTriangleMeshData(), VertexLayout::Compact());
+        Meshes.push_back(triangleMesh);
+
+        Triangle = Entities.Create();
+        Transform transform;
+        transform.Position = glm::vec3(0.0f, 1.0f, 0.0f);
+        Entities.Add<Transform>(Triangle, transform);
+        MeshRenderer renderer;
+        renderer.MeshId = 0;
+        Entities.Add<MeshRenderer>(Triangle, renderer);
+
+        // A ring of walking creatures, each a small tree of body parts
+        Mesh cubeMesh;
+        cubeMesh.Init(CreateCubeMeshData(), VertexLayout::Compact());
+        Meshes.push_back(cubeMesh);
+        Mesh pyramidMesh;
+        pyramidMesh.Init(CreatePyramidMeshData(), VertexLayout::Compact());
+        Meshes.push_back(pyramidMesh);
+        for (int i = 0; i < CREATURE_COUNT; ++i)
+        {
+            float angle = glm::two_pi<float>() * (float)i / (float)CREATURE_COUNT;
+            createCreature(glm::vec3(std::cos(angle), 0.0f, std::sin(angle)) * 7.0f, -angle, 1 + i % 4);
+        }
+
+        // Chunked LOD terrain replaces the flat ground plane; the area around the origin stays flat
+        Shader terrainProgram = programCache.Load(sources.TerrainVertex, sources.Fragment);
+        bindLightSamplers(terrainProgram);
+        Ground.Init(std::move(terrainProgram));
+        Ground.SetShadowProgram(programCache.Load(sources.TerrainVertex, sources.ShadowFragment));
+
+        // Cubes scattered on the ground, drawn with a single instanced call
+        Stress.Init();
+
+        // Draws are queued, sorted by state and submitted together. Material 0 is the untinted default.
+        Material material;
+        material.Tint = glm::vec4(1.0f, 0.55f, 0.5f, 1.0f);
+        Queue.Materials.push_back(material);
+        material.Tint = glm::vec4(0.5f, 0.8f, 1.0f, 1.0f);
+        Queue.Materials.push_back(material);
+        material.Tint = glm::vec4(1.0f, 0.9f, 0.4f, 1.0f);
+        Queue.Materials.push_back(material);
+        material.Tint = glm::vec4(0.7f, 0.5f, 1.0f, 1.0f);
+        Queue.Materials.push_back(material);
+
+        // View/projection live in a uniform block shared by every program
+        Constants.Init();
+    }
+
+    void Delete()
+    {
+        for (Mesh& mesh : Meshes)
+            mesh.Delete();
+        Meshes.clear();
+        hipJoints.clear();
+        kneeJoints.clear();
+        creatureRoots.clear();
+        Ground.Delete();
+        Stress.Delete();
+        Constants.Delete();
+        Lighting.Delete();
+        Shadows.Delete();
+        Program.Delete();
+        InstancedProgram.Delete();
+        ShadowProgram.Delete();
+        InstancedShadowProgram.Delete();
+    }
+
+    // swaps in a rebuilt program; the old one is deleted and the new one is used from the next draw
+    void SetProgram(SceneProgram which, Shader&& program)
+    {
+        if (which <= SCENE_PROGRAM_TERRAIN)
+            bindLightSamplers(program);
+        if (which == SCENE_PROGRAM_BASIC)
+            Program = std::move(program);
+        else if (which == SCENE_PROGRAM_INSTANCED)
+            InstancedProgram = std::move(program);
+        else if (which == SCENE_PROGRAM_TERRAIN)
+            Ground.SetProgram(std::move(program));
+        else if (which == SCENE_PROGRAM_SHADOW)
+            ShadowProgram = std::move(program);
+        else if (which == SCENE_PROGRAM_SHADOW_INSTANCED)
+            InstancedShadowProgram = std::move(program);
+        else if (which == SCENE_PROGRAM_SHADOW_TERRAIN)
+            Ground.SetShadowProgram(std::move(program));
+    }
+
+    // places a loaded mesh (e.g. a cooked .gemesh) in a row behind the start position; the scene
+    // deletes it with the rest
+    void AddMesh(const Mesh& mesh)
+    {
+        MeshRenderer renderer;
+        renderer.MeshId = (uint32_t)Meshes.size();
+        Meshes.push_back(mesh);
+
+        Entity entity = Entities.Create();
+        Transform transform;
+        float x = 6.0f * (float)addedMeshes++;
+        transform.Position = glm::vec3(x, Ground.GetHeight(x, -12.0f), -12.0f);
+        Entities.Add<Transform>(entity, transform);
+        Entities.Add<MeshRenderer>(entity, renderer);
+        Shadows.InvalidateStatic();
+    }
+
+    // draws one frame into the bound framebuffer; the caller clears it and sets the viewport
+    void Draw(Camera& camera, int width, int height, float time, float deltaTime)
+    {
+        // Depth precision follows the camera's height, the far plane is the terrain's view distance
+        camera.FitNearPlane(camera.Position.y - Ground.GetHeight(camera.Position.x, camera.Position.z));
+
+        // Update view/projection matrices once for every program
+        FrameConstants frameConstants = MakeFrameConstants(camera, width, height, time, deltaTime);
+
+        // Only the swinging legs change, so the bodies and hats keep last frame's world matrices
+        animateCreatures(time);
+        Hierarchy.Update();
+
+        // Shadow maps come first; they bind their own framebuffer, viewport and FrameConstants
+        renderShadows(camera, frameConstants, height > 0 ? (float)width / (float)height : 1.0f, time);
+
+        Constants.Update(frameConstants);
+        Shadows.Bind();
+
+        // Lights move every frame, so they are re-binned against this frame's view
+        updateLights(time);
+        Lighting.Update(frameConstants, camera.NearPlane, camera.FarPlane);
+
+        // Everything culled this frame is tested against the same frustum
+        Frustum frustum = Frustum::FromMatrix(frameConstants.ViewProj);
+
+        Ground.Draw(frustum, camera.Position);
+
+        Queue.Begin(camera.Position, camera.FarPlane);
+
+        // Entities
+        Entities.EachChunk<const Transform, const MeshRenderer>([this](uint32_t count, const Entity*, const Transform* transforms, const MeshRenderer* renderers) {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const Mesh& mesh = Meshes[renderers[i].MeshId];
+                Queue.Submit(mesh, Program, renderers[i].Material, transforms[i].ToMatrix() * mesh.Dequantize);
+            }
+        });
+        Entities.EachChunk<const HierarchyNode, const MeshRenderer>([this](uint32_t count, const Entity*, const HierarchyNode* nodes, const MeshRenderer* renderers) {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const Mesh& mesh = Meshes[renderers[i].MeshId];
+                Queue.Submit(mesh, Program, renderers[i].Material, Hierarchy.GetWorld(nodes[i].Node) * mesh.Dequantize);
+            }
+        });
+
+        if (Simulated)
+        {
+            const Mesh& cube = Meshes[CUBE_MESH];
+            Simulated->EachChunk<const Transform, const PreviousTransform, const Replicated>([&](uint32_t count, const Entity*, const Transform* transforms, const PreviousTransform* previous, const Replicated* replicated) {
+                for (uint32_t i = 0; i < count; ++i)
+                    Queue.Submit(cube, Program, 1 + replicated[i].Kind % 4, simulatedMatrix(previous[i], transforms[i]));
+            });
+        }
+
+        // Stress cubes and props
+        Stress.Submit(Queue, InstancedProgram, Program, time, frustum);
+
+        Queue.Execute();
+
+        Constants.EndFrame();
+    }
+
+private:
+    static const int CREATURE_COUNT = 16;
+    static const uint32_t CUBE_MESH = 1;
+    static const uint32_t PYRAMID_MESH = 2;
+    int addedMeshes = 0;
+
+    struct LightSpawn
+    {
+        glm::vec2 Center;
+        float Wander;  // radius of the circle the light moves on
+        float Speed;
+        float Phase;
+    };
+    std::vector<LightSpawn> lightSpawns;
+
+    unsigned int shadowCasterVersion = ~0u;
+    SphereBoundsSoA dynamicCasterBounds;
+    std::vector<TransformNode> creatureRoots;
+
+    // hip and knee of every leg, in creation order
+    std::vector<TransformNode> hipJoints;
+    std::vector<TransformNode> kneeJoints;
+
+    // a body part is a hierarchy node with an entity drawing a mesh at it
+    TransformNode addPart(TransformNode parent, const Transform& local, uint32_t meshId, uint32_t material)
+    {
+        TransformNode node = Hierarchy.Create(local, parent);
+        Entity entity = Entities.Create();
+        HierarchyNode link;
+        link.Node = node;
+        Entities.Add<HierarchyNode>(entity, link);
+        MeshRenderer renderer;
+        renderer.MeshId = meshId;
+        renderer.Material = material;
+        Entities.Add<MeshRenderer>(entity, renderer);
+        return node;
+    }
+
+    // root -> body, hat and four legs; each leg is hip -> upper segment, knee -> lower segment
+    void createCreature(const glm::vec3& position, float heading, uint32_t material)
+    {
+        Transform local;
+        local.Position = position + glm::vec3(0.0f, 1.1f, 0.0f);
+        local.Rotation = glm::angleAxis(heading, glm::vec3(0.0f, 1.0f, 0.0f));
+        TransformNode root = Hierarchy.Create(local);
+        creatureRoots.push_back(root);
+
+        local = Transform();
+        local.Scale = glm::vec3(1.4f, 0.5f, 0.7f);
+        addPart(root, local, CUBE_MESH, material);
+        local = Transform();
+        local.Position = glm::vec3(0.5f, 0.25f, 0.0f);
+        local.Scale = glm::vec3(0.4f);
+        addPart(root, local, PYRAMID_MESH, 0);
+
+        for (int leg = 0; leg < 4; ++leg)
+        {
+            Transform hip;
+            hip.Position = glm::vec3(leg < 2 ? 0.55f : -0.55f, -0.2f, leg % 2 == 0 ? 0.3f : -0.3f);
+            TransformNode hipNode = Hierarchy.Create(hip, root);
+            local = Transform();
+            local.Position = glm::vec3(0.0f, -0.2f, 0.0f);
+            local.Scale = glm::vec3(0.15f, 0.4f, 0.15f);
+            addPart(hipNode, local, CUBE_MESH, 0);
+
+            Transform knee;
+            knee.Position = glm::vec3(0.0f, -0.4f, 0.0f);
+            TransformNode kneeNode = Hierarchy.Create(knee, hipNode);
+            local.Position = glm::vec3(0.0f, -0.2f, 0.0f);
+            local.Scale = glm::vec3(0.12f, 0.4f, 0.12f);
+            addPart(kneeNode, local, CUBE_MESH, 0);
+
+            hipJoints.push_back(hipNode);
+            kneeJoints.push_back(kneeNode);
+        }
+    }
+
+    // every lit program samples the light lists and the shadow map
+    void bindLightSamplers(Shader& program)
+    {
+        Lighting.BindSamplers(program);
+        Shadows.BindSampler(program);
+    }
+
+    // terrain, props and still entities are static casters; the creatures, wanderers and spinning cubes move
+    void renderShadows(Camera& camera, const FrameConstants& frameConstants, float aspect, float time)
+    {
+        GLint framebuffer = 0, viewport[4];
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+
+        Stress.PrepareShadowCasters(time);
+        if (Stress.StaticCasterVersion != shadowCasterVersion)
+        {
+            Shadows.InvalidateStatic();
+            shadowCasterVersion = Stress.StaticCasterVersion;
+        }
+        Shadows.Fit(camera, aspect);
+
+        // only what moves: the creatures, entities with a velocity, the wanderers and spinning cubes
+        dynamicCasterBounds.Clear();
+        for (TransformNode root : creatureRoots)
+            dynamicCasterBounds.Add(glm::vec3(Hierarchy.GetWorld(root)[3]), 2.0f);
+        Entities.Each<const Transform, const Velocity>([this](Entity, const Transform& transform, const Velocity&) {
+            dynamicCasterBounds.Add(transform.Position, glm::length(transform.Scale));
+        });
+        if (Simulated)
+        {
+            // large enough for anywhere between the previous and the current transform
+            Simulated->Each<const Transform, const PreviousTransform, const Replicated>([this](Entity, const Transform& transform, const PreviousTransform& previous, const Replicated&) {
+                float moved = glm::length(transform.Position - previous.Value.Position);
+                dynamicCasterBounds.Add(transform.Position, glm::length(transform.Scale) + moved);
+            });
+        }
+        Stress.AppendDynamicBounds(dynamicCasterBounds);
+
+        glm::vec3 cameraPosition = camera.Position;
+        Shadows.Render(frameConstants, dynamicCasterBounds,
+            [&](int, const Frustum& frustum) {
+                Ground.DrawShadow(frustum, cameraPosition);
+                drawEntityShadows(frustum, false);
+                Stress.DrawShadowCasters(ShadowProgram, InstancedShadowProgram, frustum, false);
+            },
+            [&](int, const Frustum& frustum) {
+                drawEntityShadows(frustum, true);
+                Stress.DrawShadowCasters(ShadowProgram, InstancedShadowProgram, frustum, true);
+            },
+            FrameProfiler);
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)framebuffer);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    }
+
+    // entities with a Velocity, the creatures and the wanderers go in the dynamic pass, culled against
+    // the cascade; other entities are static casters (moving one by hand must InvalidateStatic)
+    void drawEntityShadows(const Frustum& frustum, bool dynamicPass)
+    {
+        ShadowProgram.Use();
+        UniformHandle model = ShadowProgram.FindUniform("model");
+        Entities.EachChunk<const Transform, const MeshRenderer>([&](uint32_t count, const Entity* entities, const Transform* transforms, const MeshRenderer* renderers) {
+            // a chunk holds one archetype, so either all of it moves or none of it does
+            if (Entities.Has<Velocity>(entities[0]) != dynamicPass)
+                return;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                if (dynamicPass && !frustum.IntersectsSphere(transforms[i].Position, glm::length(transforms[i].Scale)))
+                    continue;
+                const Mesh& mesh = Meshes[renderers[i].MeshId];
+                ShadowProgram.SetMat4(model, transforms[i].ToMatrix() * mesh.Dequantize);
+                mesh.Draw();
+            }
+        });
+        if (!dynamicPass)
+            return;
+
+        Entities.EachChunk<const HierarchyNode, const MeshRenderer>([&](uint32_t count, const Entity*, const HierarchyNode* nodes, const MeshRenderer* renderers) {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                // body parts are unit cubes scaled by their node
+                const glm::mat4& world = Hierarchy.GetWorld(nodes[i].Node);
+                float scale = std::max(glm::length(glm::vec3(world[0])), std::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+                if (!frustum.IntersectsSphere(glm::vec3(world[3]), scale * 0.8660254f))
+                    continue;
+                const Mesh& mesh = Meshes[renderers[i].MeshId];
+                ShadowProgram.SetMat4(model, world * mesh.Dequantize);
+                mesh.Draw();
+            }
+        });
+        if (Simulated)
+        {
+            const Mesh& cube = Meshes[CUBE_MESH];
+            Simulated->EachChunk<const Transform, const PreviousTransform, const Replicated>([&](uint32_t count, const Entity*, const Transform* transforms, const PreviousTransform* previous, const Replicated*) {
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    glm::mat4 matrix = simulatedMatrix(previous[i], transforms[i]);
+                    if (!frustum.IntersectsSphere(glm::vec3(matrix[3]), glm::length(transforms[i].Scale)))
+                        continue;
+                    ShadowProgram.SetMat4(model, matrix);
+                    cube.Draw();
+                }
+            });
+        }
+    }
+
+    // the cube mesh is centered on its origin, simulated entities stand on theirs
+    glm::mat4 simulatedMatrix(const PreviousTransform& previous, const Transform& transform) const
+    {
+        Transform standing = InterpolateTransform(previous.Value, transform, SimulatedAlpha);
+        standing.Position.y += standing.Scale.y * 0.5f;
+        return standing.ToMatrix();
+    }
+
+    // deterministic placement so the same count always produces the same lights
+    void spawnLights()
+    {
+        std::mt19937 rng(2024);
+        std::uniform_real_distribution<float> position(-Stress.Extent, Stress.Extent);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        lightSpawns.resize(LightCount);
+        Lighting.Lights.resize(LightCount);
+        for (int i = 0; i < LightCount; ++i)
+        {
+            LightSpawn& spawn = lightSpawns[i];
+            spawn.Center = glm::vec2(position(rng), position(rng));
+            spawn.Wander = 1.0f + 4.0f * unit(rng);
+            spawn.Speed = (unit(rng) * 2.0f - 1.0f) * 0.8f;
+            spawn.Phase = unit(rng) * glm::two_pi<float>();
+
+            // saturated color from a random hue
+            float hue = unit(rng) * 6.0f;
+            glm::vec3 color = glm::clamp(glm::vec3(std::fabs(hue - 3.0f) - 1.0f, 2.0f - std::fabs(hue - 2.0f), 2.0f - std::fabs(hue - 4.0f)), 0.0f, 1.0f);
+            PointLight& light = Lighting.Lights[i];
+            light.Color = color;
+            light.Radius = 3.0f + 3.0f * unit(rng);
+            light.Intensity = 4.0f + 4.0f * unit(rng);
+        }
+    }
+
+    // lights circle their spawn point, floating a little above the terrain
+    void updateLights(float time)
+    {
+        if ((int)lightSpawns.size() != LightCount)
+            spawnLights();
+        for (int i = 0; i < LightCount; ++i)
+        {
+            const LightSpawn& spawn = lightSpawns[i];
+            float angle = spawn.Phase + time * spawn.Speed;
+            glm::vec2 xz = spawn.Center + glm::vec2(std::cos(angle), std::sin(angle)) * spawn.Wander;
+            Lighting.Lights[i].Position = glm::vec3(xz.x, Ground.GetHeight(xz.x, xz.y) + 1.5f, xz.y);
+        }
+    }
+
+    // diagonal legs swing together; touching a joint marks just that leg's subtree dirty
+    void animateCreatures(float time)
+    {
+        for (size_t i = 0; i < hipJoints.size(); ++i)
+        {
+            int leg = (int)(i % 4);
+            float phase = time * 4.0f + (float)(i / 4) + (leg == 0 || leg == 3 ? 0.0f : glm::pi<float>());
+            float swing = std::sin(phase);
+
+            Transform hip = Hierarchy.GetLocal(hipJoints[i]);
+            hip.Rotation = glm::angleAxis(swing * 0.5f, glm::vec3(0.0f, 0.0f, 1.0f));
+            Hierarchy.SetLocal(hipJoints[i], hip);
+
+            Transform knee = Hierarchy.GetLocal(kneeJoints[i]);
+            knee.Rotation = glm::angleAxis(std::max(0.0f, -swing) * 0.8f, glm::vec3(0.0f, 0.0f, 1.0f));
+            Hierarchy.SetLocal(kneeJoints[i], knee);
+        }
+    }
+};
+#endif
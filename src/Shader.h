@@ -0,0 +1,358 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Index into a program's reflected uniform table. Look it up once after linking and keep it around.
+typedef int UniformHandle;
+const UniformHandle INVALID_UNIFORM = -1;
+
+// Fixed binding points for uniform blocks shared by every program. GL 3.3 has no layout(binding = N),
+// so blocks are matched by name after linking.
+enum UniformBlockBinding
+{
+    FRAME_CONSTANTS_BINDING = 0,
+    LIGHTING_CONSTANTS_BINDING = 1,
+    SHADOW_CONSTANTS_BINDING = 2
+};
+
+struct UniformBlockName
+{
+    const char* Name;
+    GLuint Binding;
+};
+
+const UniformBlockName UNIFORM_BLOCK_BINDINGS[] = {
+    { "FrameConstants", FRAME_CONSTANTS_BINDING },
+    { "LightingConstants", LIGHTING_CONSTANTS_BINDING },
+    { "ShadowConstants", SHADOW_CONSTANTS_BINDING },
+};
+
+// Upload counters shared by every program, reset once per frame and shown in the Debug Info window
+struct UniformStats
+{
+    unsigned int Uploads = 0;
+    unsigned int Skipped = 0;
+
+    void Reset()
+    {
+        Uploads = 0;
+        Skipped = 0;
+    }
+};
+
+inline UniformStats& GetUniformStats()
+{
+    static UniformStats stats;
+    return stats;
+}
+
+// FNV-1a, used to key the reflected uniform/attribute tables
+inline uint32_t HashShaderName(const char* name)
+{
+    uint32_t hash = 2166136261u;
+    while (*name)
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// One active uniform or attribute as reported by the driver at link time
+struct ShaderVariable
+{
+    std::string Name;
+    uint32_t Hash = 0;
+    GLint Location = -1;
+    GLenum Type = 0;
+    GLint Size = 0;
+    // last value uploaded through the typed setters, used to skip redundant glUniform* calls
+    float Value[16];
+    bool HasValue = false;
+};
+
+// Open-addressing table of variables keyed by name hash. Built once after linking, never resized afterwards.
+class ShaderVariableTable
+{
+public:
+    std::vector<ShaderVariable> Variables;
+
+    void Build()
+    {
+        size_t capacity = 8;
+        while (capacity < Variables.size() * 2)
+            capacity *= 2;
+        slots.assign(capacity, -1);
+        for (size_t i = 0; i < Variables.size(); ++i)
+        {
+            size_t slot = Variables[i].Hash & (capacity - 1);
+            while (slots[slot] != -1)
+                slot = (slot + 1) & (capacity - 1);
+            slots[slot] = (int)i;
+        }
+    }
+
+    int Find(const char* name) const
+    {
+        if (slots.empty())
+            return -1;
+        uint32_t hash = HashShaderName(name);
+        size_t mask = slots.size() - 1;
+        for (size_t slot = hash & mask; slots[slot] != -1; slot = (slot + 1) & mask)
+        {
+            const ShaderVariable& var = Variables[slots[slot]];
+            if (var.Hash == hash && var.Name == name)
+                return slots[slot];
+        }
+        return -1;
+    }
+
+private:
+    std::vector<int> slots;
+};
+
+// A linked GLSL program with its active uniforms and attributes reflected once at link time
+class Shader
+{
+public:
+    unsigned int ID = 0;
+    ShaderVariableTable Uniforms;
+    ShaderVariableTable Attributes;
+
+    Shader() {}
+
+    // compiles and links the program, then reflects everything the driver kept active
+    Shader(const std::string& vertexSrc, const std::string& fragmentSrc)
+    {
+        unsigned int vertex = compileShader(GL_VERTEX_SHADER, vertexSrc);
+        unsigned int fragment = compileShader(GL_FRAGMENT_SHADER, fragmentSrc);
+
+        unsigned int program = glCreateProgram();
+        glAttachShader(program, vertex);
+        glAttachShader(program, fragment);
+        glLinkProgram(program);
+
+        int success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            char info[512];
+            glGetProgramInfoLog(program, 512, nullptr, info);
+            std::cerr << "Shader link error: " << info << std::endl;
+        }
+
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+
+        ID = program;
+        if (success)
+            reflect();
+    }
+
+    // takes ownership of a program that was already linked successfully, e.g. by AsyncShaderCompiler
+    explicit Shader(unsigned int linkedProgram)
+    {
+        ID = linkedProgram;
+        reflect();
+    }
+
+    Shader(const Shader&) = delete;
+    Shader& operator=(const Shader&) = delete;
+
+    Shader(Shader&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    Shader& operator=(Shader&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Delete();
+            ID = other.ID;
+            Uniforms = std::move(other.Uniforms);
+            Attributes = std::move(other.Attributes);
+            other.ID = 0;
+        }
+        return *this;
+    }
+
+    ~Shader()
+    {
+        Delete();
+    }
+
+    // must be called while the GL context is still alive
+    void Delete()
+    {
+        if (ID != 0)
+            glDeleteProgram(ID);
+        ID = 0;
+    }
+
+    void Use() const
+    {
+        glUseProgram(ID);
+    }
+
+    UniformHandle FindUniform(const char* name) const
+    {
+        return Uniforms.Find(name);
+    }
+
+    GLint GetAttributeLocation(const char* name) const
+    {
+        int index = Attributes.Find(name);
+        return index < 0 ? -1 : Attributes.Variables[index].Location;
+    }
+
+    // typed setters: the program must be bound with Use(). Values equal to the last upload are skipped.
+    void SetInt(UniformHandle handle, int value)
+    {
+        if (ShaderVariable* var = beginUpload(handle, &value, sizeof(value)))
+            glUniform1i(var->Location, value);
+    }
+
+    void SetFloat(UniformHandle handle, float value)
+    {
+        if (ShaderVariable* var = beginUpload(handle, &value, sizeof(value)))
+            glUniform1f(var->Location, value);
+    }
+
+    void SetVec2(UniformHandle handle, const glm::vec2& value)
+    {
+        if (ShaderVariable* var = beginUpload(handle, glm::value_ptr(value), sizeof(value)))
+            glUniform2fv(var->Location, 1, glm::value_ptr(value));
+    }
+
+    void SetVec3(UniformHandle handle, const glm::vec3& value)
+    {
+        if (ShaderVariable* var = beginUpload(handle, glm::value_ptr(value), sizeof(value)))
+            glUniform3fv(var->Location, 1, glm::value_ptr(value));
+    }
+
+    void SetVec4(UniformHandle handle, const glm::vec4& value)
+    {
+        if (ShaderVariable* var = beginUpload(handle, glm::value_ptr(value), sizeof(value)))
+            glUniform4fv(var->Location, 1, glm::value_ptr(value));
+    }
+
+    void SetMat4(UniformHandle handle, const glm::mat4& value)
+    {
+        if (ShaderVariable* var = beginUpload(handle, glm::value_ptr(value), sizeof(value)))
+            glUniformMatrix4fv(var->Location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    // convenience overloads for one-off uniforms; hot paths should keep the handle instead
+    void SetInt(const char* name, int value) { SetInt(FindUniform(name), value); }
+    void SetFloat(const char* name, float value) { SetFloat(FindUniform(name), value); }
+    void SetVec2(const char* name, const glm::vec2& value) { SetVec2(FindUniform(name), value); }
+    void SetVec3(const char* name, const glm::vec3& value) { SetVec3(FindUniform(name), value); }
+    void SetVec4(const char* name, const glm::vec4& value) { SetVec4(FindUniform(name), value); }
+    void SetMat4(const char* name, const glm::mat4& value) { SetMat4(FindUniform(name), value); }
+
+private:
+    static unsigned int compileShader(unsigned int type, const std::string& source)
+    {
+        unsigned int shader = glCreateShader(type);
+        const char* src = source.c_str();
+        glShaderSource(shader, 1, &src, nullptr);
+        glCompileShader(shader);
+
+        int success;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            char info[512];
+            glGetShaderInfoLog(shader, 512, nullptr, info);
+            std::cerr << "Shader compile error: " << info << std::endl;
+        }
+
+        return shader;
+    }
+
+    // arrays are reported as "name[0]"; strip the suffix so they can be looked up by their plain name
+    static std::string baseName(const char* name)
+    {
+        std::string result(name);
+        size_t bracket = result.find("[0]");
+        if (bracket != std::string::npos && bracket + 3 == result.size())
+            result.resize(bracket);
+        return result;
+    }
+
+    void reflect()
+    {
+        GLint count = 0, maxLength = 0;
+        std::vector<char> name;
+
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        name.resize(maxLength > 0 ? maxLength : 1);
+        Uniforms.Variables.clear();
+        for (GLint i = 0; i < count; ++i)
+        {
+            ShaderVariable var;
+            glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), nullptr, &var.Size, &var.Type, name.data());
+            var.Location = glGetUniformLocation(ID, name.data());
+            // members of uniform blocks have no location and are not set through glUniform*
+            if (var.Location < 0)
+                continue;
+            var.Name = baseName(name.data());
+            var.Hash = HashShaderName(var.Name.c_str());
+            Uniforms.Variables.push_back(var);
+        }
+        Uniforms.Build();
+
+        glGetProgramiv(ID, GL_ACTIVE_ATTRIBUTES, &count);
+        glGetProgramiv(ID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+        name.resize(maxLength > 0 ? maxLength : 1);
+        Attributes.Variables.clear();
+        for (GLint i = 0; i < count; ++i)
+        {
+            ShaderVariable var;
+            glGetActiveAttrib(ID, (GLuint)i, (GLsizei)name.size(), nullptr, &var.Size, &var.Type, name.data());
+            var.Location = glGetAttribLocation(ID, name.data());
+            var.Name = baseName(name.data());
+            var.Hash = HashShaderName(var.Name.c_str());
+            Attributes.Variables.push_back(var);
+        }
+        Attributes.Build();
+
+        for (const UniformBlockName& block : UNIFORM_BLOCK_BINDINGS)
+        {
+            GLuint index = glGetUniformBlockIndex(ID, block.Name);
+            if (index != GL_INVALID_INDEX)
+                glUniformBlockBinding(ID, index, block.Binding);
+        }
+    }
+
+    // returns the variable to upload to, or nullptr when the handle is invalid or the value is unchanged
+    ShaderVariable* beginUpload(UniformHandle handle, const void* value, size_t bytes)
+    {
+        if (handle < 0 || handle >= (int)Uniforms.Variables.size())
+            return nullptr;
+
+        ShaderVariable& var = Uniforms.Variables[handle];
+        UniformStats& stats = GetUniformStats();
+        if (var.HasValue && std::memcmp(var.Value, value, bytes) == 0)
+        {
+            stats.Skipped++;
+            return nullptr;
+        }
+
+        std::memcpy(var.Value, value, bytes);
+        var.HasValue = true;
+        stats.Uploads++;
+        return &var;
+    }
+};
+#endif
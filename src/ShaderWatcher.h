@@ -0,0 +1,124 @@
+#ifndef SHADER_WATCHER_H
+#define SHADER_WATCHER_H
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Reports .glsl files in a directory that were written since the last Poll(). Uses inotify on Linux
+// and falls back to comparing modification times elsewhere. Poll() never blocks.
+class ShaderWatcher
+{
+public:
+    // how often the fallback rescans the directory
+    static constexpr int POLL_INTERVAL_MS = 250;
+
+    bool Init(const std::string& directory)
+    {
+        this->directory = directory;
+        if (!std::filesystem::is_directory(directory))
+            return false;
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        // editors either rewrite the file or write a temporary and rename it over the original
+        if (fd >= 0 && inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0)
+            return true;
+        Delete();
+#endif
+        scan(times);
+        return true;
+    }
+
+    void Delete()
+    {
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+        fd = -1;
+#endif
+    }
+
+    ~ShaderWatcher()
+    {
+        Delete();
+    }
+
+    const std::string& GetDirectory() const
+    {
+        return directory;
+    }
+
+    // file names (not paths) changed since the last call, each reported once
+    std::vector<std::string> Poll()
+    {
+        std::vector<std::string> changed;
+#ifdef __linux__
+        if (fd >= 0)
+        {
+            alignas(inotify_event) char buffer[4096];
+            ssize_t length;
+            while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* p = buffer; p < buffer + length;)
+                {
+                    const inotify_event* event = (const inotify_event*)p;
+                    if (event->len > 0)
+                        addChanged(changed, event->name);
+                    p += sizeof(inotify_event) + event->len;
+                }
+            }
+            return changed;
+        }
+#endif
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastScan < std::chrono::milliseconds(POLL_INTERVAL_MS))
+            return changed;
+        lastScan = now;
+
+        std::map<std::string, std::filesystem::file_time_type> current;
+        scan(current);
+        for (const auto& entry : current)
+        {
+            auto previous = times.find(entry.first);
+            if (previous == times.end() || previous->second != entry.second)
+                addChanged(changed, entry.first);
+        }
+        times.swap(current);
+        return changed;
+    }
+
+private:
+    std::string directory;
+#ifdef __linux__
+    int fd = -1;
+#endif
+    std::map<std::string, std::filesystem::file_time_type> times;
+    std::chrono::steady_clock::time_point lastScan;
+
+    static void addChanged(std::vector<std::string>& changed, const std::string& name)
+    {
+        if (std::filesystem::path(name).extension() != ".glsl")
+            return;
+        if (std::find(changed.begin(), changed.end(), name) == changed.end())
+            changed.push_back(name);
+    }
+
+    void scan(std::map<std::string, std::filesystem::file_time_type>& result) const
+    {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+        {
+            if (entry.is_regular_file(error))
+                result[entry.path().filename().string()] = entry.last_write_time(error);
+        }
+    }
+};
+#endif
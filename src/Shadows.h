@@ -0,0 +1,342 @@
+#ifndef SHADOWS_H
+#define SHADOWS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "Camera.h"
+#include "Culling.h"
+#include "FrameConstants.h"
+#include "Frustum.h"
+#include "Profiler.h"
+#include "Shader.h"
+
+const int SHADOW_CASCADE_COUNT = 4;
+
+// Sun and cascade data for the fragment shader. Member order and padding follow std140, see the
+// ShadowConstants block in fragment.glsl.
+struct ShadowConstants
+{
+    glm::mat4 CascadeViewProj[SHADOW_CASCADE_COUNT];
+    glm::vec4 CascadeSplits; // view depth where each cascade ends
+    glm::vec4 CascadeTexel;  // world size of one shadow map texel in each cascade
+    glm::vec4 SunDirection;  // xyz towards the sun, w intensity
+    glm::vec4 Params;        // depth bias, normal offset in texels, ambient, 1 when shadows are on
+};
+
+static_assert(sizeof(ShadowConstants) == 320, "ShadowConstants must match the std140 layout of the GLSL block");
+
+// One cascade as fitted this frame
+struct ShadowCascade
+{
+    glm::mat4 View = glm::mat4(1.0f);
+    glm::mat4 Projection = glm::mat4(1.0f);
+    glm::mat4 ViewProj = glm::mat4(1.0f);
+    glm::vec3 Center = glm::vec3(0.0f); // light space, snapped
+    float HalfExtent = 0.0f;
+    float SplitNear = 0.0f;
+    float SplitFar = 0.0f;
+    float TexelSize = 0.0f;
+    bool StaticValid = false;  // the static depth layer matches the current matrix
+    bool HadDynamic = false;   // dynamic casters were drawn into the layer last frame
+};
+
+// Shadow map work done this frame, shown in the Debug Info window
+struct ShadowStats
+{
+    unsigned int StaticRedraws = 0;  // cascades whose static casters were rendered again
+    unsigned int DynamicRedraws = 0; // cascades refreshed for moving casters
+    unsigned int Reused = 0;         // cascades left untouched
+};
+
+// Split depths between near and far: a blend of logarithmic (even texel density) and uniform
+// (less detail wasted up close) distribution
+inline void ComputeCascadeSplits(float nearPlane, float farPlane, float lambda, float* splits)
+{
+    for (int i = 1; i <= SHADOW_CASCADE_COUNT; ++i)
+    {
+        float t = (float)i / (float)SHADOW_CASCADE_COUNT;
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+        splits[i - 1] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+    }
+}
+
+// Cascaded shadow maps for the sun. Each cascade is fitted to the bounding sphere of its slice of the
+// camera frustum, which only depends on FOV, aspect and the split depths, so the cascade size never
+// changes as the camera turns. The cascade center moves in steps of whole texels to stop shimmering,
+// and in coarse steps on top of that so the matrix, and with it the cached static depth, stays the
+// same for many frames. Static casters are rendered into a separate layer only when a cascade moves;
+// moving casters are drawn over a copy of it, and only in cascades they touch.
+class CascadedShadowMaps
+{
+public:
+    static const int TEXTURE_UNIT = 4;
+
+    bool Enabled = true;
+    bool CacheStatic = true;
+    int Resolution = 2048;         // per cascade; set before Init()
+    float ShadowDistance = 150.0f; // shadows end here, or at the camera far plane if that is closer
+    float SplitLambda = 0.75f;
+    float CasterDistance = 200.0f; // how far towards the sun casters outside a cascade are still caught
+    glm::vec3 SunDirection = glm::normalize(glm::vec3(0.4f, 1.0f, 0.3f)); // towards the sun
+    float SunIntensity = 0.6f;
+    float Ambient = 0.4f;
+
+    ShadowCascade Cascades[SHADOW_CASCADE_COUNT];
+    ShadowStats Stats;
+
+    void Init()
+    {
+        glGenTextures(2, textures);
+        for (int i = 0; i < 2; ++i)
+        {
+            glBindTexture(GL_TEXTURE_2D_ARRAY, textures[i]);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, Resolution, Resolution, SHADOW_CASCADE_COUNT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            // hardware 2x2 PCF on the sampled map
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(2, framebuffers);
+        for (int i = 0; i < 2; ++i)
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+            glDrawBuffer(GL_NONE);
+            glReadBuffer(GL_NONE);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        glGenBuffers(1, &constantsBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, constantsBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowConstants), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+            cascadeConstants[i].Init();
+    }
+
+    void Delete()
+    {
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+            cascadeConstants[i].Delete();
+        glDeleteFramebuffers(2, framebuffers);
+        glDeleteTextures(2, textures);
+        glDeleteBuffers(1, &constantsBuffer);
+        framebuffers[0] = framebuffers[1] = textures[0] = textures[1] = constantsBuffer = 0;
+    }
+
+    // points the program's shadow sampler at TEXTURE_UNIT; call once after (re)linking
+    void BindSampler(Shader& program)
+    {
+        program.Use();
+        program.SetInt("shadowMap", TEXTURE_UNIT);
+    }
+
+    // drops every cached static layer, e.g. after static casters were added or removed
+    void InvalidateStatic()
+    {
+        for (ShadowCascade& cascade : Cascades)
+            cascade.StaticValid = false;
+    }
+
+    // fits the cascades to the camera; a cascade whose matrix changed loses its static cache
+    void Fit(const Camera& camera, float aspect)
+    {
+        if (SunDirection != lastSunDirection)
+        {
+            InvalidateStatic();
+            lastSunDirection = SunDirection;
+        }
+
+        float nearPlane = camera.NearPlane;
+        float farPlane = std::min(ShadowDistance, camera.FarPlane);
+        float splits[SHADOW_CASCADE_COUNT];
+        ComputeCascadeSplits(nearPlane, farPlane, SplitLambda, splits);
+
+        // light looks down -SunDirection; only its rotation matters, translation comes from the snapping
+        glm::vec3 up = std::fabs(SunDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), -SunDirection, up);
+
+        float tanY = std::tan(glm::radians(camera.Zoom) * 0.5f);
+        float tanX = tanY * aspect;
+        float diagonalSq = tanX * tanX + tanY * tanY;
+
+        float splitNear = nearPlane;
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+        {
+            ShadowCascade& cascade = Cascades[i];
+            float splitFar = splits[i];
+
+            // smallest sphere around the slice: its center sits where near and far corners are equally far
+            float centerDepth = std::min(splitFar, 0.5f * (splitNear + splitFar) * (1.0f + diagonalSq));
+            float radius = std::sqrt((splitFar - centerDepth) * (splitFar - centerDepth) + splitFar * splitFar * diagonalSq);
+            // round up so float noise in the camera values cannot change the size
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            // the center snaps to 1/8 of the extent, which is a whole number of texels
+            float halfExtent = radius * 8.0f / 7.0f;
+            float texel = 2.0f * halfExtent / (float)Resolution;
+            float step = texel * (float)(Resolution / 16);
+
+            glm::vec3 worldCenter = camera.Position + camera.Front * centerDepth;
+            glm::vec3 center = glm::vec3(lightRotation * glm::vec4(worldCenter, 1.0f));
+            center = glm::floor(center / step + 0.5f) * step;
+
+            bool moved = center != cascade.Center || halfExtent != cascade.HalfExtent;
+            cascade.Center = center;
+            cascade.HalfExtent = halfExtent;
+            cascade.SplitNear = splitNear;
+            cascade.SplitFar = splitFar;
+            cascade.TexelSize = texel;
+            if (moved)
+            {
+                cascade.StaticValid = false;
+                cascade.View = glm::translate(glm::mat4(1.0f), -center) * lightRotation;
+                // depth reaches CasterDistance towards the sun so off-screen casters still land in the map
+                cascade.Projection = glm::ortho(-halfExtent, halfExtent, -halfExtent, halfExtent, -halfExtent - CasterDistance, halfExtent);
+                cascade.ViewProj = cascade.Projection * cascade.View;
+            }
+            splitNear = splitFar;
+        }
+    }
+
+    // whether a bounding sphere overlaps the cascade's footprint as seen from the sun
+    bool Touches(int cascadeIndex, const glm::vec3& center, float radius) const
+    {
+        const ShadowCascade& cascade = Cascades[cascadeIndex];
+        glm::vec3 p = glm::vec3(cascade.View * glm::vec4(center, 1.0f));
+        float reach = cascade.HalfExtent + radius;
+        return std::fabs(p.x) < reach && std::fabs(p.y) < reach;
+    }
+
+    // renders whatever is out of date. drawStatic / drawDynamic(cascade, frustum) issue the caster
+    // draws; FrameConstants is bound to the cascade's view while they run. dynamicBounds are the
+    // spheres of everything drawDynamic draws. The caller rebinds its own framebuffer, viewport and
+    // FrameConstants afterwards.
+    template<typename DrawStatic, typename DrawDynamic>
+    void Render(const FrameConstants& frame, const SphereBoundsSoA& dynamicBounds, DrawStatic&& drawStatic, DrawDynamic&& drawDynamic, Profiler* profiler)
+    {
+        Stats = ShadowStats();
+        if (!Enabled)
+            return;
+
+        glViewport(0, 0, Resolution, Resolution);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(1.5f, 2.0f);
+
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+        {
+            ShadowCascade& cascade = Cascades[i];
+            bool dynamic = false;
+            for (size_t s = 0; s < dynamicBounds.Size() && !dynamic; ++s)
+                dynamic = Touches(i, glm::vec3(dynamicBounds.X[s], dynamicBounds.Y[s], dynamicBounds.Z[s]), dynamicBounds.Radius[s]);
+
+            bool redrawStatic = !CacheStatic || !cascade.StaticValid;
+            if (!redrawStatic && !dynamic && !cascade.HadDynamic)
+            {
+                Stats.Reused++;
+                continue;
+            }
+
+            if (profiler)
+                profiler->BeginRange((ProfileRange)(RANGE_SHADOW_CASCADE_0 + i));
+
+            FrameConstants constants = frame;
+            constants.View = cascade.View;
+            constants.Projection = cascade.Projection;
+            constants.ViewProj = cascade.ViewProj;
+            constants.ViewportSize = glm::vec2((float)Resolution);
+            cascadeConstants[i].Update(constants);
+            Frustum frustum = Frustum::FromMatrix(cascade.ViewProj);
+
+            if (CacheStatic)
+            {
+                if (redrawStatic)
+                {
+                    bindLayer(STATIC_LAYERS, i);
+                    glClear(GL_DEPTH_BUFFER_BIT);
+                    drawStatic(i, frustum);
+                    cascade.StaticValid = true;
+                    Stats.StaticRedraws++;
+                }
+
+                // the sampled layer starts as a copy of the static one, moving casters go on top
+                glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffers[STATIC_LAYERS]);
+                glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textures[STATIC_LAYERS], 0, i);
+                bindLayer(SAMPLED_LAYERS, i);
+                glBlitFramebuffer(0, 0, Resolution, Resolution, 0, 0, Resolution, Resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            }
+            else
+            {
+                bindLayer(SAMPLED_LAYERS, i);
+                glClear(GL_DEPTH_BUFFER_BIT);
+                drawStatic(i, frustum);
+                Stats.StaticRedraws++;
+            }
+
+            if (dynamic)
+            {
+                drawDynamic(i, frustum);
+                Stats.DynamicRedraws++;
+            }
+            cascade.HadDynamic = dynamic;
+            cascadeConstants[i].EndFrame();
+
+            if (profiler)
+                profiler->EndRange((ProfileRange)(RANGE_SHADOW_CASCADE_0 + i));
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    // uploads the cascade data and binds the shadow map for the lit draws
+    void Bind()
+    {
+        ShadowConstants constants;
+        for (int i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+        {
+            constants.CascadeViewProj[i] = Cascades[i].ViewProj;
+            constants.CascadeSplits[i] = Cascades[i].SplitFar;
+            constants.CascadeTexel[i] = Cascades[i].TexelSize;
+        }
+        constants.SunDirection = glm::vec4(SunDirection, SunIntensity);
+        constants.Params = glm::vec4(0.0002f, 1.5f, Ambient, Enabled ? 1.0f : 0.0f);
+
+        glBindBuffer(GL_UNIFORM_BUFFER, constantsBuffer);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ShadowConstants), &constants);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        glBindBufferBase(GL_UNIFORM_BUFFER, SHADOW_CONSTANTS_BINDING, constantsBuffer);
+
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, textures[SAMPLED_LAYERS]);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+private:
+    enum { STATIC_LAYERS = 0, SAMPLED_LAYERS = 1 };
+
+    GLuint textures[2] = {};
+    GLuint framebuffers[2] = {};
+    GLuint constantsBuffer = 0;
+    // every cascade has its own ring so the shadow pass never overwrites constants still in flight
+    FrameConstantsBuffer cascadeConstants[SHADOW_CASCADE_COUNT];
+    glm::vec3 lastSunDirection = glm::vec3(0.0f);
+
+    void bindLayer(int which, int layer)
+    {
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[which]);
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, textures[which], 0, layer);
+    }
+};
+#endif
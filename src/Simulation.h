@@ -0,0 +1,305 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "CharacterController.h"
+#include "Collision.h"
+#include "Components.h"
+#include "ECS.h"
+#include "JobSystem.h"
+#include "Snapshot.h"
+
+// The game world as it advances tick by tick: wandering creatures and the players walking among
+// them. Nothing here touches GL, so the same code runs in the game and in the dedicated server.
+// A client connected to a server runs it too, with the server's creatures mirrored from snapshots
+// instead of wandering on their own.
+
+// wanderers' size follows their kind, so a client can rebuild their boxes from a snapshot
+inline float WandererSize(uint32_t kind)
+{
+    return 0.6f + 0.15f * (float)(kind % 4);
+}
+
+// box a wanderer standing at position takes up in the collision world
+inline AABB WandererBounds(const glm::vec3& position, const glm::vec3& scale)
+{
+    AABB box;
+    box.Min = position - scale * glm::vec3(0.5f, 0.0f, 0.5f);
+    box.Max = position + scale * glm::vec3(0.5f, 1.0f, 0.5f);
+    return box;
+}
+
+// creature that walks straight for a while, then picks a new random heading
+struct Wanderer
+{
+    uint32_t Seed = 0;
+    float Speed = 1.0f;
+    // ticks until the next turn
+    uint32_t TurnIn = 0;
+    uint32_t Turns = 0;
+};
+
+struct SimulationStats
+{
+    unsigned long long Ticks = 0;
+    double LastTickMs = 0.0;
+    double TotalTickMs = 0.0;
+    double MaxTickMs = 0.0;
+};
+
+class Simulation
+{
+public:
+    // wanderers roam inside [-Extent, Extent] on x/z
+    float Extent = 48.0f;
+    // optional; the wanderers and the broadphase then update on all worker threads
+    JobSystem* Jobs = nullptr;
+    World Entities;
+    // terrain plus a box per replicated entity and per obstacle, rebuilt every tick
+    CollisionWorld Collision;
+    // boxes the owner poses before each tick (e.g. the renderer's stress cubes)
+    std::vector<AABB> Obstacles;
+    std::vector<CharacterController> Players;
+    SimulationStats Stats;
+
+    // ground the wanderers stand on and the players walk on; it must outlive the simulation
+    void SetGround(const Heightfield& ground)
+    {
+        Collision.Ground = ground;
+    }
+
+    // deterministic for a given count, so a server and a client spawn the same creatures
+    void SpawnWanderers(uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            uint32_t seed = hash(spawned++ * 2654435761u + 1u);
+            Entity entity = Entities.Create();
+            Transform transform;
+            transform.Position = glm::vec3((random(seed, 0) * 2.0f - 1.0f) * Extent, 0.0f, (random(seed, 1) * 2.0f - 1.0f) * Extent);
+            transform.Position.y = groundHeight(transform.Position.x, transform.Position.z);
+            transform.Scale = glm::vec3(WandererSize(seed % 4));
+            Entities.Add<Transform>(entity, transform);
+            Entities.Add<PreviousTransform>(entity, PreviousTransform{ transform });
+            Entities.Add<Velocity>(entity);
+            Wanderer wanderer;
+            wanderer.Seed = seed;
+            wanderer.Speed = 1.0f + 2.0f * random(seed, 3);
+            Entities.Add<Wanderer>(entity, wanderer);
+            Replicated replicated;
+            replicated.Kind = seed % 4;
+            Entities.Add<Replicated>(entity, replicated);
+            wanderers.push_back(entity);
+        }
+    }
+
+    // blend factor between PreviousTransform and Transform for rendering, given the fixed timestep's
+    // alpha. Wanderers simulated here move once per tick. Mirrored ones move once per snapshot, so
+    // they are shown one snapshot late and blended over the ticks between two snapshots.
+    float GetRenderAlpha(float tickAlpha) const
+    {
+        if (mirrored.empty())
+            return tickAlpha;
+        // the tick that applied the snapshot counts as its first
+        float ticks = (float)std::max(ticksSinceSnapshot, 1u) - 1.0f + tickAlpha;
+        return std::min(1.0f, ticks / (float)snapshotTicks);
+    }
+
+    const std::vector<Entity>& GetWanderers() const
+    {
+        return wanderers;
+    }
+
+    // returns the player's index; position is where its feet go
+    uint32_t AddPlayer(const glm::vec3& position)
+    {
+        CharacterController player;
+        player.Position = position;
+        Players.push_back(player);
+        inputs.emplace_back();
+        return (uint32_t)Players.size() - 1;
+    }
+
+    // the player moves once with this input in the next tick, once per input if there are several.
+    // Without any it doesn't move at all: a server's copy of a player only advances by the commands
+    // its client sent, so it stays in step with the client's prediction.
+    void AddInput(uint32_t player, const PlayerInput& input)
+    {
+        inputs[player].push_back(input);
+    }
+
+    // makes the replicated entities match a server's snapshot: creates the new ones, moves the rest
+    // and destroys those that are gone. The transforms they had are kept as PreviousTransform, so
+    // rendering blends from the last snapshot to this one (see GetRenderAlpha).
+    void ApplySnapshot(const Snapshot& snapshot)
+    {
+        if (lastSnapshotTick != 0 && snapshot.Tick > lastSnapshotTick)
+            snapshotTicks = snapshot.Tick - lastSnapshotTick;
+        lastSnapshotTick = snapshot.Tick;
+        ticksSinceSnapshot = 0;
+
+        for (const NetEntityState& state : snapshot.Entities)
+        {
+            auto it = mirrored.find(state.Id);
+            if (it != mirrored.end() && it->second.Generation != state.Generation)
+            {
+                Entities.Destroy(it->second.Local);
+                mirrored.erase(it);
+                it = mirrored.end();
+            }
+            bool created = it == mirrored.end();
+            if (created)
+            {
+                Mirrored entry;
+                entry.Local = Entities.Create();
+                entry.Generation = state.Generation;
+                Transform transform;
+                transform.Scale = glm::vec3(WandererSize(state.Kind));
+                Entities.Add<Transform>(entry.Local, transform);
+                Entities.Add<PreviousTransform>(entry.Local);
+                Replicated replicated;
+                replicated.Kind = state.Kind;
+                Entities.Add<Replicated>(entry.Local, replicated);
+                it = mirrored.emplace(state.Id, entry).first;
+            }
+            it->second.Tick = snapshot.Tick;
+            Transform* transform = Entities.Get<Transform>(it->second.Local);
+            PreviousTransform* previous = Entities.Get<PreviousTransform>(it->second.Local);
+            previous->Value = *transform;
+            for (int k = 0; k < 3; ++k)
+                transform->Position[k] = DequantizePosition(state.Position[k]);
+            transform->Rotation = DequantizeRotation(state.Rotation);
+            // a new entity appears where it is instead of sliding in from the origin
+            if (created)
+                previous->Value = *transform;
+        }
+        for (auto it = mirrored.begin(); it != mirrored.end();)
+        {
+            if (it->second.Tick == snapshot.Tick)
+            {
+                ++it;
+                continue;
+            }
+            Entities.Destroy(it->second.Local);
+            it = mirrored.erase(it);
+        }
+    }
+
+    void Tick(float tickSeconds)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        ticksSinceSnapshot++;
+
+        // steering and movement are per entity, so chunks can go to any thread
+        auto update = [this, tickSeconds](uint32_t count, const Entity*, Transform* transforms, PreviousTransform* previous, Velocity* velocities, Wanderer* wanderers) {
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                previous[i].Value = transforms[i];
+                updateWanderer(transforms[i], velocities[i], wanderers[i], tickSeconds);
+            }
+        };
+        if (Jobs)
+            Entities.EachChunkParallel<Transform, PreviousTransform, Velocity, Wanderer>(*Jobs, update);
+        else
+            Entities.EachChunk<Transform, PreviousTransform, Velocity, Wanderer>(update);
+
+        Collision.Colliders.assign(Obstacles.begin(), Obstacles.end());
+        Entities.EachChunk<const Transform, const Replicated>([this](uint32_t count, const Entity*, const Transform* transforms, const Replicated*) {
+            for (uint32_t i = 0; i < count; ++i)
+                Collision.Colliders.push_back(WandererBounds(transforms[i].Position, transforms[i].Scale));
+        });
+        Collision.Broadphase.Jobs = Jobs;
+        Collision.Rebuild();
+
+        for (size_t i = 0; i < Players.size(); ++i)
+        {
+            for (const PlayerInput& input : inputs[i])
+                Players[i].Move(input, tickSeconds, Collision);
+            inputs[i].clear();
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.Ticks++;
+        Stats.LastTickMs = std::chrono::duration<double, std::milli>(end - start).count();
+        Stats.TotalTickMs += Stats.LastTickMs;
+        Stats.MaxTickMs = std::max(Stats.MaxTickMs, Stats.LastTickMs);
+    }
+
+private:
+    // a server entity as mirrored here; Tick is the last snapshot it was in
+    struct Mirrored
+    {
+        Entity Local;
+        uint32_t Generation = 0;
+        uint32_t Tick = 0;
+    };
+
+    std::vector<Entity> wanderers;
+    // server entity id -> local copy
+    std::unordered_map<uint32_t, Mirrored> mirrored;
+    // per player, for the next tick
+    std::vector<std::vector<PlayerInput>> inputs;
+    uint32_t spawned = 0;
+    // server ticks between the last two snapshots, and client ticks since the last one arrived
+    uint32_t lastSnapshotTick = 0;
+    uint32_t snapshotTicks = 1;
+    uint32_t ticksSinceSnapshot = 0;
+
+    static uint32_t hash(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352du;
+        x ^= x >> 15;
+        x *= 0x846ca68bu;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // [0, 1), the same on every machine for the same seed and stream
+    static float random(uint32_t seed, uint32_t stream)
+    {
+        return (float)(hash(seed ^ (stream * 0x9e3779b9u)) >> 8) / 16777216.0f;
+    }
+
+    float groundHeight(float x, float z) const
+    {
+        return Collision.Ground.Height ? Collision.Ground.GetHeight(x, z) : 0.0f;
+    }
+
+    void updateWanderer(Transform& transform, Velocity& velocity, Wanderer& wanderer, float tickSeconds)
+    {
+        if (wanderer.TurnIn == 0)
+        {
+            uint32_t seed = hash(wanderer.Seed + wanderer.Turns++);
+            float heading = random(seed, 0) * 6.2831853f;
+            velocity.Linear = glm::vec3(std::cos(heading), 0.0f, std::sin(heading)) * wanderer.Speed;
+            transform.Rotation = glm::angleAxis(-heading, glm::vec3(0.0f, 1.0f, 0.0f));
+            wanderer.TurnIn = 60 + (uint32_t)(random(seed, 1) * 240.0f);
+        }
+        wanderer.TurnIn--;
+
+        transform.Position += velocity.Linear * tickSeconds;
+        // turn back at the edge of the area
+        for (int k = 0; k < 3; k += 2)
+        {
+            if (std::fabs(transform.Position[k]) > Extent && transform.Position[k] * velocity.Linear[k] > 0.0f)
+            {
+                velocity.Linear[k] = -velocity.Linear[k];
+                float heading = std::atan2(velocity.Linear.z, velocity.Linear.x);
+                transform.Rotation = glm::angleAxis(-heading, glm::vec3(0.0f, 1.0f, 0.0f));
+            }
+        }
+        transform.Position.y = groundHeight(transform.Position.x, transform.Position.z);
+    }
+};
+#endif
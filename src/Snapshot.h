@@ -0,0 +1,273 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "BitStream.h"
+#include "Components.h"
+#include "ECS.h"
+
+// Quantized entity state as replicated to clients, and delta compression of one snapshot against
+// an older one both sides have. Only entities that changed are written, so a snapshot's size
+// follows what moved rather than how many entities exist.
+
+// positions travel as fixed point with this many steps per unit (4 mm)
+const float SNAPSHOT_POSITION_SCALE = 256.0f;
+
+// one replicated entity; Id is the entity index and Generation tells reuses of an index apart
+struct NetEntityState
+{
+    uint32_t Id = 0;
+    uint32_t Generation = 0;
+    uint32_t Kind = 0;
+    int32_t Position[3] = { 0, 0, 0 };
+    // smallest-three: index of the dropped component in the top 2 bits, 3 x 10 bits for the rest
+    uint32_t Rotation = 0;
+
+    bool operator==(const NetEntityState& other) const
+    {
+        return Id == other.Id && Generation == other.Generation && Kind == other.Kind && Position[0] == other.Position[0] &&
+               Position[1] == other.Position[1] && Position[2] == other.Position[2] && Rotation == other.Rotation;
+    }
+    bool operator!=(const NetEntityState& other) const { return !(*this == other); }
+};
+
+// all replicated entities of one tick, sorted by Id
+struct Snapshot
+{
+    uint32_t Tick = 0;
+    std::vector<NetEntityState> Entities;
+};
+
+inline int32_t QuantizePosition(float value)
+{
+    return (int32_t)std::lround(value * SNAPSHOT_POSITION_SCALE);
+}
+
+inline float DequantizePosition(int32_t value)
+{
+    return (float)value / SNAPSHOT_POSITION_SCALE;
+}
+
+inline uint32_t QuantizeRotation(const glm::quat& rotation)
+{
+    float q[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+    uint32_t largest = 0;
+    for (uint32_t i = 1; i < 4; ++i)
+        if (std::fabs(q[i]) > std::fabs(q[largest]))
+            largest = i;
+    // q and -q are the same rotation, so the dropped component can always be made positive
+    float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+    uint32_t packed = largest << 30;
+    uint32_t shift = 20;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        // the other three lie in [-1/sqrt2, 1/sqrt2]
+        float unit = glm::clamp(q[i] * sign * 0.70710678f + 0.5f, 0.0f, 1.0f);
+        packed |= (uint32_t)std::lround(unit * 1023.0f) << shift;
+        shift -= 10;
+    }
+    return packed;
+}
+
+inline glm::quat DequantizeRotation(uint32_t packed)
+{
+    uint32_t largest = packed >> 30;
+    float q[4];
+    float sum = 0.0f;
+    uint32_t shift = 20;
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+        q[i] = ((float)((packed >> shift) & 1023u) / 1023.0f - 0.5f) * 1.41421356f;
+        sum += q[i] * q[i];
+        shift -= 10;
+    }
+    q[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+    return glm::quat(q[3], q[0], q[1], q[2]);
+}
+
+// entities with Transform + Replicated, quantized, sorted by Id
+inline void CaptureSnapshot(World& world, uint32_t tick, Snapshot& snapshot)
+{
+    snapshot.Tick = tick;
+    snapshot.Entities.clear();
+    world.EachChunk<const Transform, const Replicated>([&](uint32_t count, const Entity* entities, const Transform* transforms, const Replicated* replicated) {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            NetEntityState state;
+            state.Id = entities[i].Index;
+            state.Generation = entities[i].Generation;
+            state.Kind = replicated[i].Kind;
+            for (int k = 0; k < 3; ++k)
+                state.Position[k] = QuantizePosition(transforms[i].Position[k]);
+            state.Rotation = QuantizeRotation(transforms[i].Rotation);
+            snapshot.Entities.push_back(state);
+        }
+    });
+    std::sort(snapshot.Entities.begin(), snapshot.Entities.end(), [](const NetEntityState& a, const NetEntityState& b) { return a.Id < b.Id; });
+}
+
+// Layout: removed ids, then changed or new entities, each list as a count and id gaps. A changed
+// entity carries only the fields that differ from the baseline, positions as deltas; a new one
+// (or a reused id) carries everything. Without a baseline every entity is new.
+inline void EncodeSnapshot(const Snapshot& snapshot, const Snapshot* baseline, BitWriter& writer)
+{
+    static const std::vector<NetEntityState> NONE;
+    const std::vector<NetEntityState>& current = snapshot.Entities;
+    const std::vector<NetEntityState>& previous = baseline ? baseline->Entities : NONE;
+
+    // removals: in the baseline, not in the snapshot
+    uint32_t removed = 0;
+    for (size_t i = 0, j = 0; j < previous.size(); ++j)
+    {
+        while (i < current.size() && current[i].Id < previous[j].Id)
+            i++;
+        if (i == current.size() || current[i].Id != previous[j].Id)
+            removed++;
+    }
+    writer.WriteVar(removed);
+    uint32_t lastId = 0;
+    for (size_t i = 0, j = 0; j < previous.size(); ++j)
+    {
+        while (i < current.size() && current[i].Id < previous[j].Id)
+            i++;
+        if (i == current.size() || current[i].Id != previous[j].Id)
+        {
+            writer.WriteVar(previous[j].Id - lastId);
+            lastId = previous[j].Id;
+        }
+    }
+
+    // changes are counted first so the reader knows when to stop; the second pass writes them
+    uint32_t changed = 0;
+    for (size_t i = 0, j = 0; i < current.size(); ++i)
+    {
+        while (j < previous.size() && previous[j].Id < current[i].Id)
+            j++;
+        if (j == previous.size() || previous[j] != current[i])
+            changed++;
+    }
+    writer.WriteVar(changed);
+    lastId = 0;
+    for (size_t i = 0, j = 0; i < current.size(); ++i)
+    {
+        while (j < previous.size() && previous[j].Id < current[i].Id)
+            j++;
+        const NetEntityState& state = current[i];
+        bool known = j < previous.size() && previous[j].Id == state.Id && previous[j].Generation == state.Generation;
+        if (known && previous[j] == state)
+            continue;
+        writer.WriteVar(state.Id - lastId);
+        lastId = state.Id;
+        writer.WriteBool(known);
+        if (known)
+        {
+            const NetEntityState& old = previous[j];
+            bool moved = old.Position[0] != state.Position[0] || old.Position[1] != state.Position[1] || old.Position[2] != state.Position[2];
+            writer.WriteBool(moved);
+            if (moved)
+            {
+                for (int k = 0; k < 3; ++k)
+                    writer.WriteSignedVar(state.Position[k] - old.Position[k]);
+            }
+            writer.WriteBool(old.Rotation != state.Rotation);
+            if (old.Rotation != state.Rotation)
+                writer.Write(state.Rotation, 32);
+            writer.WriteBool(old.Kind != state.Kind);
+            if (old.Kind != state.Kind)
+                writer.WriteVar(state.Kind);
+        }
+        else
+        {
+            writer.WriteVar(state.Generation);
+            writer.WriteVar(state.Kind);
+            for (int k = 0; k < 3; ++k)
+                writer.WriteSignedVar(state.Position[k]);
+            writer.Write(state.Rotation, 32);
+        }
+    }
+}
+
+// rebuilds the snapshot from the baseline it was encoded against; false if the data is malformed
+inline bool DecodeSnapshot(BitReader& reader, const Snapshot* baseline, Snapshot& snapshot)
+{
+    static const std::vector<NetEntityState> NONE;
+    const std::vector<NetEntityState>& previous = baseline ? baseline->Entities : NONE;
+    std::vector<NetEntityState>& current = snapshot.Entities;
+    current.clear();
+
+    uint32_t removedCount = reader.ReadVar();
+    if (removedCount > previous.size())
+        return false;
+    std::vector<uint32_t> removed(removedCount);
+    uint32_t id = 0;
+    for (uint32_t& removedId : removed)
+    {
+        id += reader.ReadVar();
+        removedId = id;
+    }
+
+    // one merge over the baseline: removed entities are skipped, changed ones patched, new ones
+    // inserted where their id belongs
+    size_t next = 0, nextRemoved = 0;
+    auto copyBefore = [&](uint64_t end) {
+        for (; next < previous.size() && previous[next].Id < end; ++next)
+        {
+            if (nextRemoved < removed.size() && removed[nextRemoved] == previous[next].Id)
+                nextRemoved++;
+            else
+                current.push_back(previous[next]);
+        }
+    };
+    uint32_t changed = reader.ReadVar();
+    current.reserve(previous.size());
+    id = 0;
+    for (uint32_t c = 0; c < changed && !reader.Overflow; ++c)
+    {
+        id += reader.ReadVar();
+        copyBefore(id);
+        bool exists = next < previous.size() && previous[next].Id == id;
+        NetEntityState state;
+        if (reader.ReadBool())
+        {
+            if (!exists)
+                return false;
+            state = previous[next];
+            if (reader.ReadBool())
+            {
+                for (int k = 0; k < 3; ++k)
+                    state.Position[k] += reader.ReadSignedVar();
+            }
+            if (reader.ReadBool())
+                state.Rotation = reader.Read(32);
+            if (reader.ReadBool())
+                state.Kind = reader.ReadVar();
+        }
+        else
+        {
+            state.Id = id;
+            state.Generation = reader.ReadVar();
+            state.Kind = reader.ReadVar();
+            for (int k = 0; k < 3; ++k)
+                state.Position[k] = reader.ReadSignedVar();
+            state.Rotation = reader.Read(32);
+        }
+        // a respawned id replaces the old entity
+        if (exists)
+            next++;
+        current.push_back(state);
+    }
+    copyBefore(0x100000000ull);
+    return !reader.Overflow && nextRemoved == removed.size();
+}
+#endif
@@ -0,0 +1,295 @@
+#ifndef STRESS_SCENE_H
+#define STRESS_SCENE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Collision.h"
+#include "Components.h"
+#include "Culling.h"
+#include "Frustum.h"
+#include "InstancedRenderer.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+
+// Spawns a configurable number of cubes scattered on the ground plane and draws all of them with
+// one instanced draw call, plus individually drawn props with mixed meshes and materials
+class StressScene
+{
+public:
+    int Count = 1000;
+    int PropCount = 500;
+    bool Animate = true;
+    // cubes are scattered in [-Extent, Extent] on x/z
+    float Extent = 48.0f;
+    // optional; instance data of the visible cubes is then built on all worker threads
+    JobSystem* Jobs = nullptr;
+    // bumped whenever the static shadow casters change (respawn, or cubes start/stop moving)
+    unsigned int StaticCasterVersion = 0;
+
+    void Init()
+    {
+        cubeMesh.Init(CreateCubeMeshData(), VertexLayout::Compact());
+        pyramidMesh.Init(CreatePyramidMeshData(), VertexLayout::Compact());
+        batch.Init(cubeMesh.VAO);
+        // instance attributes live in the VAO, so the shadow batch needs a cube of its own
+        shadowCubeMesh.Init(CreateCubeMeshData(), VertexLayout::Compact());
+        shadowBatch.Init(shadowCubeMesh.VAO);
+    }
+
+    void Delete()
+    {
+        batch.Delete();
+        cubeMesh.Delete();
+        shadowBatch.Delete();
+        shadowCubeMesh.Delete();
+        pyramidMesh.Delete();
+    }
+
+    // culls against the frustum, rebuilds and uploads the instance data of the visible cubes, then
+    // queues one instanced item for them and one plain item per visible prop
+    void Submit(RenderQueue& queue, Shader& instancedProgram, Shader& propProgram, float time, const Frustum& frustum)
+    {
+        respawnIfNeeded();
+
+        auto cullStart = std::chrono::high_resolution_clock::now();
+        size_t visibleCount = CullSpheres(frustum, bounds, visible);
+        size_t visibleProps = CullSpheres(frustum, propBounds, visibleProp);
+        auto cullEnd = std::chrono::high_resolution_clock::now();
+
+        CullStats& cullStats = GetCullStats();
+        cullStats.Tested += (unsigned int)(spawned.size() + props.size());
+        cullStats.Visible += (unsigned int)(visibleCount + visibleProps);
+        cullStats.CullMs += std::chrono::duration<double, std::milli>(cullEnd - cullStart).count();
+
+        batch.Instances.resize(visibleCount);
+        auto build = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t v = begin; v < end; ++v)
+            {
+                uint32_t i = visible[v];
+                const Spawn& s = spawned[i];
+                InstanceData& instance = batch.Instances[v];
+                instance.Model = cubeMatrix(s, Animate ? time : 0.0f);
+                instance.Color = s.Color;
+            }
+        };
+        if (Jobs)
+            Jobs->ParallelFor((uint32_t)visibleCount, build);
+        else
+            build(0, (uint32_t)visibleCount);
+
+        batch.Upload();
+        queue.SubmitInstanced(cubeMesh, batch, instancedProgram, 0);
+
+        for (size_t v = 0; v < visibleProps; ++v)
+        {
+            const Prop& prop = props[visibleProp[v]];
+            queue.Submit(prop.Pyramid ? pyramidMesh : cubeMesh, propProgram, prop.Material, prop.Model);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        GetRenderStats().SubmitMs += std::chrono::duration<double, std::milli>(end - cullEnd).count();
+    }
+
+    // rebuilds the shadow instances of every cube (not just the visible ones) when they have changed;
+    // call once per frame before the shadow pass
+    void PrepareShadowCasters(float time)
+    {
+        respawnIfNeeded();
+        if (Animate != animatedCasters)
+        {
+            animatedCasters = Animate;
+            StaticCasterVersion++;
+            shadowInstancesValid = false;
+        }
+        if (shadowInstancesValid && !Animate)
+            return;
+
+        shadowInstances.resize(spawned.size());
+        auto build = [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i)
+                shadowInstances[i].Model = cubeMatrix(spawned[i], Animate ? time : 0.0f);
+        };
+        if (Jobs)
+            Jobs->ParallelFor((uint32_t)spawned.size(), build);
+        else
+            build(0, (uint32_t)spawned.size());
+        shadowInstancesValid = true;
+    }
+
+    // shadow casters of one pass: props and resting cubes are static, spinning cubes are dynamic.
+    // Only the cubes and props inside the cascade's frustum are drawn. FrameConstants must hold the
+    // cascade's matrices.
+    void DrawShadowCasters(Shader& program, Shader& instancedProgram, const Frustum& frustum, bool dynamicPass)
+    {
+        if (Animate == dynamicPass)
+        {
+            size_t visibleCubes = CullSpheres(frustum, bounds, shadowVisible);
+            shadowBatch.Instances.resize(visibleCubes);
+            for (size_t v = 0; v < visibleCubes; ++v)
+                shadowBatch.Instances[v] = shadowInstances[shadowVisible[v]];
+            shadowBatch.Upload();
+            instancedProgram.Use();
+            shadowCubeMesh.DrawInstanced(shadowBatch);
+        }
+        if (dynamicPass)
+            return;
+
+        size_t visibleProps = CullSpheres(frustum, propBounds, shadowVisible);
+        program.Use();
+        UniformHandle model = program.FindUniform("model");
+        for (size_t v = 0; v < visibleProps; ++v)
+        {
+            const Prop& prop = props[shadowVisible[v]];
+            program.SetMat4(model, prop.Model);
+            (prop.Pyramid ? pyramidMesh : cubeMesh).Draw();
+        }
+    }
+
+    // appends a sphere per cube DrawShadowCasters draws in its dynamic pass
+    void AppendDynamicBounds(SphereBoundsSoA& out) const
+    {
+        if (!Animate)
+            return;
+        for (size_t i = 0; i < bounds.Size(); ++i)
+            out.Add(glm::vec3(bounds.X[i], bounds.Y[i], bounds.Z[i]), bounds.Radius[i]);
+    }
+
+    // appends boxes around every cube (posed as at time) and prop, for the collision world
+    void AppendColliders(std::vector<AABB>& out, float time)
+    {
+        respawnIfNeeded();
+        size_t first = out.size();
+        out.resize(first + spawned.size() + props.size());
+        for (size_t i = 0; i < spawned.size(); ++i)
+        {
+            const Spawn& s = spawned[i];
+            // a square spun about y by angle reaches half * (|cos| + |sin|) along x and z
+            float angle = Animate ? time * s.Spin : 0.0f;
+            float half = s.Size * 0.5f;
+            float reach = half * (std::fabs(std::cos(angle)) + std::fabs(std::sin(angle)));
+            AABB& box = out[first + i];
+            box.Min = s.Position - glm::vec3(reach, half, reach);
+            box.Max = s.Position + glm::vec3(reach, half, reach);
+        }
+        first += spawned.size();
+        for (size_t i = 0; i < props.size(); ++i)
+            out[first + i] = props[i].Box;
+    }
+
+private:
+    struct Spawn
+    {
+        glm::vec3 Position;
+        glm::vec4 Color;
+        float Size;
+        float Spin;
+    };
+
+    // individually drawn object, the kind of draw the render queue sorts
+    struct Prop
+    {
+        glm::mat4 Model;
+        uint32_t Material;
+        bool Pyramid;
+        AABB Box;
+    };
+
+    Mesh cubeMesh;
+    Mesh pyramidMesh;
+    std::vector<Prop> props;
+    SphereBoundsSoA propBounds;
+    std::vector<uint32_t> visibleProp;
+    InstanceBatch batch;
+    std::vector<Spawn> spawned;
+    SphereBoundsSoA bounds;
+    std::vector<uint32_t> visible;
+
+    Mesh shadowCubeMesh;
+    // every cube posed for the shadow pass; each cascade uploads the ones in its frustum
+    std::vector<InstanceData> shadowInstances;
+    InstanceBatch shadowBatch;
+    std::vector<uint32_t> shadowVisible;
+    bool shadowInstancesValid = false;
+    bool animatedCasters = true;
+
+    void respawnIfNeeded()
+    {
+        if ((int)spawned.size() != Count)
+        {
+            spawn();
+            shadowInstancesValid = false;
+            StaticCasterVersion++;
+        }
+        if ((int)props.size() != PropCount)
+        {
+            spawnProps();
+            StaticCasterVersion++;
+        }
+    }
+
+    static glm::mat4 cubeMatrix(const Spawn& s, float time)
+    {
+        Transform transform;
+        transform.Position = s.Position;
+        transform.Rotation = glm::angleAxis(time * s.Spin, glm::vec3(0.0f, 1.0f, 0.0f));
+        transform.Scale = glm::vec3(s.Size);
+        return transform.ToMatrix();
+    }
+
+    // deterministic placement so the same count always produces the same scene
+    void spawn()
+    {
+        std::mt19937 rng(1337);
+        std::uniform_real_distribution<float> position(-Extent, Extent);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        spawned.resize(Count);
+        bounds.Resize(Count);
+        for (int i = 0; i < Count; ++i)
+        {
+            Spawn& s = spawned[i];
+            s.Size = 0.3f + 0.4f * unit(rng);
+            s.Position = glm::vec3(position(rng), s.Size * 0.5f, position(rng));
+            s.Color = glm::vec4(0.3f + 0.7f * unit(rng), 0.3f + 0.7f * unit(rng), 0.3f + 0.7f * unit(rng), 1.0f);
+            s.Spin = unit(rng) * 2.0f - 1.0f;
+            // radius of the cube's circumscribed sphere, so any rotation stays inside it
+            bounds.Set(i, s.Position, s.Size * 0.8660254f);
+        }
+    }
+
+    // props use materials 1..4 of the render queue, in random order on purpose
+    void spawnProps()
+    {
+        std::mt19937 rng(4242);
+        std::uniform_real_distribution<float> position(-Extent, Extent);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+        props.resize(PropCount);
+        propBounds.Resize(PropCount);
+        for (int i = 0; i < PropCount; ++i)
+        {
+            Prop& prop = props[i];
+            float size = 0.5f + unit(rng);
+            glm::vec3 center(position(rng), 0.0f, position(rng));
+            prop.Pyramid = unit(rng) < 0.5f;
+            prop.Material = 1 + (uint32_t)(unit(rng) * 4.0f) % 4;
+            // cube is centered on its origin, the pyramid sits on it
+            glm::vec3 base = prop.Pyramid ? center : center + glm::vec3(0.0f, size * 0.5f, 0.0f);
+            prop.Model = glm::scale(glm::translate(glm::mat4(1.0f), base), glm::vec3(size));
+            propBounds.Set(i, center + glm::vec3(0.0f, size * 0.5f, 0.0f), size * 0.8660254f);
+            // both meshes fill a unit box standing on the ground
+            prop.Box.Min = center - glm::vec3(size * 0.5f, 0.0f, size * 0.5f);
+            prop.Box.Max = center + glm::vec3(size * 0.5f, size, size * 0.5f);
+        }
+    }
+};
+#endif
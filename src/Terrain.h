@@ -0,0 +1,354 @@
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Frustum.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "TerrainHeightmap.h"
+
+// Per-frame terrain counters, shown in the Debug Info window
+struct TerrainStats
+{
+    unsigned int Nodes = 0;
+    unsigned int Triangles = 0;
+    double SelectMs = 0.0;
+};
+
+// Chunked heightfield terrain with continuous distance-based LOD (CDLOD). A single N x N grid mesh is
+// shared by every chunk; the vertex shader places it over the chunk, samples the heightmap and morphs
+// vertices towards the next coarser grid near the end of each LOD range so transitions never pop.
+class Terrain
+{
+public:
+    float WorldSize = 4096.0f;      // terrain spans [-WorldSize/2, WorldSize/2] on x/z
+    int HeightmapResolution = 1024; // heightmap has Resolution + 1 samples per side
+    float HeightScale = 160.0f;
+    float FlatRadius = 60.0f;       // area around the origin kept flat at y = 0 for the test scene
+    int LodCount = 8;               // root node covers the world, leaves are WorldSize / 2^(LodCount-1)
+    int GridSize = 32;              // quads per side of the shared grid mesh
+    float LodRange0 = 64.0f;        // distance covered by LOD 0, doubles for each coarser level
+    float MorphStartRatio = 0.66f;  // fraction of a LOD range after which vertices start morphing
+
+    TerrainStats Stats;
+
+    void Init(Shader&& program)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        heights.WorldSize = WorldSize;
+        heights.Resolution = HeightmapResolution;
+        heights.HeightScale = HeightScale;
+        heights.FlatRadius = FlatRadius;
+        heights.Generate();
+        buildMinMax();
+        buildGrid();
+
+        ranges.resize(LodCount);
+        for (int lod = 0; lod < LodCount; ++lod)
+            ranges[lod] = LodRange0 * std::pow(2.0f, (float)lod);
+
+        glGenTextures(1, &heightmap);
+        glBindTexture(GL_TEXTURE_2D, heightmap);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, samples(), samples(), 0, GL_RED, GL_FLOAT, heights.Heights.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        SetProgram(std::move(program));
+
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "Terrain generated (" << samples() << "x" << samples() << " heightmap) in "
+                  << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    }
+
+    void Delete()
+    {
+        grid.Delete();
+        lit.Program.Delete();
+        shadow.Program.Delete();
+        if (heightmap)
+            glDeleteTextures(1, &heightmap);
+        heightmap = 0;
+    }
+
+    // replaces the terrain program (e.g. after a hot reload) and looks its uniforms up again
+    void SetProgram(Shader&& program)
+    {
+        lit.Set(std::move(program));
+    }
+
+    // depth-only variant used for the shadow maps
+    void SetShadowProgram(Shader&& program)
+    {
+        shadow.Set(std::move(program));
+    }
+
+    // farthest distance any LOD covers; a sensible camera far plane
+    float GetViewDistance() const
+    {
+        return ranges.empty() ? 0.0f : ranges.back();
+    }
+
+    // bilinear height at a world position, matching what the GPU samples
+    float GetHeight(float x, float z) const
+    {
+        return heights.GetHeight(x, z);
+    }
+
+    // the CPU-side heights, e.g. for collision
+    const TerrainHeightmap& GetHeightmap() const
+    {
+        return heights;
+    }
+
+    // selects the chunks for this frame and draws them; FrameConstants must already be bound
+    void Draw(const Frustum& frustum, const glm::vec3& cameraPosition)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        selection.clear();
+        selectNode(0, 0, LodCount - 1, frustum, cameraPosition);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        Stats.SelectMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+        Stats.Triangles = drawSelection(lit);
+        Stats.Nodes = (unsigned int)selection.size();
+    }
+
+    // draws the chunks inside a shadow cascade with the shadow program. LODs are still chosen from
+    // the camera position so the shadow caster matches the surface that receives the shadow.
+    void DrawShadow(const Frustum& frustum, const glm::vec3& cameraPosition)
+    {
+        selection.clear();
+        selectNode(0, 0, LodCount - 1, frustum, cameraPosition);
+        drawSelection(shadow);
+    }
+
+private:
+    struct SelectedNode
+    {
+        int X, Z, Lod;
+        int QuadrantMask; // which quarters of the node to draw at this LOD
+    };
+
+    TerrainHeightmap heights;
+    // per LOD level, min/max height of every node, used for culling and range tests
+    std::vector<std::vector<glm::vec2>> minMax;
+    std::vector<float> ranges;
+    std::vector<SelectedNode> selection;
+
+    // a program built from terrain_vertex.glsl with its uniform handles
+    struct TerrainProgram
+    {
+        Shader Program;
+        UniformHandle NodeOffset = INVALID_UNIFORM, NodeScale = INVALID_UNIFORM, MorphRange = INVALID_UNIFORM;
+        UniformHandle GridSize = INVALID_UNIFORM, WorldSize = INVALID_UNIFORM, Heightmap = INVALID_UNIFORM;
+
+        void Set(Shader&& program)
+        {
+            Program = std::move(program);
+            NodeOffset = Program.FindUniform("nodeOffset");
+            NodeScale = Program.FindUniform("nodeScale");
+            MorphRange = Program.FindUniform("morphRange");
+            GridSize = Program.FindUniform("gridSize");
+            WorldSize = Program.FindUniform("worldSize");
+            Heightmap = Program.FindUniform("heightmap");
+        }
+    };
+
+    Mesh grid;
+    TerrainProgram lit;
+    TerrainProgram shadow;
+    GLuint heightmap = 0;
+
+    // draws the selected chunks and returns the triangle count
+    unsigned int drawSelection(TerrainProgram& program)
+    {
+        Shader& shader = program.Program;
+        shader.Use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, heightmap);
+        shader.SetInt(program.Heightmap, 0);
+        shader.SetFloat(program.GridSize, (float)GridSize);
+        shader.SetFloat(program.WorldSize, WorldSize);
+
+        unsigned int triangles = 0;
+        const GLsizei quadrantIndices = (GridSize / 2) * (GridSize / 2) * 6;
+        for (const SelectedNode& node : selection)
+        {
+            float size = nodeSize(node.Lod);
+            shader.SetVec2(program.NodeOffset, glm::vec2(-WorldSize * 0.5f + node.X * size, -WorldSize * 0.5f + node.Z * size));
+            shader.SetFloat(program.NodeScale, size);
+            shader.SetVec2(program.MorphRange, morphRange(node.Lod));
+
+            if (node.QuadrantMask == 0xF)
+            {
+                grid.Draw();
+                triangles += (unsigned int)grid.IndexCount / 3;
+            }
+            else
+            {
+                // quadrants are stored contiguously in the index buffer, so each one is a single range
+                for (int q = 0; q < 4; ++q)
+                {
+                    if (node.QuadrantMask & (1 << q))
+                    {
+                        grid.DrawRange(q * quadrantIndices, quadrantIndices);
+                        triangles += (unsigned int)quadrantIndices / 3;
+                    }
+                }
+            }
+        }
+        return triangles;
+    }
+
+    int samples() const { return HeightmapResolution + 1; }
+    float heightAt(int x, int z) const { return heights.At(x, z); }
+    float nodeSize(int lod) const { return WorldSize / (float)(1 << (LodCount - 1 - lod)); }
+    int nodesPerSide(int lod) const { return 1 << (LodCount - 1 - lod); }
+
+    glm::vec2 morphRange(int lod) const
+    {
+        float previous = lod > 0 ? ranges[lod - 1] : 0.0f;
+        float end = ranges[lod];
+        return glm::vec2(previous + (end - previous) * MorphStartRatio, end);
+    }
+
+    void buildMinMax()
+    {
+        minMax.assign(LodCount, std::vector<glm::vec2>());
+        int leaves = nodesPerSide(0);
+        int texelsPerLeaf = HeightmapResolution / leaves;
+        minMax[0].resize((size_t)leaves * leaves);
+        for (int nz = 0; nz < leaves; ++nz)
+        {
+            for (int nx = 0; nx < leaves; ++nx)
+            {
+                glm::vec2 range(1e30f, -1e30f);
+                for (int z = nz * texelsPerLeaf; z <= (nz + 1) * texelsPerLeaf; ++z)
+                {
+                    for (int x = nx * texelsPerLeaf; x <= (nx + 1) * texelsPerLeaf; ++x)
+                    {
+                        float h = heightAt(x, z);
+                        range.x = std::min(range.x, h);
+                        range.y = std::max(range.y, h);
+                    }
+                }
+                minMax[0][(size_t)nz * leaves + nx] = range;
+            }
+        }
+
+        for (int lod = 1; lod < LodCount; ++lod)
+        {
+            int count = nodesPerSide(lod);
+            int childCount = nodesPerSide(lod - 1);
+            minMax[lod].resize((size_t)count * count);
+            for (int nz = 0; nz < count; ++nz)
+            {
+                for (int nx = 0; nx < count; ++nx)
+                {
+                    glm::vec2 range(1e30f, -1e30f);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        glm::vec2 child = minMax[lod - 1][(size_t)(nz * 2 + (c >> 1)) * childCount + nx * 2 + (c & 1)];
+                        range.x = std::min(range.x, child.x);
+                        range.y = std::max(range.y, child.y);
+                    }
+                    minMax[lod][(size_t)nz * count + nx] = range;
+                }
+            }
+        }
+    }
+
+    // (GridSize + 1)^2 vertices in [0, 1]^2, indices grouped per quadrant so each quarter can be drawn alone
+    void buildGrid()
+    {
+        MeshData data;
+        for (int z = 0; z <= GridSize; ++z)
+        {
+            for (int x = 0; x <= GridSize; ++x)
+                data.Positions.push_back(glm::vec3((float)x / GridSize, (float)z / GridSize, 0.0f));
+        }
+
+        int half = GridSize / 2;
+        for (int q = 0; q < 4; ++q)
+        {
+            int qx = (q & 1) * half, qz = (q >> 1) * half;
+            for (int z = qz; z < qz + half; ++z)
+            {
+                for (int x = qx; x < qx + half; ++x)
+                {
+                    uint32_t i0 = (uint32_t)(z * (GridSize + 1) + x);
+                    uint32_t i1 = i0 + 1;
+                    uint32_t i2 = i0 + (GridSize + 1);
+                    uint32_t i3 = i2 + 1;
+                    data.Indices.insert(data.Indices.end(), { i0, i2, i1, i1, i2, i3 });
+                }
+            }
+        }
+
+        VertexLayout layout;
+        layout.Add(POSITION, 2, GL_FLOAT);
+        grid.Init(data, layout);
+    }
+
+    void nodeBounds(int x, int z, int lod, glm::vec3& min, glm::vec3& max) const
+    {
+        float size = nodeSize(lod);
+        glm::vec2 range = minMax[lod][(size_t)z * nodesPerSide(lod) + x];
+        min = glm::vec3(-WorldSize * 0.5f + x * size, range.x, -WorldSize * 0.5f + z * size);
+        max = glm::vec3(min.x + size, range.y, min.z + size);
+    }
+
+    static bool intersectsSphere(const glm::vec3& min, const glm::vec3& max, const glm::vec3& center, float radius)
+    {
+        glm::vec3 closest = glm::clamp(center, min, max);
+        glm::vec3 delta = closest - center;
+        return glm::dot(delta, delta) <= radius * radius;
+    }
+
+    // Classic CDLOD selection. Returns false when the node is outside its LOD range, in which case the
+    // parent covers that area itself at its own (coarser) LOD.
+    bool selectNode(int x, int z, int lod, const Frustum& frustum, const glm::vec3& cameraPosition)
+    {
+        glm::vec3 min, max;
+        nodeBounds(x, z, lod, min, max);
+
+        if (!intersectsSphere(min, max, cameraPosition, ranges[lod]))
+            return false;
+        // out of view: handled, nothing to draw
+        if (!frustum.IntersectsAABB(min, max))
+            return true;
+
+        if (lod == 0 || !intersectsSphere(min, max, cameraPosition, ranges[lod - 1]))
+        {
+            selection.push_back({ x, z, lod, 0xF });
+            return true;
+        }
+
+        int mask = 0;
+        for (int q = 0; q < 4; ++q)
+        {
+            if (!selectNode(x * 2 + (q & 1), z * 2 + (q >> 1), lod - 1, frustum, cameraPosition))
+                mask |= 1 << q;
+        }
+        if (mask)
+            selection.push_back({ x, z, lod, mask });
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,113 @@
+#ifndef TERRAIN_HEIGHTMAP_H
+#define TERRAIN_HEIGHTMAP_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "Collision.h"
+
+// The terrain's heights without any GL: the renderer uploads them as a texture, the simulation
+// walks on them. Both generate the same heights from the same settings.
+
+// Deterministic value-noise fbm used to generate the heightfield
+inline float TerrainHash(int x, int z)
+{
+    uint32_t h = (uint32_t)x * 374761393u + (uint32_t)z * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    h ^= h >> 16;
+    return (float)(h & 0xFFFFFFu) / (float)0xFFFFFF;
+}
+
+inline float TerrainValueNoise(float x, float z)
+{
+    int x0 = (int)std::floor(x), z0 = (int)std::floor(z);
+    float fx = x - (float)x0, fz = z - (float)z0;
+    // quintic fade for continuous slopes
+    float ux = fx * fx * fx * (fx * (fx * 6.0f - 15.0f) + 10.0f);
+    float uz = fz * fz * fz * (fz * (fz * 6.0f - 15.0f) + 10.0f);
+    float a = TerrainHash(x0, z0), b = TerrainHash(x0 + 1, z0);
+    float c = TerrainHash(x0, z0 + 1), d = TerrainHash(x0 + 1, z0 + 1);
+    return glm::mix(glm::mix(a, b, ux), glm::mix(c, d, ux), uz);
+}
+
+inline float TerrainFbm(float x, float z, int octaves)
+{
+    float sum = 0.0f, amplitude = 0.5f, frequency = 1.0f;
+    for (int i = 0; i < octaves; ++i)
+    {
+        sum += amplitude * TerrainValueNoise(x * frequency, z * frequency);
+        frequency *= 2.0f;
+        amplitude *= 0.5f;
+    }
+    return sum;
+}
+
+class TerrainHeightmap
+{
+public:
+    float WorldSize = 4096.0f;  // spans [-WorldSize/2, WorldSize/2] on x/z
+    int Resolution = 1024;      // Resolution + 1 samples per side
+    float HeightScale = 160.0f;
+    float FlatRadius = 60.0f;   // area around the origin kept flat at y = 0
+    std::vector<float> Heights;
+
+    void Generate()
+    {
+        int n = GetSamples();
+        Heights.resize((size_t)n * n);
+        float cellSize = WorldSize / (float)Resolution;
+        for (int z = 0; z < n; ++z)
+        {
+            for (int x = 0; x < n; ++x)
+            {
+                float wx = -WorldSize * 0.5f + x * cellSize;
+                float wz = -WorldSize * 0.5f + z * cellSize;
+                float h = TerrainFbm(wx / 512.0f, wz / 512.0f, 7);
+                // ridged detail on top of the rolling base
+                float ridge = 1.0f - std::fabs(TerrainValueNoise(wx / 160.0f, wz / 160.0f) * 2.0f - 1.0f);
+                h = h * 0.8f + ridge * ridge * 0.2f;
+                float distance = std::sqrt(wx * wx + wz * wz);
+                float flatten = glm::smoothstep(FlatRadius, FlatRadius * 5.0f, distance);
+                Heights[(size_t)z * n + x] = (h - 0.35f) * HeightScale * flatten;
+            }
+        }
+    }
+
+    int GetSamples() const
+    {
+        return Resolution + 1;
+    }
+
+    float At(int x, int z) const
+    {
+        return Heights[(size_t)z * GetSamples() + x];
+    }
+
+    // bilinear height at a world position, matching what the GPU samples
+    float GetHeight(float x, float z) const
+    {
+        float cellSize = WorldSize / (float)Resolution;
+        float gx = glm::clamp((x + WorldSize * 0.5f) / cellSize, 0.0f, (float)Resolution);
+        float gz = glm::clamp((z + WorldSize * 0.5f) / cellSize, 0.0f, (float)Resolution);
+        int x0 = std::min((int)gx, Resolution - 1);
+        int z0 = std::min((int)gz, Resolution - 1);
+        float fx = gx - (float)x0, fz = gz - (float)z0;
+        float a = At(x0, z0), b = At(x0 + 1, z0);
+        float c = At(x0, z0 + 1), d = At(x0 + 1, z0 + 1);
+        return glm::mix(glm::mix(a, b, fx), glm::mix(c, d, fx), fz);
+    }
+
+    // ground for a CollisionWorld; the heightmap must outlive it
+    Heightfield AsHeightfield() const
+    {
+        Heightfield ground;
+        ground.Context = this;
+        ground.Height = [](const void* heightmap, float x, float z) { return ((const TerrainHeightmap*)heightmap)->GetHeight(x, z); };
+        return ground;
+    }
+};
+#endif
@@ -0,0 +1,245 @@
+#ifndef TEXTURE_FILE_H
+#define TEXTURE_FILE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Block-compressed 2D textures read from DDS and KTX2 files. The GPU samples these formats
+// directly, so loading is header parsing plus reading each mip's bytes; no GL dependency here.
+
+enum BlockFormat
+{
+    BLOCK_FORMAT_UNKNOWN = 0,
+    BLOCK_FORMAT_BC1,
+    BLOCK_FORMAT_BC3,
+    BLOCK_FORMAT_BC5,
+    BLOCK_FORMAT_BC7
+};
+
+// bytes per 4x4 block
+inline uint32_t GetBlockBytes(BlockFormat format)
+{
+    return format == BLOCK_FORMAT_BC1 ? 8u : 16u;
+}
+
+inline uint32_t GetMipBytes(BlockFormat format, uint32_t width, uint32_t height)
+{
+    return std::max(1u, (width + 3) / 4) * std::max(1u, (height + 3) / 4) * GetBlockBytes(format);
+}
+
+struct TextureMip
+{
+    uint64_t Offset = 0;
+    uint32_t Size = 0;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+};
+
+struct TextureFileInfo
+{
+    BlockFormat Format = BLOCK_FORMAT_UNKNOWN;
+    bool Srgb = false;
+    uint32_t Width = 0;
+    uint32_t Height = 0;
+    // level 0 is the full resolution
+    std::vector<TextureMip> Mips;
+};
+
+inline uint32_t readU32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint64_t readU64(const uint8_t* p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// fills in the mip chain from level sizes, for files that store the levels back to back
+inline void buildMipChain(TextureFileInfo& info, uint32_t levels, uint64_t offset)
+{
+    info.Mips.clear();
+    uint32_t width = info.Width, height = info.Height;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        TextureMip mip;
+        mip.Offset = offset;
+        mip.Width = width;
+        mip.Height = height;
+        mip.Size = GetMipBytes(info.Format, width, height);
+        info.Mips.push_back(mip);
+        offset += mip.Size;
+        if (width == 1 && height == 1)
+            break;
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+}
+
+const size_t DDS_HEADER_BYTES = 128;
+const size_t DDS_DX10_HEADER_BYTES = 20;
+
+// 2D textures only: cube maps, arrays and uncompressed formats are rejected
+inline bool ParseDDSHeader(const uint8_t* data, size_t size, TextureFileInfo& info)
+{
+    if (size < DDS_HEADER_BYTES || memcmp(data, "DDS ", 4) != 0 || readU32(data + 4) != 124)
+        return false;
+    const uint32_t DDPF_FOURCC = 0x4;
+    const uint32_t DDSCAPS2_CUBEMAP = 0x200;
+    const uint32_t DDSCAPS2_VOLUME = 0x200000;
+    if (readU32(data + 112) & (DDSCAPS2_CUBEMAP | DDSCAPS2_VOLUME))
+        return false;
+    if (!(readU32(data + 80) & DDPF_FOURCC))
+        return false;
+
+    info = TextureFileInfo();
+    info.Height = readU32(data + 12);
+    info.Width = readU32(data + 16);
+    uint32_t levels = std::max(1u, readU32(data + 28));
+
+    size_t dataOffset = DDS_HEADER_BYTES;
+    const uint8_t* fourCC = data + 84;
+    if (memcmp(fourCC, "DXT1", 4) == 0)
+        info.Format = BLOCK_FORMAT_BC1;
+    else if (memcmp(fourCC, "DXT5", 4) == 0)
+        info.Format = BLOCK_FORMAT_BC3;
+    else if (memcmp(fourCC, "ATI2", 4) == 0 || memcmp(fourCC, "BC5U", 4) == 0)
+        info.Format = BLOCK_FORMAT_BC5;
+    else if (memcmp(fourCC, "DX10", 4) == 0)
+    {
+        if (size < DDS_HEADER_BYTES + DDS_DX10_HEADER_BYTES)
+            return false;
+        const uint8_t* dx10 = data + DDS_HEADER_BYTES;
+        const uint32_t DIMENSION_TEXTURE2D = 3;
+        if (readU32(dx10 + 4) != DIMENSION_TEXTURE2D || readU32(dx10 + 12) > 1)
+            return false;
+        switch (readU32(dx10))
+        {
+        case 71: info.Format = BLOCK_FORMAT_BC1; break;
+        case 72: info.Format = BLOCK_FORMAT_BC1; info.Srgb = true; break;
+        case 77: info.Format = BLOCK_FORMAT_BC3; break;
+        case 78: info.Format = BLOCK_FORMAT_BC3; info.Srgb = true; break;
+        case 83: info.Format = BLOCK_FORMAT_BC5; break;
+        case 98: info.Format = BLOCK_FORMAT_BC7; break;
+        case 99: info.Format = BLOCK_FORMAT_BC7; info.Srgb = true; break;
+        default: return false;
+        }
+        dataOffset += DDS_DX10_HEADER_BYTES;
+    }
+    else
+        return false;
+
+    if (info.Width == 0 || info.Height == 0)
+        return false;
+    buildMipChain(info, levels, dataOffset);
+    return true;
+}
+
+const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+const size_t KTX2_HEADER_BYTES = 80;
+const size_t KTX2_LEVEL_BYTES = 24;
+
+// size must cover the level index as well (80 + 24 bytes per level); supercompressed files are
+// rejected, the levels have to be stored as plain BCn blocks
+inline bool ParseKTX2Header(const uint8_t* data, size_t size, TextureFileInfo& info)
+{
+    if (size < KTX2_HEADER_BYTES || memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+        return false;
+
+    info = TextureFileInfo();
+    switch (readU32(data + 12))
+    {
+    case 131: case 133: info.Format = BLOCK_FORMAT_BC1; break;
+    case 132: case 134: info.Format = BLOCK_FORMAT_BC1; info.Srgb = true; break;
+    case 137: info.Format = BLOCK_FORMAT_BC3; break;
+    case 138: info.Format = BLOCK_FORMAT_BC3; info.Srgb = true; break;
+    case 141: info.Format = BLOCK_FORMAT_BC5; break;
+    case 145: info.Format = BLOCK_FORMAT_BC7; break;
+    case 146: info.Format = BLOCK_FORMAT_BC7; info.Srgb = true; break;
+    default: return false;
+    }
+    info.Width = readU32(data + 20);
+    info.Height = readU32(data + 24);
+    uint32_t depth = readU32(data + 28);
+    uint32_t layers = readU32(data + 32);
+    uint32_t faces = readU32(data + 36);
+    uint32_t levels = std::max(1u, readU32(data + 40));
+    uint32_t supercompression = readU32(data + 44);
+    if (info.Width == 0 || info.Height == 0 || depth > 1 || layers > 1 || faces != 1 || supercompression != 0)
+        return false;
+    if (size < KTX2_HEADER_BYTES + levels * KTX2_LEVEL_BYTES)
+        return false;
+
+    uint32_t width = info.Width, height = info.Height;
+    for (uint32_t level = 0; level < levels; ++level)
+    {
+        const uint8_t* entry = data + KTX2_HEADER_BYTES + level * KTX2_LEVEL_BYTES;
+        TextureMip mip;
+        mip.Offset = readU64(entry);
+        mip.Width = width;
+        mip.Height = height;
+        mip.Size = GetMipBytes(info.Format, width, height);
+        if (readU64(entry + 8) < mip.Size)
+            return false;
+        info.Mips.push_back(mip);
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    return true;
+}
+
+// reads just enough of the file to parse either header
+inline bool ReadTextureFileInfo(const std::string& path, TextureFileInfo& info)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    std::vector<uint8_t> header(DDS_HEADER_BYTES + DDS_DX10_HEADER_BYTES);
+    size_t read = fread(header.data(), 1, header.size(), file);
+
+    bool ok = false;
+    if (read >= sizeof(KTX2_IDENTIFIER) && memcmp(header.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0)
+    {
+        // the level index follows the fixed header, its length depends on the level count
+        if (read >= KTX2_HEADER_BYTES)
+        {
+            uint32_t levels = std::min(32u, std::max(1u, readU32(header.data() + 40)));
+            header.resize(KTX2_HEADER_BYTES + levels * KTX2_LEVEL_BYTES);
+            fseek(file, 0, SEEK_SET);
+            read = fread(header.data(), 1, header.size(), file);
+            ok = ParseKTX2Header(header.data(), read, info);
+        }
+    }
+    else
+        ok = ParseDDSHeader(header.data(), read, info);
+    fclose(file);
+    return ok;
+}
+
+// appends levels [firstLevel, lastLevel] to out, finest first
+inline bool ReadTextureMips(const std::string& path, const TextureFileInfo& info, uint32_t firstLevel, uint32_t lastLevel,
+                            std::vector<uint8_t>& out)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    bool ok = true;
+    for (uint32_t level = firstLevel; level <= lastLevel && ok; ++level)
+    {
+        const TextureMip& mip = info.Mips[level];
+        size_t start = out.size();
+        out.resize(start + mip.Size);
+        ok = fseek(file, (long)mip.Offset, SEEK_SET) == 0 && fread(out.data() + start, 1, mip.Size, file) == mip.Size;
+    }
+    fclose(file);
+    return ok;
+}
+#endif
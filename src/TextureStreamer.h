@@ -0,0 +1,463 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "GLExtensions.h"
+#include "JobSystem.h"
+#include "TextureFile.h"
+
+typedef uint32_t StreamedTexture;
+const StreamedTexture INVALID_STREAMED_TEXTURE = 0xFFFFFFFFu;
+
+struct TextureStreamingStats
+{
+    unsigned int Textures = 0;
+    unsigned int Failed = 0;
+    // file reads queued or running on the workers
+    unsigned int Loading = 0;
+    size_t ResidentBytes = 0;
+    // mip levels uploaded this frame and their size
+    unsigned int Uploads = 0;
+    size_t UploadedBytes = 0;
+    // mip levels dropped to stay under the budget, since Init()
+    unsigned int Evictions = 0;
+    double UpdateMs = 0.0;
+};
+
+// GL internal format of a block format, 0 when the driver cannot take it
+inline GLenum GetBlockFormatGL(BlockFormat format, bool srgb)
+{
+    const GLExtensions& extensions = GetGLExtensions();
+    switch (format)
+    {
+    case BLOCK_FORMAT_BC1:
+        return extensions.TextureS3TC ? (srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) : 0;
+    case BLOCK_FORMAT_BC3:
+        return extensions.TextureS3TC ? (srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) : 0;
+    case BLOCK_FORMAT_BC5:
+        return GL_COMPRESSED_RG_RGTC2;
+    case BLOCK_FORMAT_BC7:
+        return extensions.TextureBPTC ? (srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM) : 0;
+    default:
+        return 0;
+    }
+}
+
+// Streams block-compressed textures in the background. Load() reads the header and the small tail
+// mips on a worker; after that each texture sharpens one level at a time, as far as its size on
+// screen (Request()) asks for. Finished reads are copied into a pixel buffer object and uploaded
+// under a per-frame byte budget, coarsest level first, and GL_TEXTURE_BASE_LEVEL always points at
+// the finest level present. When resident memory would exceed its budget the least recently drawn
+// textures give up their finest levels.
+class TextureStreamer
+{
+public:
+    size_t ResidentBudgetBytes = (size_t)256 << 20;
+    size_t UploadBudgetBytes = (size_t)4 << 20;
+    // levels this size and smaller are read with the header and never evicted
+    uint32_t TailSize = 64;
+    unsigned int MaxLoadsInFlight = 4;
+
+    TextureStreamingStats Stats;
+
+    void Init(JobSystem* jobSystem)
+    {
+        jobs = jobSystem;
+        glGenBuffers(PBO_COUNT, pbos);
+    }
+
+    void Delete()
+    {
+        // reads may still be running on the workers
+        for (std::unique_ptr<PendingLoad>& load : loads)
+        {
+            if (jobs)
+                jobs->Wait(load->Done);
+        }
+        loads.clear();
+        ready.clear();
+        for (TextureState& texture : textures)
+        {
+            if (texture.Texture)
+                glDeleteTextures(1, &texture.Texture);
+        }
+        textures.clear();
+        glDeleteBuffers(PBO_COUNT, pbos);
+        residentBytes = 0;
+        incomingBytes = 0;
+    }
+
+    // returns right away; the texture has no GL object until the first levels arrive
+    StreamedTexture Load(const std::string& path)
+    {
+        StreamedTexture handle = (StreamedTexture)textures.size();
+        textures.push_back(TextureState());
+        textures[handle].Path = path;
+        textures[handle].Loading = true;
+        startLoad(handle, true, 0);
+        return handle;
+    }
+
+    // call every frame the texture is drawn, with its size on screen in pixels (longest edge)
+    void Request(StreamedTexture handle, float screenPixels)
+    {
+        TextureState& texture = textures[handle];
+        if (texture.LastUsedFrame != frame)
+            texture.RequestedPixels = 0.0f;
+        texture.LastUsedFrame = frame;
+        texture.RequestedPixels = std::max(texture.RequestedPixels, screenPixels);
+    }
+
+    // 0 until at least one level is resident
+    GLuint GetTexture(StreamedTexture handle) const
+    {
+        const TextureState& texture = textures[handle];
+        return texture.ResidentLevel < texture.Info.Mips.size() ? texture.Texture : 0;
+    }
+
+    // finest level present; the level count when none is
+    uint32_t GetResidentLevel(StreamedTexture handle) const
+    {
+        return textures[handle].ResidentLevel;
+    }
+
+    // once per frame on the GL thread, after the frame's Request() calls
+    void Update()
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        Stats.Uploads = 0;
+        Stats.UploadedBytes = 0;
+
+        collectLoads();
+        upload();
+        // also trims right away when the budget was lowered
+        makeRoom(0, INVALID_STREAMED_TEXTURE);
+        scheduleLoads();
+
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.Textures = (unsigned int)textures.size();
+        Stats.Loading = (unsigned int)loads.size();
+        Stats.ResidentBytes = residentBytes;
+        Stats.UpdateMs = std::chrono::duration<double, std::milli>(end - start).count();
+        ++frame;
+    }
+
+private:
+    static const int PBO_COUNT = 3;
+
+    struct TextureState
+    {
+        std::string Path;
+        TextureFileInfo Info;
+        GLuint Texture = 0;
+        GLenum InternalFormat = 0;
+        // levels [ResidentLevel, level count) are in the GL texture
+        uint32_t ResidentLevel = 0;
+        // levels from here down are the tail, never evicted
+        uint32_t TailLevel = 0;
+        bool Loading = false;
+        bool Failed = false;
+        uint64_t LastUsedFrame = 0;
+        float RequestedPixels = 0.0f;
+    };
+
+    // one file read: the header plus the tail, or a single finer level
+    struct PendingLoad
+    {
+        StreamedTexture Texture = 0;
+        bool Header = false;
+        std::string Path;
+        uint32_t TailSize = 0;
+        TextureFileInfo Info;
+        uint32_t FirstLevel = 0;
+        uint32_t LastLevel = 0;
+        // levels FirstLevel..LastLevel, finest first
+        std::vector<uint8_t> Data;
+        bool Ok = false;
+        JobCounter Done;
+        // uploads walk from LastLevel down to FirstLevel
+        uint32_t NextLevel = 0;
+    };
+
+    struct Upload
+    {
+        PendingLoad* Load;
+        uint32_t Level;
+        size_t Source;
+        size_t Offset;
+    };
+
+    JobSystem* jobs = nullptr;
+    GLuint pbos[PBO_COUNT] = {};
+    uint64_t frame = 1;
+
+    std::vector<TextureState> textures;
+    std::vector<std::unique_ptr<PendingLoad>> loads;
+    // reads that finished and still have levels to upload, oldest first
+    std::vector<std::unique_ptr<PendingLoad>> ready;
+    size_t residentBytes = 0;
+    // levels being read or waiting for upload, counted against the budget already
+    size_t incomingBytes = 0;
+
+    std::vector<Upload> batch;
+    std::vector<StreamedTexture> candidates;
+
+    // worker side: no GL calls here
+    static void loadJob(void* data, uint32_t, uint32_t)
+    {
+        PendingLoad& load = *(PendingLoad*)data;
+        if (load.Header)
+        {
+            if (!ReadTextureFileInfo(load.Path, load.Info))
+                return;
+            uint32_t levels = (uint32_t)load.Info.Mips.size();
+            load.FirstLevel = levels - 1;
+            while (load.FirstLevel > 0 && std::max(load.Info.Mips[load.FirstLevel - 1].Width, load.Info.Mips[load.FirstLevel - 1].Height) <= load.TailSize)
+                --load.FirstLevel;
+            load.LastLevel = levels - 1;
+        }
+        load.Ok = ReadTextureMips(load.Path, load.Info, load.FirstLevel, load.LastLevel, load.Data);
+    }
+
+    void startLoad(StreamedTexture handle, bool header, uint32_t level)
+    {
+        std::unique_ptr<PendingLoad> load(new PendingLoad());
+        const TextureState& texture = textures[handle];
+        load->Texture = handle;
+        load->Header = header;
+        load->Path = texture.Path;
+        load->TailSize = TailSize;
+        if (!header)
+        {
+            load->Info = texture.Info;
+            load->FirstLevel = level;
+            load->LastLevel = level;
+            incomingBytes += texture.Info.Mips[level].Size;
+        }
+
+        // without worker threads nothing would pick the job up, so the read happens here
+        if (jobs && jobs->GetThreadCount() > 1)
+            jobs->Run(&loadJob, load.get(), 0, 1, &load->Done);
+        else
+            loadJob(load.get(), 0, 1);
+        loads.push_back(std::move(load));
+    }
+
+    void collectLoads()
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < loads.size(); ++i)
+        {
+            if (!loads[i]->Done.IsDone())
+            {
+                loads[kept++] = std::move(loads[i]);
+                continue;
+            }
+            std::unique_ptr<PendingLoad> load = std::move(loads[i]);
+            TextureState& texture = textures[load->Texture];
+            if (load->Header && load->Ok)
+                load->Ok = createTexture(load->Texture, *load);
+            if (!load->Ok)
+            {
+                // a texture that failed once is not read again; whatever is resident stays usable
+                if (!load->Header)
+                    incomingBytes -= texture.Info.Mips[load->FirstLevel].Size;
+                texture.Failed = true;
+                texture.Loading = false;
+                Stats.Failed++;
+                continue;
+            }
+            load->NextLevel = load->LastLevel;
+            ready.push_back(std::move(load));
+        }
+        loads.resize(kept);
+    }
+
+    bool createTexture(StreamedTexture handle, const PendingLoad& load)
+    {
+        TextureState& texture = textures[handle];
+        texture.Info = load.Info;
+        texture.InternalFormat = GetBlockFormatGL(load.Info.Format, load.Info.Srgb);
+        if (texture.InternalFormat == 0)
+            return false;
+        uint32_t levels = (uint32_t)texture.Info.Mips.size();
+        texture.ResidentLevel = levels;
+        texture.TailLevel = load.FirstLevel;
+        size_t tailBytes = 0;
+        for (uint32_t level = load.FirstLevel; level < levels; ++level)
+            tailBytes += texture.Info.Mips[level].Size;
+        // the tail is taken even when nothing is left to evict: without it the texture has no image
+        makeRoom(tailBytes, handle);
+        incomingBytes += tailBytes;
+
+        glGenTextures(1, &texture.Texture);
+        glBindTexture(GL_TEXTURE_2D, texture.Texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)levels - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)levels - 1);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return true;
+    }
+
+    // byte offset of a level inside a load's data
+    static size_t levelSource(const PendingLoad& load, uint32_t level)
+    {
+        size_t offset = 0;
+        for (uint32_t l = load.FirstLevel; l < level; ++l)
+            offset += load.Info.Mips[l].Size;
+        return offset;
+    }
+
+    void upload()
+    {
+        // pick the levels that fit this frame's budget; one oversized level still goes alone
+        batch.clear();
+        std::vector<std::unique_ptr<PendingLoad>> finished;
+        size_t total = 0;
+        size_t head = 0;
+        while (head < ready.size())
+        {
+            PendingLoad& load = *ready[head];
+            uint32_t level = load.NextLevel;
+            size_t size = load.Info.Mips[level].Size;
+            if (total > 0 && total + size > UploadBudgetBytes)
+                break;
+            batch.push_back({ &load, level, levelSource(load, level), total });
+            total += size;
+            if (level == load.FirstLevel)
+                finished.push_back(std::move(ready[head++]));
+            else
+                load.NextLevel--;
+        }
+        ready.erase(ready.begin(), ready.begin() + head);
+        if (batch.empty())
+            return;
+
+        // orphan this frame's buffer so the copy never waits on uploads still in flight
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbos[frame % PBO_COUNT]);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)total, nullptr, GL_STREAM_DRAW);
+        uint8_t* mapped = (uint8_t*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)total,
+                                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped)
+        {
+            for (const Upload& item : batch)
+                memcpy(mapped + item.Offset, item.Load->Data.data() + item.Source, item.Load->Info.Mips[item.Level].Size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+        else
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        for (const Upload& item : batch)
+        {
+            TextureState& texture = textures[item.Load->Texture];
+            const TextureMip& mip = texture.Info.Mips[item.Level];
+            // offset into the PBO, or a plain pointer when mapping failed
+            const void* pixels = mapped ? (const void*)(uintptr_t)item.Offset : (const void*)(item.Load->Data.data() + item.Source);
+            glBindTexture(GL_TEXTURE_2D, texture.Texture);
+            glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)item.Level, texture.InternalFormat, (GLsizei)mip.Width,
+                                   (GLsizei)mip.Height, 0, (GLsizei)mip.Size, pixels);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)item.Level);
+            texture.ResidentLevel = item.Level;
+            if (item.Level == item.Load->FirstLevel)
+                texture.Loading = false;
+            residentBytes += mip.Size;
+            incomingBytes -= mip.Size;
+            Stats.Uploads++;
+            Stats.UploadedBytes += mip.Size;
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    // finest level worth having at the requested screen size
+    static uint32_t wantedLevel(const TextureState& texture)
+    {
+        uint32_t last = (uint32_t)texture.Info.Mips.size() - 1;
+        if (texture.RequestedPixels <= 1.0f)
+            return last;
+        float edge = (float)std::max(texture.Info.Width, texture.Info.Height);
+        float level = std::floor(std::log2(std::max(1.0f, edge / texture.RequestedPixels)));
+        return std::min(last, (uint32_t)level);
+    }
+
+    void dropLevel(TextureState& texture)
+    {
+        uint32_t level = texture.ResidentLevel;
+        glBindTexture(GL_TEXTURE_2D, texture.Texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)level + 1);
+        // a 0x0 image releases the level's storage
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)level, texture.InternalFormat, 0, 0, 0, 0, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        texture.ResidentLevel = level + 1;
+        residentBytes -= texture.Info.Mips[level].Size;
+        Stats.Evictions++;
+    }
+
+    // evicts until size more bytes fit; false when nothing evictable is left. Victims are textures
+    // not drawn this frame, least recently drawn first, then textures holding finer levels than
+    // they asked for. A linear scan per victim is fine for the texture counts used here.
+    bool makeRoom(size_t size, StreamedTexture requester)
+    {
+        while (residentBytes + incomingBytes + size > ResidentBudgetBytes)
+        {
+            TextureState* victim = nullptr;
+            for (StreamedTexture i = 0; i < (StreamedTexture)textures.size(); ++i)
+            {
+                TextureState& texture = textures[i];
+                if (i == requester || texture.Loading || texture.Failed || texture.ResidentLevel >= texture.TailLevel)
+                    continue;
+                bool unused = texture.LastUsedFrame != frame;
+                if (!unused && texture.ResidentLevel >= wantedLevel(texture))
+                    continue;
+                if (!victim || texture.LastUsedFrame < victim->LastUsedFrame)
+                    victim = &texture;
+            }
+            if (!victim)
+                return false;
+            dropLevel(*victim);
+        }
+        return true;
+    }
+
+    void scheduleLoads()
+    {
+        // textures drawn this frame that want finer levels, the furthest behind first
+        candidates.clear();
+        for (StreamedTexture i = 0; i < (StreamedTexture)textures.size(); ++i)
+        {
+            const TextureState& texture = textures[i];
+            if (texture.LastUsedFrame == frame && !texture.Loading && !texture.Failed && texture.Texture &&
+                wantedLevel(texture) < texture.ResidentLevel)
+                candidates.push_back(i);
+        }
+        std::sort(candidates.begin(), candidates.end(), [this](StreamedTexture a, StreamedTexture b) {
+            return textures[a].ResidentLevel - wantedLevel(textures[a]) > textures[b].ResidentLevel - wantedLevel(textures[b]);
+        });
+
+        for (StreamedTexture handle : candidates)
+        {
+            if (loads.size() >= MaxLoadsInFlight)
+                break;
+            TextureState& texture = textures[handle];
+            uint32_t level = texture.ResidentLevel - 1;
+            if (!makeRoom(texture.Info.Mips[level].Size, handle))
+                break;
+            texture.Loading = true;
+            startLoad(handle, false, level);
+        }
+    }
+};
+#endif
@@ -0,0 +1,272 @@
+#ifndef TRANSFORM_HIERARCHY_H
+#define TRANSFORM_HIERARCHY_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "Components.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define GE_TRANSFORM_SSE 1
+#endif
+
+struct TransformStats
+{
+    unsigned int Nodes = 0;
+    unsigned int Updated = 0;
+    double UpdateMs = 0.0;
+};
+
+// out = a * b for column-major 4x4 matrices; out must not alias a or b
+inline void MultiplyMatrices(const glm::mat4& a, const glm::mat4& b, glm::mat4& out)
+{
+#ifdef GE_TRANSFORM_SSE
+    const float* pa = &a[0][0];
+    const float* pb = &b[0][0];
+    float* po = &out[0][0];
+    __m128 a0 = _mm_loadu_ps(pa);
+    __m128 a1 = _mm_loadu_ps(pa + 4);
+    __m128 a2 = _mm_loadu_ps(pa + 8);
+    __m128 a3 = _mm_loadu_ps(pa + 12);
+    for (int column = 0; column < 4; ++column)
+    {
+        const float* c = pb + column * 4;
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(c[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(c[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(c[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(c[3])));
+        _mm_storeu_ps(po + column * 4, r);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+// Parent/child transforms in flat arrays sorted breadth-first, so every parent comes before its
+// children and one linear pass updates the whole tree. Nodes are addressed by stable handles; only
+// nodes whose local transform changed, and their descendants, are recomputed. Handles carry a
+// generation, so using one after its node was destroyed asserts.
+class TransformHierarchy
+{
+public:
+    TransformStats Stats;
+
+    TransformNode Create(const Transform& localTransform, TransformNode parentNode = INVALID_TRANSFORM_NODE)
+    {
+        uint32_t parent = parentNode == INVALID_TRANSFORM_NODE ? NONE : indexOf[slotOf(parentNode)];
+        TransformNode node;
+        if (!freeSlots.empty())
+        {
+            node.Index = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            node.Index = (uint32_t)indexOf.size();
+            indexOf.push_back(0);
+            generations.push_back(0);
+        }
+        node.Generation = generations[node.Index];
+
+        // appended for now; the next Update() puts it in breadth-first order
+        indexOf[node.Index] = (uint32_t)slots.size();
+        slots.push_back(node.Index);
+        parents.push_back(parent);
+        locals.push_back(localTransform);
+        localMatrices.push_back(glm::mat4(1.0f));
+        worlds.push_back(glm::mat4(1.0f));
+        dirty.push_back(1);
+        removed.push_back(0);
+        structureChanged = true;
+        return node;
+    }
+
+    // removes the node together with everything below it; their handles die with the next Update()
+    void Destroy(TransformNode node)
+    {
+        removed[indexOf[slotOf(node)]] = 1;
+        structureChanged = true;
+    }
+
+    // false once the node (or one above it) was destroyed and the hierarchy updated
+    bool IsAlive(TransformNode node) const
+    {
+        return node.Index < generations.size() && generations[node.Index] == node.Generation;
+    }
+
+    // parent may be INVALID_TRANSFORM_NODE to make the node a root; must not be one of its descendants
+    void SetParent(TransformNode node, TransformNode parentNode)
+    {
+        uint32_t index = indexOf[slotOf(node)];
+        parents[index] = parentNode == INVALID_TRANSFORM_NODE ? NONE : indexOf[slotOf(parentNode)];
+        dirty[index] = 1;
+        structureChanged = true;
+    }
+
+    void SetLocal(TransformNode node, const Transform& localTransform)
+    {
+        uint32_t index = indexOf[slotOf(node)];
+        locals[index] = localTransform;
+        dirty[index] = 1;
+    }
+
+    const Transform& GetLocal(TransformNode node) const
+    {
+        return locals[indexOf[slotOf(node)]];
+    }
+
+    // world matrix as of the last Update()
+    const glm::mat4& GetWorld(TransformNode node) const
+    {
+        return worlds[indexOf[slotOf(node)]];
+    }
+
+    size_t GetNodeCount() const
+    {
+        return slots.size();
+    }
+
+    // recomputes the world matrix of every dirty node and its descendants
+    void Update()
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+        if (structureChanged)
+            rebuild();
+
+        // parents come first, so one pass carries dirtiness all the way down
+        const size_t count = slots.size();
+        updateList.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (parents[i] != NONE && dirty[parents[i]])
+                dirty[i] = 1;
+            if (dirty[i])
+                updateList.push_back((uint32_t)i);
+        }
+
+        // batched passes over the dirty list: local matrices first, then parent * local in order
+        for (uint32_t i : updateList)
+            localMatrices[i] = locals[i].ToMatrix();
+        for (uint32_t i : updateList)
+        {
+            if (parents[i] == NONE)
+                worlds[i] = localMatrices[i];
+            else
+                MultiplyMatrices(worlds[parents[i]], localMatrices[i], worlds[i]);
+        }
+        for (uint32_t i : updateList)
+            dirty[i] = 0;
+
+        auto end = std::chrono::high_resolution_clock::now();
+        Stats.Nodes = (unsigned int)count;
+        Stats.Updated = (unsigned int)updateList.size();
+        Stats.UpdateMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFFu;
+
+    // dense arrays, indexed by position in breadth-first order; slots[i] is node i's handle slot
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> parents;
+    std::vector<Transform> locals;
+    std::vector<glm::mat4> localMatrices;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint8_t> dirty;
+    std::vector<uint8_t> removed;
+
+    // handle slot -> dense index, and the generation a live handle to it must have
+    std::vector<uint32_t> indexOf;
+    std::vector<uint32_t> generations;
+    std::vector<uint32_t> freeSlots;
+    bool structureChanged = false;
+
+    std::vector<uint32_t> updateList;
+
+    uint32_t slotOf(TransformNode node) const
+    {
+        assert(IsAlive(node) && "stale or invalid TransformNode");
+        return node.Index;
+    }
+
+    // re-sorts the arrays breadth-first and drops destroyed subtrees; everything becomes dirty
+    void rebuild()
+    {
+        const uint32_t count = (uint32_t)slots.size();
+
+        // children of each node as ranges of one array (counting sort by parent)
+        std::vector<uint32_t> childStart(count + 1, 0), children(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (parents[i] != NONE)
+                childStart[parents[i] + 1]++;
+        }
+        for (uint32_t i = 0; i < count; ++i)
+            childStart[i + 1] += childStart[i];
+        std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (parents[i] != NONE)
+                children[fill[parents[i]]++] = i;
+        }
+
+        // breadth-first from every live root; removed nodes and their subtrees are never reached
+        std::vector<uint32_t> order;
+        order.reserve(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (parents[i] == NONE && !removed[i])
+                order.push_back(i);
+        }
+        for (size_t head = 0; head < order.size(); ++head)
+        {
+            uint32_t node = order[head];
+            for (uint32_t c = childStart[node]; c < childStart[node + 1]; ++c)
+            {
+                if (!removed[children[c]])
+                    order.push_back(children[c]);
+            }
+        }
+
+        std::vector<uint32_t> newIndex(count, NONE);
+        for (uint32_t i = 0; i < (uint32_t)order.size(); ++i)
+            newIndex[order[i]] = i;
+        // dropped nodes free their slot; the new generation invalidates every handle to them
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (newIndex[i] == NONE)
+            {
+                generations[slots[i]]++;
+                freeSlots.push_back(slots[i]);
+            }
+        }
+
+        std::vector<uint32_t> sortedSlots(order.size());
+        std::vector<uint32_t> sortedParents(order.size());
+        std::vector<Transform> sortedLocals(order.size());
+        for (uint32_t i = 0; i < (uint32_t)order.size(); ++i)
+        {
+            uint32_t old = order[i];
+            sortedSlots[i] = slots[old];
+            sortedParents[i] = parents[old] == NONE ? NONE : newIndex[parents[old]];
+            sortedLocals[i] = locals[old];
+            indexOf[slots[old]] = i;
+        }
+
+        slots.swap(sortedSlots);
+        parents.swap(sortedParents);
+        locals.swap(sortedLocals);
+        localMatrices.assign(order.size(), glm::mat4(1.0f));
+        worlds.assign(order.size(), glm::mat4(1.0f));
+        dirty.assign(order.size(), 1);
+        removed.assign(order.size(), 0);
+        structureChanged = false;
+    }
+};
+#endif
@@ -8,7 +8,25 @@
 #include <sstream>
 #include <vector>
 #include <filesystem>
+#include <cstdio>
+#include "AsyncShaderCompiler.h"
 #include "Camera.h"
+#include "GLExtensions.h"
+#include "Shader.h"
+#include "Culling.h"
+#include "FixedTimestep.h"
+#include "InstancedRenderer.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "Prediction.h"
+#include "Profiler.h"
+#include "ProgramCache.h"
+#include "Replication.h"
+#include "Scene.h"
+#include "ShaderWatcher.h"
+#include "Simulation.h"
+#include "TextureStreamer.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
@@ -21,56 +39,26 @@ bool firstMouse = true;
 float deltaTime = 0.0f; 
 float lastFrame = 0.0f;
 bool altHeld = false;
+// creatures and the walking player; the same simulation the dedicated server runs
+Simulation simulation;
+uint32_t localPlayer = 0;
+// walking moves the player's capsule through the simulation; otherwise the camera flies
+bool walkMode = true;
+// with --connect host:port the server owns the world; this client predicts its own player
+bool connected = false;
+ReplicationClient client;
+PlayerPrediction prediction;
+
+// the capsule the camera walks with: the predicted one when connected, else the simulation's
+CharacterController& localController() {
+    return connected ? prediction.Player : simulation.Players[localPlayer];
+}
 
 // Remove these redundant variables - we're using the Camera class instead
 // glm::vec3 cameraPos   = glm::vec3(0.0f, 0.0f, 3.0f);
 // glm::vec3 cameraFront = glm::vec3(0.0f, 0.0f, -1.0f);
 // glm::vec3 cameraUp    = glm::vec3(0.0f, 1.0f, 0.0f);
 
-glm::mat4 model;
-glm::mat4 view;
-glm::mat4 projection;
-
-unsigned int compileShader(unsigned int type, const std::string& source) {
-    unsigned int shader = glCreateShader(type);
-    const char* src = source.c_str();
-    glShaderSource(shader, 1, &src, nullptr);
-    glCompileShader(shader);
-
-    int success;
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char info[512];
-        glGetShaderInfoLog(shader, 512, nullptr, info);
-        std::cerr << "Shader compile error: " << info << std::endl;
-    }
-
-    return shader;
-}
-
-unsigned int createShaderProgram(const std::string& vertexSrc, const std::string& fragmentSrc) {
-    unsigned int vertex = compileShader(GL_VERTEX_SHADER, vertexSrc);
-    unsigned int fragment = compileShader(GL_FRAGMENT_SHADER, fragmentSrc);
-
-    unsigned int program = glCreateProgram();
-    glAttachShader(program, vertex);
-    glAttachShader(program, fragment);
-    glLinkProgram(program);
-
-    int success;
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        char info[512];
-        glGetProgramInfoLog(program, 512, nullptr, info);
-        std::cerr << "Shader link error: " << info << std::endl;
-    }
-
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
-
-    return program;
-}
-
 std::string loadFile(const std::string& path) {
     std::ifstream file(path);
     if (!file.is_open()) {
@@ -132,27 +120,65 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     }
 }
 
-void processInput(GLFWwindow *window) {
+// puts the walking capsule where the camera is, e.g. after flying or a reset; when connected the
+// server's state wins again at the next correction
+void placePlayerAtCamera() {
+    CharacterController& player = localController();
+    player.Position = camera.Position - glm::vec3(0.0f, player.EyeHeight, 0.0f);
+    player.Velocity = glm::vec3(0.0f);
+    player.OnGround = false;
+}
+
+// Runs once per simulation tick: when walking the keys become the player's input for the tick,
+// when flying they move the camera directly by the fixed tick length
+PlayerInput processInput(GLFWwindow *window, float tickSeconds) {
+    PlayerInput input;
     // Skip keyboard input if ImGui wants to capture it
     ImGuiIO& io = ImGui::GetIO();
-    if (io.WantCaptureKeyboard) return;
-
-    // Use deltaTime for smooth movement
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
-        camera.ProcessKeyboard(FORWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
-        camera.ProcessKeyboard(BACKWARD, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
-        camera.ProcessKeyboard(LEFT, deltaTime);
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
-        camera.ProcessKeyboard(RIGHT, deltaTime);
+    if (io.WantCaptureKeyboard) return input;
+
+    if (walkMode) {
+        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+            input.Move += camera.GetWalkDirection(FORWARD);
+        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+            input.Move += camera.GetWalkDirection(BACKWARD);
+        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+            input.Move += camera.GetWalkDirection(LEFT);
+        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+            input.Move += camera.GetWalkDirection(RIGHT);
+        if (glm::dot(input.Move, input.Move) > 0.0f)
+            input.Move = glm::normalize(input.Move) * std::min(camera.MovementSpeed, MAX_WALK_SPEED);
+        input.Jump = glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS;
+    } else {
+        if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+            camera.ProcessKeyboard(FORWARD, tickSeconds);
+        if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+            camera.ProcessKeyboard(BACKWARD, tickSeconds);
+        if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+            camera.ProcessKeyboard(LEFT, tickSeconds);
+        if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+            camera.ProcessKeyboard(RIGHT, tickSeconds);
+    }
     
     // Add escape key to close window
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
+    return input;
 }
 
-int main() {
+int main(int argc, char** argv) {
+    NetAddress serverAddress;
+    std::string serverName;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::string(argv[i]) != "--connect")
+            continue;
+        serverName = argv[i + 1];
+        if (!NetAddress::Parse(argv[i + 1], serverAddress)) {
+            std::cerr << "Expected --connect a.b.c.d:port, got " << serverName << std::endl;
+            return 1;
+        }
+    }
+
     glfwInit();
     
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -182,6 +208,7 @@ int main() {
         std::cerr << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
 
     // Setup ImGui
     IMGUI_CHECKVERSION();
@@ -201,93 +228,108 @@ int main() {
 
     glEnable(GL_DEPTH_TEST);
 
-    // Triangle vertices (position + color)
-    float vertices[] = {
-        -0.5f, -0.5f, -0.5f,  1.0f, 0.0f, 0.0f,
-         0.5f, -0.5f, -0.5f,  0.0f, 1.0f, 0.0f,
-         0.0f,  0.5f, -0.5f,  0.0f, 0.0f, 1.0f,
-    };
-
-    // Ground vertices (larger ground plane)
-    float groundVertices[] = {
-        // positions           // colors (grass green)
-        -50.0f, 0.0f,  50.0f,   0.2f, 0.6f, 0.2f,
-         50.0f, 0.0f,  50.0f,   0.2f, 0.6f, 0.2f,
-         50.0f, 0.0f, -50.0f,   0.2f, 0.6f, 0.2f,
-
-         50.0f, 0.0f, -50.0f,   0.2f, 0.6f, 0.2f,
-        -50.0f, 0.0f, -50.0f,   0.2f, 0.6f, 0.2f,
-        -50.0f, 0.0f,  50.0f,   0.2f, 0.6f, 0.2f,
-    };
-
-    // Triangle VAO/VBO
-    unsigned int VBO, VAO;
-    glGenBuffers(1, &VBO);
-    glGenVertexArrays(1, &VAO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // Load or create fallback shaders
+    // The scene shaders share the lighting and shadow blocks with Scene.h, so there is no stand-in for them
     std::string vertexShaderSource = loadFile("../../src/shaders/vertex.glsl");
     std::string fragmentShaderSource = loadFile("../../src/shaders/fragment.glsl");
-    
-    // Fallback shaders if files don't exist
-    if (vertexShaderSource.empty()) {
-        vertexShaderSource = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor;
-
-out vec3 vertexColor;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    vertexColor = aColor;
-}
-)";
+    // Instanced variant of the vertex shader, the model matrix comes from the instance buffer
+    std::string instancedVertexShaderSource = loadFile("../../src/shaders/instanced_vertex.glsl");
+    if (vertexShaderSource.empty() || fragmentShaderSource.empty() || instancedVertexShaderSource.empty()) {
+        std::cerr << "The scene can't be drawn without src/shaders/vertex.glsl, fragment.glsl and instanced_vertex.glsl" << std::endl;
+        glfwTerminate();
+        return -1;
     }
-    
-    if (fragmentShaderSource.empty()) {
-        fragmentShaderSource = R"(
-#version 330 core
-out vec4 FragColor;
-
-in vec3 vertexColor;
 
-void main()
-{
-    FragColor = vec4(vertexColor, 1.0);
-}
-)";
+    SceneShaderSources sources;
+    sources.Vertex = vertexShaderSource;
+    sources.Fragment = fragmentShaderSource;
+    sources.InstancedVertex = instancedVertexShaderSource;
+    sources.TerrainVertex = loadFile("../../src/shaders/terrain_vertex.glsl");
+    // the terrain displaces its grid from the heightmap in the vertex shader; there is no stand-in
+    if (sources.TerrainVertex.empty()) {
+        std::cerr << "The terrain can't be drawn without src/shaders/terrain_vertex.glsl" << std::endl;
+        glfwTerminate();
+        return -1;
+    }
+    sources.ShadowFragment = loadFile("../../src/shaders/shadow_fragment.glsl");
+    if (sources.ShadowFragment.empty())
+        sources.ShadowFragment = "#version 330 core\nvoid main()\n{\n}\n";
+
+    // Worker threads for anything that can fan out (one per hardware thread, this one included)
+    JobSystem jobSystem;
+    jobSystem.Init();
+
+    // Linked programs are kept on disk so later launches skip GLSL compilation
+    ProgramCache programCache;
+    if (!programCache.Init("shader_cache"))
+        std::cout << "Program binaries not supported by the driver, shaders are compiled on every launch" << std::endl;
+
+    Scene scene;
+    scene.Init(sources, programCache);
+    std::cout << "Shader programs ready in " << programCache.Stats.LoadMs << " ms ("
+              << (programCache.Stats.Misses == 0 ? "warm" : "cold") << " start: " << programCache.Stats.Hits << " cached, "
+              << programCache.Stats.Misses << " compiled, " << programCache.Stats.Rejected << " rejected)" << std::endl;
+    camera.FarPlane = scene.Ground.GetViewDistance();
+
+    // Meshes cooked by ge_cook are mapped and handed to the GPU as they are
+    std::error_code meshDirectoryError;
+    for (const auto& entry : std::filesystem::directory_iterator("../../assets/meshes", meshDirectoryError)) {
+        if (entry.path().extension() != ".gemesh")
+            continue;
+        Mesh mesh;
+        MeshLoadStats loadStats;
+        if (LoadMeshFile(entry.path().string(), mesh, &loadStats)) {
+            scene.AddMesh(mesh);
+            std::cout << "Loaded " << entry.path().filename().string() << ": " << mesh.IndexCount / 3 << " triangles, "
+                      << loadStats.FileBytes / 1024 << " KB, map " << loadStats.MapMs << " ms, upload " << loadStats.UploadMs << " ms" << std::endl;
+        } else {
+            std::cerr << "Skipping " << entry.path().string() << ": not a version " << MESH_FILE_VERSION << " mesh file" << std::endl;
+        }
+    }
+    scene.Stress.Jobs = &jobSystem;
+
+    // Wanderers roam the stress area; the scene draws them straight from the simulation's world.
+    // Connected, they are the server's, mirrored from its snapshots.
+    simulation.Jobs = &jobSystem;
+    simulation.SetGround(scene.Ground.GetHeightmap().AsHeightfield());
+    scene.Simulated = &simulation.Entities;
+    if (serverAddress.Port != 0) {
+        connected = client.Connect(serverAddress);
+        std::cout << (connected ? "Connecting to " : "Could not open a socket for ") << serverName << std::endl;
+    }
+    if (!connected) {
+        simulation.SpawnWanderers(200);
+        localPlayer = simulation.AddPlayer(glm::vec3(0.0f));
     }
 
-    unsigned int shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
-
-    // Ground VAO/VBO
-    unsigned int groundVAO, groundVBO;
-    glGenVertexArrays(1, &groundVAO);
-    glGenBuffers(1, &groundVBO);
+    // Edited shaders are rebuilt in the background and swapped in once they link
+    const std::string shaderDirectory = "../../src/shaders/";
+    ShaderWatcher shaderWatcher;
+    AsyncShaderCompiler shaderCompiler;
+    bool hotReload = shaderWatcher.Init(shaderDirectory) && shaderCompiler.Init(window);
+    if (hotReload)
+        std::cout << "Shader hot reload enabled (" << (shaderCompiler.IsParallel() ? "parallel compile" : "worker thread") << ")" << std::endl;
+
+    // Block-compressed textures are read on the job threads and their mips streamed in over time
+    TextureStreamer textureStreamer;
+    textureStreamer.Init(&jobSystem);
+    std::vector<StreamedTexture> streamedTextures;
+    std::error_code textureDirectoryError;
+    for (const auto& entry : std::filesystem::directory_iterator("../../assets/textures", textureDirectoryError)) {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".dds" || extension == ".ktx2")
+            streamedTextures.push_back(textureStreamer.Load(entry.path().string()));
+    }
 
-    glBindVertexArray(groundVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, groundVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(groundVertices), groundVertices, GL_STATIC_DRAW);
+    // CPU and GPU time of every phase of the frame
+    Profiler profiler;
+    profiler.Init();
+    scene.FrameProfiler = &profiler;
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Simulation runs at a fixed rate; rendering blends between the last two ticks
+    FixedTimestep timestep;
+    Interpolated<glm::vec3> cameraPosition;
+    cameraPosition.Reset(camera.Position);
+    placePlayerAtCamera();
 
     std::cout << "Camera initialized at position: (" << camera.Position.x << ", " << camera.Position.y << ", " << camera.Position.z << ")" << std::endl;
     std::cout << "Controls: WASD to move, mouse to look around, Alt to toggle cursor, scroll to zoom" << std::endl;
@@ -297,6 +339,10 @@ void main()
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        profiler.BeginFrame();
+        profiler.Begin(PHASE_INPUT);
+        glfwPollEvents();
+
         // Handle Alt key state changes
         bool altNow = glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS || 
                       glfwGetKey(window, GLFW_KEY_RIGHT_ALT) == GLFW_PRESS;
@@ -314,9 +360,65 @@ void main()
             altHeld = false;
         }
 
-        processInput(window);
+        int ticks = timestep.Advance(deltaTime);
+        for (int tick = 0; tick < ticks; ++tick) {
+            cameraPosition.BeginTick();
+            float tickSeconds = timestep.GetTickSeconds();
+            if (connected) {
+                // the server has no stress cubes, so neither does the prediction; the mirrored
+                // creatures are the colliders
+                if (client.Receive())
+                    simulation.ApplySnapshot(*client.GetSnapshot());
+                simulation.Tick(tickSeconds);
+                PlayerState state;
+                if (client.TakePlayerState(state))
+                    prediction.Reconcile(state, tickSeconds, simulation.Collision);
+                // applied at once, sent along with the ones the server may have missed
+                prediction.Predict(processInput(window, tickSeconds), tickSeconds, simulation.Collision);
+                InputCommand unconfirmed[INPUT_REDUNDANCY];
+                client.SendInputs(unconfirmed, prediction.GetUnconfirmed(unconfirmed, INPUT_REDUNDANCY));
+                if (walkMode)
+                    camera.Position = prediction.GetSmoothedEyePosition();
+                // the server only sends what is around the camera
+                client.SetView(camera.Position);
+            } else {
+                simulation.AddInput(localPlayer, processInput(window, tickSeconds));
+                // obstacles are posed at the end of this tick, which is where everything moves to
+                simulation.Obstacles.clear();
+                scene.Stress.AppendColliders(simulation.Obstacles, (float)((timestep.Tick - ticks + tick + 1) * tickSeconds));
+                simulation.Tick(tickSeconds);
+                if (walkMode)
+                    camera.Position = simulation.Players[localPlayer].GetEyePosition();
+            }
+            cameraPosition.Current = camera.Position;
+        }
+
+        // Rebuild programs whose files changed, swap in the ones that finished
+        if (hotReload) {
+            for (const std::string& file : shaderWatcher.Poll()) {
+                for (int program = 0; program < SCENE_PROGRAM_COUNT; ++program) {
+                    const SceneProgramFiles& files = SCENE_PROGRAM_FILES[program];
+                    if (file != files.Vertex && file != files.Fragment)
+                        continue;
+                    std::string vertexSource = loadFile(shaderDirectory + files.Vertex);
+                    std::string fragmentSource = loadFile(shaderDirectory + files.Fragment);
+                    if (!vertexSource.empty() && !fragmentSource.empty())
+                        shaderCompiler.Request(program, vertexSource, fragmentSource);
+                }
+            }
+            for (CompiledProgram& result : shaderCompiler.Poll()) {
+                if (result.Success) {
+                    scene.SetProgram((SceneProgram)result.Id, Shader(result.Program));
+                    std::cout << "Reloaded " << SCENE_PROGRAM_FILES[result.Id].Vertex << std::endl;
+                } else {
+                    std::cerr << "Shader reload failed, keeping the old program:\n" << result.Log << std::endl;
+                }
+            }
+        }
+        profiler.End(PHASE_INPUT);
 
         // Start ImGui frame
+        profiler.Begin(PHASE_IMGUI_BUILD);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -324,21 +426,118 @@ void main()
         // Debug UI
         ImGui::Begin("Debug Info");
         ImGui::Text("FPS: %.1f", 1.0f / deltaTime);
+
+        // Frame profiler, timings are from the previous frames
+        if (ImGui::CollapsingHeader("Profiler", ImGuiTreeNodeFlags_DefaultOpen)) {
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "p50 %.2f  p95 %.2f  p99 %.2f ms",
+                     profiler.Percentile(50.0f), profiler.Percentile(95.0f), profiler.Percentile(99.0f));
+            ImGui::PlotLines("Frame ms", profiler.History, profiler.HistoryCount, profiler.HistoryOffset, overlay, 0.0f, FLT_MAX, ImVec2(0, 60));
+            for (int phase = 0; phase < PHASE_COUNT; ++phase)
+                ImGui::Text("%-12s CPU %6.3f ms  GPU %6.3f ms", GetProfilePhaseName(phase), profiler.Phases[phase].CpuMs, profiler.Phases[phase].GpuMs);
+            for (int range = 0; range < RANGE_COUNT; ++range)
+                ImGui::Text("  %-10s              GPU %6.3f ms", GetProfileRangeName(range), profiler.RangeGpuMs[range]);
+            ImGui::Text("GPU Frame: %.3f ms  Missed Readbacks: %u", profiler.GpuFrameMs, profiler.MissedReadbacks);
+        }
         ImGui::Text("Camera Pos: (%.2f, %.2f, %.2f)", camera.Position.x, camera.Position.y, camera.Position.z);
         ImGui::Text("Camera Front: (%.2f, %.2f, %.2f)", camera.Front.x, camera.Front.y, camera.Front.z);
         ImGui::Text("Camera Yaw: %.1f  Pitch: %.1f", camera.Yaw, camera.Pitch);
         ImGui::Text("Camera Zoom: %.1f", camera.Zoom);
         ImGui::Text("Alt Held: %s", altHeld ? "Yes" : "No");
         ImGui::Text("Delta Time: %.4f", deltaTime);
+        ImGui::Text("Sim Ticks: %d this frame, alpha %.2f, %u dropped", timestep.TicksThisFrame, timestep.GetAlpha(), timestep.DroppedTicks);
+        ImGui::SliderFloat("Sim Rate (Hz)", &timestep.TickRate, 10.0f, 240.0f, "%.0f");
+
+        // Counters cover the previous frame's scene draw
+        UniformStats& uniformStats = GetUniformStats();
+        ImGui::Text("Uniform Uploads: %u  Skipped: %u", uniformStats.Uploads, uniformStats.Skipped);
+        ImGui::Text("Frame Constant Stalls: %u", scene.Constants.Stalls);
+
+        RenderStats& renderStats = GetRenderStats();
+        ImGui::Text("Draw Calls: %u  Instances: %u", renderStats.DrawCalls, renderStats.Instances);
+        ImGui::Text("CPU Submit: %.3f ms (%u job threads)", renderStats.SubmitMs, jobSystem.GetThreadCount());
+
+        ImGui::Text("Queue: %zu items, sort %.3f ms", scene.Queue.ItemCount, scene.Queue.SortMs);
+        ImGui::Text("State Changes: %u unsorted -> %u sorted", scene.Queue.UnsortedChanges.Total(), scene.Queue.SortedChanges.Total());
+        ImGui::Text("  Programs %u -> %u  Materials %u -> %u  VAOs %u -> %u",
+                    scene.Queue.UnsortedChanges.Programs, scene.Queue.SortedChanges.Programs,
+                    scene.Queue.UnsortedChanges.Materials, scene.Queue.SortedChanges.Materials,
+                    scene.Queue.UnsortedChanges.VAOs, scene.Queue.SortedChanges.VAOs);
+
+        CullStats& cullStats = GetCullStats();
+        ImGui::Text("Visible: %u / %u  Cull: %.3f ms", cullStats.Visible, cullStats.Tested, cullStats.CullMs);
+
+        ImGui::Text("Terrain: %u chunks, %u triangles (select %.3f ms)", scene.Ground.Stats.Nodes, scene.Ground.Stats.Triangles, scene.Ground.Stats.SelectMs);
+
+        MeshStats& meshStats = GetMeshStats();
+        ImGui::Text("Mesh Memory: %.1f KB vertices, %.1f KB indices", meshStats.VertexBytes / 1024.0f, meshStats.IndexBytes / 1024.0f);
         
         // Movement controls
         ImGui::SliderFloat("Movement Speed", &camera.MovementSpeed, 0.1f, 10.0f);
         ImGui::SliderFloat("Mouse Sensitivity", &camera.MouseSensitivity, 0.01f, 1.0f);
+        if (ImGui::Checkbox("Walk (Space to jump)", &walkMode) && walkMode)
+            placePlayerAtCamera();
+        const BroadphaseStats& collisionStats = simulation.Collision.Broadphase.Stats;
+        ImGui::Text("Colliders: %u (%u cell entries), build %.3f ms  On Ground: %s",
+                    collisionStats.Colliders, collisionStats.Entries, collisionStats.BuildMs, localController().OnGround ? "Yes" : "No");
+        ImGui::Text("Simulation: %zu entities, %.3f ms per tick (max %.3f ms)",
+                    simulation.Entities.GetEntityCount(), simulation.Stats.LastTickMs, simulation.Stats.MaxTickMs);
+        if (connected) {
+            const PredictionStats& predictionStats = prediction.Stats;
+            ImGui::Text("Server: %u snapshots, last %.1f KB, %u dropped", client.Stats.Snapshots, client.Stats.BytesReceived / 1024.0f, client.Stats.Dropped);
+            ImGui::Text("Prediction: %u ticks ahead, %u corrections (last %.3f m, replayed %u ticks in %.3f ms)",
+                        predictionStats.Pending, predictionStats.Corrections, predictionStats.LastError, predictionStats.LastReplayTicks, predictionStats.LastReplayMs);
+        }
         
         // Interactive elements
-        static float triangleY = 1.0f;
-        ImGui::SliderFloat("Triangle Height", &triangleY, 0.0f, 10.0f);
+        // the triangle is a static shadow caster, so moving it redraws the cached cascades
+        if (Transform* triangle = scene.Entities.Get<Transform>(scene.Triangle)) {
+            if (ImGui::SliderFloat("Triangle Height", &triangle->Position.y, 0.0f, 10.0f))
+                scene.Shadows.InvalidateStatic();
+        }
+        ImGui::Text("Entities: %zu in %zu archetypes", scene.Entities.GetEntityCount(), scene.Entities.GetArchetypeCount());
+        ImGui::Text("Hierarchy: %u nodes, %u updated (%.3f ms)", scene.Hierarchy.Stats.Nodes, scene.Hierarchy.Stats.Updated, scene.Hierarchy.Stats.UpdateMs);
         
+        // Stress test
+        ImGui::SliderInt("Stress Cubes", &scene.Stress.Count, 0, 200000, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::SliderInt("Props", &scene.Stress.PropCount, 0, 20000, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::Checkbox("Animate Cubes", &scene.Stress.Animate);
+        ImGui::Checkbox("Shadows", &scene.Shadows.Enabled);
+        ImGui::SameLine();
+        ImGui::Checkbox("Cache Static Casters", &scene.Shadows.CacheStatic);
+        ImGui::SliderFloat("Shadow Distance", &scene.Shadows.ShadowDistance, 20.0f, 500.0f);
+        ImGui::Text("Shadow cascades: %u static redraws, %u dynamic redraws, %u reused",
+                    scene.Shadows.Stats.StaticRedraws, scene.Shadows.Stats.DynamicRedraws, scene.Shadows.Stats.Reused);
+        static int textureBudgetMB = (int)(textureStreamer.ResidentBudgetBytes >> 20);
+        if (ImGui::SliderInt("Texture Budget (MB)", &textureBudgetMB, 16, 2048, "%d", ImGuiSliderFlags_Logarithmic))
+            textureStreamer.ResidentBudgetBytes = (size_t)textureBudgetMB << 20;
+        ImGui::Text("Textures: %u (%u loading, %u failed), %.1f MB resident, %.0f KB uploaded, %u evictions",
+                    textureStreamer.Stats.Textures, textureStreamer.Stats.Loading, textureStreamer.Stats.Failed,
+                    textureStreamer.Stats.ResidentBytes / (1024.0f * 1024.0f), textureStreamer.Stats.UploadedBytes / 1024.0f,
+                    textureStreamer.Stats.Evictions);
+        // the previews are what draws the streamed textures: each one on screen asks for the mips its size needs
+        if (!streamedTextures.empty() && ImGui::CollapsingHeader("Streamed Textures")) {
+            static int previewSize = 128;
+            ImGui::SliderInt("Preview Size", &previewSize, 16, 1024, "%d", ImGuiSliderFlags_Logarithmic);
+            ImVec2 size((float)previewSize, (float)previewSize);
+            for (StreamedTexture texture : streamedTextures) {
+                GLuint id = textureStreamer.GetTexture(texture);
+                bool visible = ImGui::IsRectVisible(size);
+                if (visible)
+                    textureStreamer.Request(texture, (float)previewSize);
+                if (visible && id)
+                    ImGui::Image((ImTextureID)id, size);
+                else
+                    ImGui::Dummy(size);
+                ImGui::SameLine();
+                ImGui::Text("level %u", textureStreamer.GetResidentLevel(texture));
+            }
+        }
+        ImGui::SliderInt("Point Lights", &scene.LightCount, 0, 4096, "%d", ImGuiSliderFlags_Logarithmic);
+        ImGui::Text("Lights: %u visible, %u cluster entries (max %u per cluster), %u dropped, assign %.3f ms",
+                    scene.Lighting.Stats.Visible, scene.Lighting.Stats.Entries, scene.Lighting.Stats.MaxPerCluster,
+                    scene.Lighting.Stats.Dropped, scene.Lighting.Stats.AssignMs);
+
         static float clearColor[3] = {0.2f, 0.1f, 0.3f};
         ImGui::ColorEdit3("Background Color", clearColor);
         
@@ -348,58 +547,61 @@ void main()
             camera.Yaw = -90.0f;
             camera.Pitch = 0.0f;
             camera.updateCameraVectors();
+            cameraPosition.Reset(camera.Position);
+            placePlayerAtCamera();
         }
         
         ImGui::End();
+        uniformStats.Reset();
+        renderStats.Reset();
+        cullStats.Reset();
+        profiler.End(PHASE_IMGUI_BUILD);
+
+        profiler.Begin(PHASE_SCENE);
+
+        // Track the real framebuffer size so resizing keeps the right aspect ratio
+        int framebufferWidth, framebufferHeight;
+        glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+        glViewport(0, 0, framebufferWidth, framebufferHeight);
 
         // Clear with dynamic background color
         glClearColor(clearColor[0], clearColor[1], clearColor[2], 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        glUseProgram(shaderProgram);
-
-        // Update view/projection matrices
-        view = camera.GetViewMatrix();
-        projection = glm::perspective(glm::radians(camera.Zoom), 1280.0f / 720.0f, 0.1f, 100.0f);
-
-        int modelLoc = glGetUniformLocation(shaderProgram, "model");
-        int viewLoc  = glGetUniformLocation(shaderProgram, "view");
-        int projLoc  = glGetUniformLocation(shaderProgram, "projection");
-
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-        // Draw Ground
-        model = glm::mat4(1.0f);
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glBindVertexArray(groundVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        // Draw Triangle with adjustable height
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(0.0f, triangleY, 0.0f));
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
+        // Render between the last two simulation states, so motion stays smooth at any frame rate
+        Camera renderCamera = camera;
+        renderCamera.Position = cameraPosition.Get(timestep.GetAlpha());
+        scene.SimulatedAlpha = simulation.GetRenderAlpha(timestep.GetAlpha());
+        scene.Draw(renderCamera, framebufferWidth, framebufferHeight, (float)timestep.GetRenderTime(), deltaTime);
+        textureStreamer.Update();
+        profiler.End(PHASE_SCENE);
 
         // Render ImGui
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            ProfileScope scope(profiler, PHASE_IMGUI_RENDER);
+            ImGui::Render();
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        {
+            ProfileScope scope(profiler, PHASE_SWAP);
+            glfwSwapBuffers(window);
+        }
     }
 
     // Cleanup
+    if (connected)
+        client.Disconnect();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteVertexArrays(1, &groundVAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &groundVBO);
-    glDeleteProgram(shaderProgram);
+    shaderCompiler.Delete();
+    shaderWatcher.Delete();
+    scene.Delete();
+    textureStreamer.Delete();
+    jobSystem.Delete();
+    profiler.Delete();
     
     glfwTerminate();
     return 0;
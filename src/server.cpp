@@ -0,0 +1,307 @@
+// Dedicated server: runs the simulation at a fixed tick rate without a window or GL context and
+// replicates it to whoever connects. Each client gets a player that walks by the input commands
+// it sends. Prints its memory footprint and per-tick cost when it stops
+// (after --seconds, or on Ctrl+C).
+//
+//   ge_server [--port N] [--entities N] [--tick-rate HZ] [--threads N] [--seconds S] [--view-distance M]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "FixedTimestep.h"
+#include "Interest.h"
+#include "JobSystem.h"
+#include "Replication.h"
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "TerrainHeightmap.h"
+
+static std::atomic<bool> running{ true };
+
+static void onSignal(int)
+{
+    running = false;
+}
+
+struct ProcessUsage
+{
+    size_t ResidentBytes = 0;
+    size_t PeakResidentBytes = 0;
+    double CpuSeconds = 0.0;
+};
+
+static ProcessUsage getProcessUsage()
+{
+    ProcessUsage usage;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))
+    {
+        usage.ResidentBytes = memory.WorkingSetSize;
+        usage.PeakResidentBytes = memory.PeakWorkingSetSize;
+    }
+    FILETIME creation, exit, kernel, user;
+    if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        auto seconds = [](const FILETIME& time) { return (double)(((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) * 1e-7; };
+        usage.CpuSeconds = seconds(kernel) + seconds(user);
+    }
+#else
+    struct rusage resources;
+    if (getrusage(RUSAGE_SELF, &resources) == 0)
+    {
+#ifdef __APPLE__
+        usage.PeakResidentBytes = (size_t)resources.ru_maxrss;
+#else
+        usage.PeakResidentBytes = (size_t)resources.ru_maxrss * 1024;
+#endif
+        usage.CpuSeconds = resources.ru_utime.tv_sec + resources.ru_utime.tv_usec * 1e-6 + resources.ru_stime.tv_sec + resources.ru_stime.tv_usec * 1e-6;
+    }
+    // resident pages right now; Linux only, elsewhere the peak has to do
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm)
+    {
+        unsigned long pages = 0, resident = 0;
+        if (fscanf(statm, "%lu %lu", &pages, &resident) == 2)
+            usage.ResidentBytes = (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+        fclose(statm);
+    }
+#endif
+    return usage;
+}
+
+// gives every newly connected client a player and takes the players of those that left back
+static void assignPlayers(const ReplicationServer& server, Simulation& simulation, std::unordered_map<uint32_t, uint32_t>& players, std::vector<uint32_t>& freePlayers)
+{
+    for (auto it = players.begin(); it != players.end();)
+    {
+        bool connected = false;
+        for (size_t client = 0; client < server.GetClientCount() && !connected; ++client)
+            connected = server.GetClientId(client) == it->first;
+        if (connected)
+        {
+            ++it;
+            continue;
+        }
+        freePlayers.push_back(it->second);
+        it = players.erase(it);
+    }
+    for (size_t client = 0; client < server.GetClientCount(); ++client)
+    {
+        uint32_t id = server.GetClientId(client);
+        if (players.count(id))
+            continue;
+        // everyone starts at the origin, which the terrain keeps flat
+        glm::vec3 spawn(0.0f);
+        if (freePlayers.empty())
+        {
+            players[id] = simulation.AddPlayer(spawn);
+            continue;
+        }
+        uint32_t player = freePlayers.back();
+        freePlayers.pop_back();
+        simulation.Players[player].Position = spawn;
+        simulation.Players[player].Velocity = glm::vec3(0.0f);
+        players[id] = player;
+    }
+}
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static void printUsage(FILE* out)
+{
+    fprintf(out, "usage: ge_server [--port N] [--entities N] [--tick-rate HZ] [--threads N] [--seconds S] [--view-distance M]\n");
+}
+
+int main(int argc, char** argv)
+{
+    uint16_t port = 27015;
+    uint32_t entityCount = 5000;
+    float tickRate = 60.0f;
+    // one thread by default: many instances share a box, each should stay on one core
+    unsigned int threads = 1;
+    double seconds = 0.0;
+    // clients hear about entities this far from their camera; 0 sends everything to everyone
+    float viewDistance = 200.0f;
+    for (int i = 1; i < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage(stdout);
+            return 0;
+        }
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "Missing value for %s\n", arg.c_str());
+            printUsage(stderr);
+            return 1;
+        }
+        if (arg == "--port") port = (uint16_t)atoi(argv[i + 1]);
+        else if (arg == "--entities") entityCount = (uint32_t)std::max(0, atoi(argv[i + 1]));
+        else if (arg == "--tick-rate") tickRate = std::max(1.0f, (float)atof(argv[i + 1]));
+        else if (arg == "--threads") threads = (unsigned int)std::max(0, atoi(argv[i + 1]));
+        else if (arg == "--seconds") seconds = atof(argv[i + 1]);
+        else if (arg == "--view-distance") viewDistance = std::max(0.0f, (float)atof(argv[i + 1]));
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", arg.c_str());
+            printUsage(stderr);
+            return 1;
+        }
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    ProcessUsage startUsage = getProcessUsage();
+    auto start = std::chrono::high_resolution_clock::now();
+
+    JobSystem jobs;
+    jobs.Init(threads);
+
+    // same terrain as the game, so creatures stand on the ground the players see
+    TerrainHeightmap heightmap;
+    heightmap.Generate();
+
+    Simulation simulation;
+    // wanderers spread out with their number so the density stays about the same as in the game
+    simulation.Extent = std::max(48.0f, std::sqrt((float)entityCount) * 1.5f);
+    if (jobs.GetThreadCount() > 1)
+        simulation.Jobs = &jobs;
+    simulation.SetGround(heightmap.AsHeightfield());
+    simulation.SpawnWanderers(entityCount);
+
+    ReplicationServer server;
+    InterestGrid interest;
+    if (viewDistance > 0.0f)
+    {
+        float scale = viewDistance / interest.Rings.back().Distance;
+        for (InterestRing& ring : interest.Rings)
+            ring.Distance *= scale;
+        server.Interest = &interest;
+    }
+    if (!server.Start(port))
+    {
+        printf("could not open UDP port %u\n", port);
+        jobs.Delete();
+        return 1;
+    }
+    printf("ge_server: %u entities at %.0f Hz on port %u, %u thread(s), ready in %.0f ms\n",
+           entityCount, tickRate, server.GetPort(), jobs.GetThreadCount(), elapsedMs(start));
+
+    FixedTimestep timestep;
+    timestep.TickRate = tickRate;
+    Snapshot snapshot;
+    // client id -> player index
+    std::unordered_map<uint32_t, uint32_t> players;
+    std::vector<uint32_t> freePlayers;
+    double networkMs = 0.0, maxNetworkMs = 0.0, maxTickMs = 0.0, interestMs = 0.0;
+    unsigned long long relevant = 0, viewers = 0;
+    size_t bytesSent = 0;
+    unsigned int peakClients = 0;
+    auto runStart = std::chrono::high_resolution_clock::now();
+    ProcessUsage runStartUsage = getProcessUsage();
+    auto last = std::chrono::steady_clock::now();
+    while (running)
+    {
+        auto now = std::chrono::steady_clock::now();
+        int ticks = timestep.Advance(std::chrono::duration<double>(now - last).count());
+        last = now;
+        for (int tick = 0; tick < ticks; ++tick)
+        {
+            auto tickStart = std::chrono::high_resolution_clock::now();
+            server.Receive();
+            assignPlayers(server, simulation, players, freePlayers);
+            // one command per client and tick. A player whose command is late stands still until it
+            // arrives, then catches up with two a tick so the delay doesn't stay.
+            for (size_t client = 0; client < server.GetClientCount(); ++client)
+            {
+                uint32_t player = players[server.GetClientId(client)];
+                InputCommand command;
+                if (server.PopInput(client, command))
+                    simulation.AddInput(player, command.Input);
+                if (server.GetQueuedInputs(client) > INPUT_CATCH_UP && server.PopInput(client, command))
+                    simulation.AddInput(player, command.Input);
+            }
+            double network = elapsedMs(tickStart);
+
+            simulation.Tick(timestep.GetTickSeconds());
+
+            auto networkStart = std::chrono::high_resolution_clock::now();
+            if (server.GetClientCount() > 0)
+            {
+                for (size_t client = 0; client < server.GetClientCount(); ++client)
+                    server.SendPlayerState(client, simulation.Players[players[server.GetClientId(client)]]);
+                CaptureSnapshot(simulation.Entities, (uint32_t)(timestep.Tick - ticks + tick + 1), snapshot);
+                server.Send(snapshot);
+                bytesSent += server.Stats.BytesSent;
+                interestMs += server.Stats.InterestMs;
+                relevant += interest.Stats.Relevant;
+                viewers += interest.Stats.Viewers;
+            }
+            network += elapsedMs(networkStart);
+            networkMs += network;
+            maxNetworkMs = std::max(maxNetworkMs, network);
+            maxTickMs = std::max(maxTickMs, elapsedMs(tickStart));
+            peakClients = std::max(peakClients, (unsigned int)server.GetClientCount());
+        }
+        if (seconds > 0.0 && std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - runStart).count() >= seconds)
+            break;
+        // sleep until the next tick is due
+        double wait = (1.0 - timestep.GetAlpha()) * timestep.GetTickSeconds();
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+    }
+
+    double runSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - runStart).count();
+    ProcessUsage usage = getProcessUsage();
+    unsigned long long ticksRun = simulation.Stats.Ticks;
+    double perTick = ticksRun ? 1.0 / (double)ticksRun : 0.0;
+    double cpuSeconds = usage.CpuSeconds - runStartUsage.CpuSeconds;
+
+    printf("\nge_server ran %llu ticks in %.1f s (%u dropped), %zu entities, up to %u clients\n",
+           ticksRun, runSeconds, timestep.DroppedTicks, simulation.Entities.GetEntityCount(), peakClients);
+    printf("per tick: simulation %.3f ms (max %.3f), replication %.3f ms (max %.3f), total max %.3f ms of a %.3f ms budget\n",
+           simulation.Stats.TotalTickMs * perTick, simulation.Stats.MaxTickMs, networkMs * perTick, maxNetworkMs, maxTickMs,
+           timestep.GetTickSeconds() * 1000.0);
+    printf("process CPU: %.2f s (%.1f%% of one core), %.3f ms per tick\n",
+           cpuSeconds, runSeconds > 0.0 ? cpuSeconds / runSeconds * 100.0 : 0.0, cpuSeconds * 1000.0 * perTick);
+    printf("memory: %.1f MB resident (%.1f MB peak, %.1f MB at startup); heightmap %.1f MB\n",
+           usage.ResidentBytes / 1048576.0, usage.PeakResidentBytes / 1048576.0, startUsage.PeakResidentBytes / 1048576.0,
+           heightmap.Heights.size() * sizeof(float) / 1048576.0);
+    if (bytesSent)
+        printf("replication: %.1f KB sent, %.1f KB/s\n", bytesSent / 1024.0, bytesSent / 1024.0 / runSeconds);
+    if (viewers)
+        printf("interest: %.0f of %zu entities per client, %.3f ms per tick\n",
+               (double)relevant / viewers, simulation.Entities.GetEntityCount(), interestMs * perTick);
+    if (server.Stats.RejectedInputs)
+        printf("input: %u commands rejected for a move that isn't finite\n", server.Stats.RejectedInputs);
+
+    server.Stop();
+    jobs.Delete();
+    return 0;
+}
@@ -1,9 +1,99 @@
 #version 330 core
 
 in vec3 ourColor;  // Must match `out` from vertex shader
+in vec3 worldPosition;
+in vec3 worldNormal;
 out vec4 FragColor;
 
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    vec4 cameraPosition;
+    vec2 viewportSize;
+    float time;
+    float deltaTime;
+};
+
+// clustered point lights, filled by ClusteredLighting in Lighting.h
+layout (std140) uniform LightingConstants
+{
+    uvec4 clusterCounts; // grid x, y, z, unused
+    vec4 clusterDepth;   // near, far, slice scale, slice bias
+};
+
+// sun and its cascaded shadow map, filled by CascadedShadowMaps in Shadows.h
+layout (std140) uniform ShadowConstants
+{
+    mat4 cascadeViewProj[4];
+    vec4 cascadeSplits;  // view depth where each cascade ends
+    vec4 cascadeTexel;   // world size of a shadow texel per cascade
+    vec4 sunDirection;   // xyz towards the sun, w intensity
+    vec4 shadowParams;   // depth bias, normal offset in texels, ambient, 1 when shadows are on
+};
+
+uniform sampler2DArrayShadow shadowMap;
+uniform usamplerBuffer clusterRanges; // per cluster: first entry in lightIndices, light count
+uniform usamplerBuffer lightIndices;
+uniform samplerBuffer lightData;      // per light: position + radius, color + intensity
+
+// fraction of sunlight reaching the point, 3x3 PCF on top of the hardware 2x2
+float sunVisibility(vec3 position, vec3 normal, float depth)
+{
+    if (shadowParams.w == 0.0 || depth >= cascadeSplits.w)
+        return 1.0;
+
+    int cascade = 0;
+    while (cascade < 3 && depth >= cascadeSplits[cascade])
+        cascade++;
+
+    // push the lookup out along the normal by about a texel to keep acne off sloped surfaces
+    vec3 offsetPosition = position + normal * cascadeTexel[cascade] * shadowParams.y;
+    vec3 coord = (cascadeViewProj[cascade] * vec4(offsetPosition, 1.0)).xyz * 0.5 + 0.5;
+    if (coord.z >= 1.0)
+        return 1.0;
+
+    vec2 texel = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float lit = 0.0;
+    for (int y = -1; y <= 1; ++y)
+    {
+        for (int x = -1; x <= 1; ++x)
+            lit += texture(shadowMap, vec4(coord.xy + vec2(x, y) * texel, float(cascade), coord.z - shadowParams.x));
+    }
+    return lit / 9.0;
+}
+
 void main()
 {
-    FragColor = vec4(ourColor, 1.0);
-}
\ No newline at end of file
+    // froxel of this fragment: screen tile, then exponential depth slice
+    float depth = -(view * vec4(worldPosition, 1.0)).z;
+    uint slice = uint(clamp(log(depth) * clusterDepth.z + clusterDepth.w, 0.0, float(clusterCounts.z - 1u)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / viewportSize * vec2(clusterCounts.xy)), clusterCounts.xy - 1u);
+    int cluster = int(tile.x + clusterCounts.x * (tile.y + clusterCounts.y * slice));
+    uvec2 range = texelFetch(clusterRanges, cluster).xy;
+
+    vec3 normal = normalize(worldNormal);
+    float sun = max(dot(normal, sunDirection.xyz), 0.0) * sunVisibility(worldPosition, normal, depth);
+    vec3 lighting = vec3(shadowParams.z + sunDirection.w * sun);
+    for (uint i = 0u; i < range.y; ++i)
+    {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+        vec4 positionRadius = texelFetch(lightData, light * 2);
+        vec4 colorIntensity = texelFetch(lightData, light * 2 + 1);
+
+        vec3 toLight = positionRadius.xyz - worldPosition;
+        float distanceSq = dot(toLight, toLight);
+        float radiusSq = positionRadius.w * positionRadius.w;
+        if (distanceSq >= radiusSq)
+            continue;
+
+        // inverse square falloff windowed to reach zero at the radius
+        float window = 1.0 - distanceSq / radiusSq;
+        float attenuation = window * window / (distanceSq + 1.0);
+        float diffuse = max(dot(normal, toLight * inversesqrt(max(distanceSq, 1e-4))), 0.0);
+        lighting += colorIntensity.rgb * colorIntensity.w * diffuse * attenuation;
+    }
+
+    FragColor = vec4(ourColor * lighting, 1.0);
+}
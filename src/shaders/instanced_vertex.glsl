@@ -0,0 +1,34 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec3 aNormal;
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec4 aInstanceColor;
+
+out vec3 ourColor;
+out vec3 worldPosition;
+out vec3 worldNormal;
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    vec4 cameraPosition;
+    vec2 viewportSize;
+    float time;
+    float deltaTime;
+};
+
+uniform vec4 tint = vec4(1.0); // material tint
+
+void main()
+{
+    vec4 world = aModel * vec4(aPos, 1.0);
+    gl_Position = viewProj * world;
+    worldPosition = world.xyz;
+    // inverse transpose, so non-uniform scale does not tilt the normals
+    worldNormal = transpose(inverse(mat3(aModel))) * aNormal;
+    ourColor = aColor * aInstanceColor.rgb * tint.rgb;
+}
@@ -0,0 +1,6 @@
+#version 330 core
+
+// Shadow map pass: only depth is written, so there is nothing to shade
+void main()
+{
+}
@@ -0,0 +1,73 @@
+#version 330 core
+
+layout (location = 0) in vec2 aGridPos;
+
+out vec3 ourColor;
+out vec3 worldPosition;
+out vec3 worldNormal;
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    vec4 cameraPosition;
+    vec2 viewportSize;
+    float time;
+    float deltaTime;
+};
+
+uniform vec2 nodeOffset;   // world xz of the chunk's corner
+uniform float nodeScale;   // world size of the chunk
+uniform vec2 morphRange;   // distance where morphing to the next LOD starts / ends
+uniform float gridSize;    // quads per side of the shared grid
+uniform float worldSize;
+uniform sampler2D heightmap;
+
+float sampleHeight(vec2 worldXZ)
+{
+    vec2 size = vec2(textureSize(heightmap, 0));
+    // map world space onto texel centers so the edges land exactly on the first/last sample
+    vec2 uv = (worldXZ / worldSize + 0.5) * ((size - 1.0) / size) + 0.5 / size;
+    return textureLod(heightmap, uv, 0.0).r;
+}
+
+// moves odd grid vertices onto their even neighbour, which turns the grid into the next coarser LOD
+vec2 morphVertex(vec2 gridPos, float morph)
+{
+    vec2 fracPart = fract(gridPos * gridSize * 0.5) * 2.0 / gridSize;
+    return gridPos - fracPart * morph;
+}
+
+void main()
+{
+    vec2 worldXZ = nodeOffset + aGridPos * nodeScale;
+    float height = sampleHeight(worldXZ);
+
+    float distance = length(cameraPosition.xyz - vec3(worldXZ.x, height, worldXZ.y));
+    float morph = clamp((distance - morphRange.x) / (morphRange.y - morphRange.x), 0.0, 1.0);
+
+    worldXZ = nodeOffset + morphVertex(aGridPos, morph) * nodeScale;
+    height = sampleHeight(worldXZ);
+
+    // normal from central differences, one heightmap texel apart
+    float texel = worldSize / (float(textureSize(heightmap, 0).x) - 1.0);
+    float hl = sampleHeight(worldXZ - vec2(texel, 0.0));
+    float hr = sampleHeight(worldXZ + vec2(texel, 0.0));
+    float hd = sampleHeight(worldXZ - vec2(0.0, texel));
+    float hu = sampleHeight(worldXZ + vec2(0.0, texel));
+    vec3 normal = normalize(vec3(hl - hr, 2.0 * texel, hd - hu));
+
+    vec3 grass = vec3(0.2, 0.6, 0.2);
+    vec3 rock = vec3(0.45, 0.42, 0.4);
+    vec3 snow = vec3(0.95, 0.95, 1.0);
+    vec3 color = mix(rock, grass, smoothstep(0.7, 0.85, normal.y));
+    color = mix(color, snow, smoothstep(70.0, 90.0, height) * smoothstep(0.6, 0.8, normal.y));
+
+    // the sun is applied per fragment, together with its shadow
+    ourColor = color;
+
+    worldPosition = vec3(worldXZ.x, height, worldXZ.y);
+    worldNormal = normal;
+    gl_Position = viewProj * vec4(worldPosition, 1.0);
+}
@@ -2,15 +2,32 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aColor;
+layout (location = 2) in vec3 aNormal;
 
 out vec3 ourColor;
+out vec3 worldPosition;
+out vec3 worldNormal;
+
+layout (std140) uniform FrameConstants
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProj;
+    vec4 cameraPosition;
+    vec2 viewportSize;
+    float time;
+    float deltaTime;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+uniform vec4 tint = vec4(1.0); // material tint
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-    ourColor = aColor;
+    vec4 world = model * vec4(aPos, 1.0);
+    gl_Position = viewProj * world;
+    worldPosition = world.xyz;
+    // inverse transpose, so non-uniform scale does not tilt the normals
+    worldNormal = transpose(inverse(mat3(model))) * aNormal;
+    ourColor = aColor * tint.rgb;
 }
\ No newline at end of file
@@ -0,0 +1,1206 @@
+// Offline mesh cooker: imports OBJ or glTF 2.0 (.gltf/.glb), welds identical vertices, orders the
+// triangles for the post-transform vertex cache and for overdraw, quantizes the vertices and writes a
+// .gemesh file (MeshFile.h) that the engine maps and uploads without parsing.
+//
+//   ge_cook input.(obj|gltf|glb) output.gemesh [--no-optimize] [--cache-size N]
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Components.h"
+#include "Mesh.h"
+#include "MeshFile.h"
+
+static double elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool readFile(const std::string& path, std::vector<char>& out)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    out.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && fread(out.data(), 1, out.size(), file) == out.size();
+    fclose(file);
+    return ok;
+}
+
+static std::string lowerExtension(const std::string& path)
+{
+    size_t dot = path.find_last_of('.');
+    std::string extension = dot == std::string::npos ? "" : path.substr(dot);
+    for (char& c : extension)
+        c = (char)tolower((unsigned char)c);
+    return extension;
+}
+
+static const glm::vec4 DEFAULT_COLOR(0.8f, 0.8f, 0.8f, 1.0f);
+
+// area-weighted vertex normals for an indexed triangle list, for sources that have none
+static void computeNormals(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, std::vector<glm::vec3>& normals)
+{
+    normals.assign(positions.size(), glm::vec3(0.0f));
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        const glm::vec3& a = positions[indices[i]];
+        glm::vec3 n = glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a);
+        normals[indices[i]] += n;
+        normals[indices[i + 1]] += n;
+        normals[indices[i + 2]] += n;
+    }
+}
+
+// ---------------------------------------------------------------------------------------------
+// OBJ: v (with optional vertex colors), vn and f; polygons are fanned into triangles
+
+static bool importObj(const std::string& path, MeshData& out)
+{
+    std::vector<char> text;
+    if (!readFile(path, text))
+        return false;
+    text.push_back('\0');
+
+    std::vector<glm::vec3> positions, normals;
+    std::vector<glm::vec4> colors;
+    // per triangle corner: position and normal index (-1 when the face gives no normal)
+    std::vector<int> cornerPositions, cornerNormals;
+    std::vector<int> facePositions, faceNormals;
+    bool missingNormals = false;
+
+    char* line = text.data();
+    while (*line)
+    {
+        // one line at a time, terminated so the number parsers cannot run into the next one
+        char* next = line;
+        while (*next && *next != '\n')
+            ++next;
+        bool last = *next == '\0';
+        *next = '\0';
+
+        char* p = line;
+        while (*p == ' ' || *p == '\t')
+            ++p;
+        if (p[0] == 'v' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            char* end;
+            glm::vec3 v;
+            v.x = strtof(p + 2, &end);
+            v.y = strtof(end, &end);
+            v.z = strtof(end, &end);
+            positions.push_back(v);
+            char* colorEnd;
+            float r = strtof(end, &colorEnd);
+            if (colorEnd != end)
+            {
+                float g = strtof(colorEnd, &colorEnd);
+                float b = strtof(colorEnd, &colorEnd);
+                colors.resize(positions.size() - 1, DEFAULT_COLOR);
+                colors.push_back(glm::vec4(r, g, b, 1.0f));
+            }
+        }
+        else if (p[0] == 'v' && p[1] == 'n' && (p[2] == ' ' || p[2] == '\t'))
+        {
+            char* end;
+            glm::vec3 n;
+            n.x = strtof(p + 3, &end);
+            n.y = strtof(end, &end);
+            n.z = strtof(end, &end);
+            normals.push_back(n);
+        }
+        else if (p[0] == 'f' && (p[1] == ' ' || p[1] == '\t'))
+        {
+            facePositions.clear();
+            faceNormals.clear();
+            p += 2;
+            for (;;)
+            {
+                char* end;
+                long position = strtol(p, &end, 10);
+                if (end == p)
+                    break;
+                p = end;
+                long normal = 0;
+                if (*p == '/')
+                {
+                    ++p;
+                    if (*p != '/')
+                    {
+                        strtol(p, &end, 10); // texture coordinate, not used
+                        p = end;
+                    }
+                    if (*p == '/')
+                    {
+                        ++p;
+                        normal = strtol(p, &end, 10);
+                        p = end;
+                    }
+                }
+                // 1-based, negative counts back from the latest
+                long positionIndex = position < 0 ? (long)positions.size() + position : position - 1;
+                long normalIndex = normal < 0 ? (long)normals.size() + normal : normal - 1;
+                if (positionIndex < 0 || positionIndex >= (long)positions.size() || normalIndex >= (long)normals.size())
+                {
+                    fprintf(stderr, "%s: face index out of range\n", path.c_str());
+                    return false;
+                }
+                if (normalIndex < 0)
+                    missingNormals = true;
+                facePositions.push_back((int)positionIndex);
+                faceNormals.push_back((int)normalIndex);
+            }
+            for (size_t k = 1; k + 1 < facePositions.size(); ++k)
+            {
+                cornerPositions.insert(cornerPositions.end(), { facePositions[0], facePositions[k], facePositions[k + 1] });
+                cornerNormals.insert(cornerNormals.end(), { faceNormals[0], faceNormals[k], faceNormals[k + 1] });
+            }
+        }
+
+        if (last)
+            break;
+        line = next + 1;
+    }
+
+    // smooth normals over shared positions for corners without one
+    std::vector<glm::vec3> generated;
+    if (missingNormals)
+        computeNormals(positions, std::vector<uint32_t>(cornerPositions.begin(), cornerPositions.end()), generated);
+
+    // unindexed for now; identical corners are welded later
+    out = MeshData();
+    for (size_t i = 0; i < cornerPositions.size(); ++i)
+    {
+        int position = cornerPositions[i];
+        glm::vec3 normal = cornerNormals[i] >= 0 ? normals[cornerNormals[i]] : generated[position];
+        glm::vec4 color = (size_t)position < colors.size() ? colors[position] : DEFAULT_COLOR;
+        out.Indices.push_back(out.AddVertex(positions[position], normal, color));
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Just enough JSON for glTF
+
+struct Json
+{
+    enum Kind { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+    Kind Type = NUL;
+    bool Boolean = false;
+    double Number = 0.0;
+    std::string String;
+    std::vector<Json> Items;
+    std::vector<std::pair<std::string, Json>> Members;
+
+    const Json* Find(const char* key) const
+    {
+        for (const auto& member : Members)
+        {
+            if (member.first == key)
+                return &member.second;
+        }
+        return nullptr;
+    }
+
+    double NumberOr(const char* key, double fallback) const
+    {
+        const Json* value = Find(key);
+        return value && value->Type == NUMBER ? value->Number : fallback;
+    }
+
+    // element count of the named array, 0 when missing
+    size_t Count(const char* key) const
+    {
+        const Json* value = Find(key);
+        return value && value->Type == ARRAY ? value->Items.size() : 0;
+    }
+};
+
+class JsonParser
+{
+public:
+    bool Parse(const char* begin, const char* end, Json& out)
+    {
+        p = begin;
+        last = end;
+        ok = true;
+        out = parseValue(0);
+        skipSpace();
+        return ok;
+    }
+
+private:
+    const char* p = nullptr;
+    const char* last = nullptr;
+    bool ok = true;
+
+    void skipSpace()
+    {
+        while (p < last && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+            ++p;
+    }
+
+    bool expect(char c)
+    {
+        skipSpace();
+        if (p < last && *p == c)
+        {
+            ++p;
+            return true;
+        }
+        ok = false;
+        return false;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code)
+    {
+        if (code < 0x80)
+            out += (char)code;
+        else if (code < 0x800)
+        {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    std::string parseString()
+    {
+        std::string result;
+        if (!expect('"'))
+            return result;
+        while (p < last && *p != '"')
+        {
+            char c = *p++;
+            if (c != '\\')
+            {
+                result += c;
+                continue;
+            }
+            if (p >= last)
+                break;
+            char escape = *p++;
+            switch (escape)
+            {
+            case 'b': result += '\b'; break;
+            case 'f': result += '\f'; break;
+            case 'n': result += '\n'; break;
+            case 'r': result += '\r'; break;
+            case 't': result += '\t'; break;
+            case 'u':
+                if (last - p >= 4)
+                {
+                    appendUtf8(result, (uint32_t)strtoul(std::string(p, p + 4).c_str(), nullptr, 16));
+                    p += 4;
+                }
+                break;
+            default: result += escape; break;
+            }
+        }
+        if (p >= last)
+            ok = false;
+        else
+            ++p;
+        return result;
+    }
+
+    Json parseValue(int depth)
+    {
+        Json value;
+        skipSpace();
+        if (p >= last || depth > 64)
+        {
+            ok = false;
+            return value;
+        }
+        if (*p == '{')
+        {
+            ++p;
+            value.Type = Json::OBJECT;
+            skipSpace();
+            if (p < last && *p == '}')
+            {
+                ++p;
+                return value;
+            }
+            while (ok)
+            {
+                skipSpace();
+                std::string key = parseString();
+                if (!expect(':'))
+                    break;
+                value.Members.emplace_back(key, parseValue(depth + 1));
+                skipSpace();
+                if (p < last && *p == ',')
+                    ++p;
+                else
+                {
+                    expect('}');
+                    break;
+                }
+            }
+        }
+        else if (*p == '[')
+        {
+            ++p;
+            value.Type = Json::ARRAY;
+            skipSpace();
+            if (p < last && *p == ']')
+            {
+                ++p;
+                return value;
+            }
+            while (ok)
+            {
+                value.Items.push_back(parseValue(depth + 1));
+                skipSpace();
+                if (p < last && *p == ',')
+                    ++p;
+                else
+                {
+                    expect(']');
+                    break;
+                }
+            }
+        }
+        else if (*p == '"')
+        {
+            value.Type = Json::STRING;
+            value.String = parseString();
+        }
+        else if (last - p >= 4 && strncmp(p, "true", 4) == 0)
+        {
+            value.Type = Json::BOOLEAN;
+            value.Boolean = true;
+            p += 4;
+        }
+        else if (last - p >= 5 && strncmp(p, "false", 5) == 0)
+        {
+            value.Type = Json::BOOLEAN;
+            p += 5;
+        }
+        else if (last - p >= 4 && strncmp(p, "null", 4) == 0)
+            p += 4;
+        else
+        {
+            // copy the token out, the buffer is not null-terminated
+            const char* start = p;
+            while (p < last && (isdigit((unsigned char)*p) || *p == '-' || *p == '+' || *p == '.' || *p == 'e' || *p == 'E'))
+                ++p;
+            if (p == start)
+            {
+                ok = false;
+                return value;
+            }
+            value.Type = Json::NUMBER;
+            value.Number = strtod(std::string(start, p).c_str(), nullptr);
+        }
+        return value;
+    }
+};
+
+// ---------------------------------------------------------------------------------------------
+// glTF 2.0: triangle primitives of every mesh in the default scene, baked with their node transforms
+
+struct GltfDocument
+{
+    Json Root;
+    std::vector<std::vector<uint8_t>> Buffers;
+};
+
+static bool decodeBase64(const char* text, size_t length, std::vector<uint8_t>& out)
+{
+    static int table[256];
+    static bool built = false;
+    if (!built)
+    {
+        const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (int i = 0; i < 256; ++i)
+            table[i] = -1;
+        for (int i = 0; i < 64; ++i)
+            table[(unsigned char)alphabet[i]] = i;
+        built = true;
+    }
+    uint32_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        if (text[i] == '=')
+            break;
+        int value = table[(unsigned char)text[i]];
+        if (value < 0)
+            return false;
+        bits = (bits << 6) | (uint32_t)value;
+        count += 6;
+        if (count >= 8)
+        {
+            count -= 8;
+            out.push_back((uint8_t)(bits >> count));
+        }
+    }
+    return true;
+}
+
+static bool loadGltf(const std::string& path, GltfDocument& document)
+{
+    std::vector<char> file;
+    if (!readFile(path, file))
+        return false;
+
+    const char* json = file.data();
+    size_t jsonLength = file.size();
+    std::vector<uint8_t> binary;
+    bool glb = file.size() >= 12 && memcmp(file.data(), "glTF", 4) == 0;
+    if (glb)
+    {
+        // 12 byte header, then chunks: JSON first, optionally BIN
+        size_t offset = 12;
+        jsonLength = 0;
+        while (offset + 8 <= file.size())
+        {
+            uint32_t length, type;
+            memcpy(&length, file.data() + offset, 4);
+            memcpy(&type, file.data() + offset + 4, 4);
+            if (offset + 8 + length > file.size())
+                return false;
+            const char* chunk = file.data() + offset + 8;
+            if (type == 0x4E4F534A)
+            {
+                json = chunk;
+                jsonLength = length;
+            }
+            else if (type == 0x004E4942)
+                binary.assign(chunk, chunk + length);
+            offset += 8 + ((length + 3) & ~3u);
+        }
+    }
+
+    JsonParser parser;
+    if (!parser.Parse(json, json + jsonLength, document.Root) || document.Root.Type != Json::OBJECT)
+    {
+        fprintf(stderr, "%s: invalid JSON\n", path.c_str());
+        return false;
+    }
+
+    size_t slash = path.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+    const Json* buffers = document.Root.Find("buffers");
+    for (size_t i = 0; buffers && i < buffers->Items.size(); ++i)
+    {
+        const Json* uri = buffers->Items[i].Find("uri");
+        std::vector<uint8_t> data;
+        if (!uri)
+        {
+            if (!glb || i != 0)
+                return false;
+            data = binary;
+        }
+        else if (uri->String.compare(0, 5, "data:") == 0)
+        {
+            size_t comma = uri->String.find(";base64,");
+            if (comma == std::string::npos || !decodeBase64(uri->String.c_str() + comma + 8, uri->String.size() - comma - 8, data))
+                return false;
+        }
+        else
+        {
+            std::vector<char> external;
+            if (!readFile(directory + uri->String, external))
+            {
+                fprintf(stderr, "%s: cannot read buffer %s\n", path.c_str(), uri->String.c_str());
+                return false;
+            }
+            data.assign(external.begin(), external.end());
+        }
+        document.Buffers.push_back(std::move(data));
+    }
+    return true;
+}
+
+static int componentCount(const std::string& type)
+{
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    return 0;
+}
+
+static int componentSize(int componentType)
+{
+    switch (componentType)
+    {
+    case 5120: case 5121: return 1; // byte, unsigned byte
+    case 5122: case 5123: return 2; // short, unsigned short
+    case 5125: case 5126: return 4; // unsigned int, float
+    default: return 0;
+    }
+}
+
+// one component as float, normalized integers mapped to [0, 1] or [-1, 1]
+static double readComponent(const uint8_t* p, int componentType, bool normalized)
+{
+    switch (componentType)
+    {
+    case 5120: { int8_t v; memcpy(&v, p, 1); return normalized ? std::max(v / 127.0, -1.0) : v; }
+    case 5121: return normalized ? p[0] / 255.0 : p[0];
+    case 5122: { int16_t v; memcpy(&v, p, 2); return normalized ? std::max(v / 32767.0, -1.0) : v; }
+    case 5123: { uint16_t v; memcpy(&v, p, 2); return normalized ? v / 65535.0 : v; }
+    case 5125: { uint32_t v; memcpy(&v, p, 4); return v; }
+    case 5126: { float v; memcpy(&v, p, 4); return v; }
+    default: return 0.0;
+    }
+}
+
+// reads an accessor as doubles (exact for 32-bit indices too), components values per element
+static bool readAccessor(const GltfDocument& document, size_t index, std::vector<double>& out, int& components)
+{
+    const Json* accessors = document.Root.Find("accessors");
+    if (!accessors || index >= accessors->Items.size())
+        return false;
+    const Json& accessor = accessors->Items[index];
+    if (accessor.Find("sparse"))
+    {
+        fprintf(stderr, "sparse accessors are not supported\n");
+        return false;
+    }
+    const Json* type = accessor.Find("type");
+    components = type ? componentCount(type->String) : 0;
+    int componentType = (int)accessor.NumberOr("componentType", 0);
+    int size = componentSize(componentType);
+    size_t count = (size_t)accessor.NumberOr("count", 0);
+    const Json* normalizedValue = accessor.Find("normalized");
+    bool normalized = normalizedValue && normalizedValue->Boolean;
+    if (components == 0 || size == 0)
+        return false;
+
+    out.assign(count * components, 0.0);
+    const Json* viewIndex = accessor.Find("bufferView");
+    if (!viewIndex)
+        return true; // no data means all zeros
+    const Json* views = document.Root.Find("bufferViews");
+    if (!views || (size_t)viewIndex->Number >= views->Items.size())
+        return false;
+    const Json& view = views->Items[(size_t)viewIndex->Number];
+    size_t bufferIndex = (size_t)view.NumberOr("buffer", 0);
+    if (bufferIndex >= document.Buffers.size())
+        return false;
+    const std::vector<uint8_t>& buffer = document.Buffers[bufferIndex];
+    size_t viewOffset = (size_t)view.NumberOr("byteOffset", 0);
+    size_t viewLength = (size_t)view.NumberOr("byteLength", 0);
+    size_t offset = (size_t)accessor.NumberOr("byteOffset", 0);
+    size_t stride = (size_t)view.NumberOr("byteStride", 0);
+    if (stride == 0)
+        stride = (size_t)(size * components);
+    if (count > 0 && (viewOffset + viewLength > buffer.size() || offset + stride * (count - 1) + size * components > viewLength))
+        return false;
+
+    const uint8_t* base = buffer.data() + viewOffset + offset;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (int c = 0; c < components; ++c)
+            out[i * components + c] = readComponent(base + i * stride + c * size, componentType, normalized);
+    }
+    return true;
+}
+
+static glm::mat4 nodeMatrix(const Json& node)
+{
+    const Json* matrix = node.Find("matrix");
+    if (matrix && matrix->Items.size() == 16)
+    {
+        glm::mat4 m;
+        for (int i = 0; i < 16; ++i)
+            m[i / 4][i % 4] = (float)matrix->Items[i].Number;
+        return m;
+    }
+    Transform transform;
+    const Json* translation = node.Find("translation");
+    const Json* rotation = node.Find("rotation");
+    const Json* scale = node.Find("scale");
+    if (translation && translation->Items.size() == 3)
+        transform.Position = glm::vec3((float)translation->Items[0].Number, (float)translation->Items[1].Number, (float)translation->Items[2].Number);
+    if (rotation && rotation->Items.size() == 4) // glTF stores x, y, z, w
+        transform.Rotation = glm::quat((float)rotation->Items[3].Number, (float)rotation->Items[0].Number, (float)rotation->Items[1].Number, (float)rotation->Items[2].Number);
+    if (scale && scale->Items.size() == 3)
+        transform.Scale = glm::vec3((float)scale->Items[0].Number, (float)scale->Items[1].Number, (float)scale->Items[2].Number);
+    return transform.ToMatrix();
+}
+
+static bool appendGltfMesh(const GltfDocument& document, size_t meshIndex, const glm::mat4& world, MeshData& out, size_t& skipped)
+{
+    const Json* meshes = document.Root.Find("meshes");
+    if (!meshes || meshIndex >= meshes->Items.size())
+        return false;
+    glm::mat4 normalMatrix = glm::transpose(glm::inverse(world));
+    const Json* primitives = meshes->Items[meshIndex].Find("primitives");
+    for (size_t p = 0; primitives && p < primitives->Items.size(); ++p)
+    {
+        const Json& primitive = primitives->Items[p];
+        const Json* attributes = primitive.Find("attributes");
+        const Json* positionAccessor = attributes ? attributes->Find("POSITION") : nullptr;
+        if (primitive.NumberOr("mode", 4) != 4 || !positionAccessor)
+        {
+            skipped++;
+            continue;
+        }
+
+        std::vector<double> positions, normals, colors, indices;
+        int positionComponents = 0, normalComponents = 0, colorComponents = 0, indexComponents = 0;
+        if (!readAccessor(document, (size_t)positionAccessor->Number, positions, positionComponents) || positionComponents != 3)
+            return false;
+        const Json* normalAccessor = attributes->Find("NORMAL");
+        if (normalAccessor && !readAccessor(document, (size_t)normalAccessor->Number, normals, normalComponents))
+            return false;
+        const Json* colorAccessor = attributes->Find("COLOR_0");
+        if (colorAccessor && !readAccessor(document, (size_t)colorAccessor->Number, colors, colorComponents))
+            return false;
+        size_t vertexCount = positions.size() / 3;
+        const Json* indexAccessor = primitive.Find("indices");
+        if (indexAccessor && !readAccessor(document, (size_t)indexAccessor->Number, indices, indexComponents))
+            return false;
+
+        uint32_t base = (uint32_t)out.Positions.size();
+        std::vector<uint32_t> primitiveIndices;
+        if (indexAccessor)
+        {
+            for (double index : indices)
+            {
+                if (index >= (double)vertexCount)
+                    return false;
+                primitiveIndices.push_back((uint32_t)index);
+            }
+        }
+        else
+        {
+            for (uint32_t i = 0; i < (uint32_t)vertexCount; ++i)
+                primitiveIndices.push_back(i);
+        }
+        primitiveIndices.resize(primitiveIndices.size() / 3 * 3);
+
+        std::vector<glm::vec3> local(vertexCount), generated;
+        for (size_t i = 0; i < vertexCount; ++i)
+            local[i] = glm::vec3((float)positions[i * 3], (float)positions[i * 3 + 1], (float)positions[i * 3 + 2]);
+        if (normalComponents != 3)
+            computeNormals(local, primitiveIndices, generated);
+
+        for (size_t i = 0; i < vertexCount; ++i)
+        {
+            glm::vec3 normal = normalComponents == 3 ? glm::vec3((float)normals[i * 3], (float)normals[i * 3 + 1], (float)normals[i * 3 + 2]) : generated[i];
+            glm::vec4 color = DEFAULT_COLOR;
+            if (colorComponents >= 3)
+                color = glm::vec4((float)colors[i * colorComponents], (float)colors[i * colorComponents + 1], (float)colors[i * colorComponents + 2],
+                                  colorComponents == 4 ? (float)colors[i * colorComponents + 3] : 1.0f);
+            out.AddVertex(glm::vec3(world * glm::vec4(local[i], 1.0f)), glm::vec3(normalMatrix * glm::vec4(normal, 0.0f)), color);
+        }
+        for (uint32_t index : primitiveIndices)
+            out.Indices.push_back(base + index);
+    }
+    return true;
+}
+
+static bool appendGltfNode(const GltfDocument& document, size_t nodeIndex, const glm::mat4& parent, MeshData& out, size_t& skipped, int depth)
+{
+    const Json* nodes = document.Root.Find("nodes");
+    if (!nodes || nodeIndex >= nodes->Items.size() || depth > 64)
+        return false;
+    const Json& node = nodes->Items[nodeIndex];
+    glm::mat4 world = parent * nodeMatrix(node);
+    const Json* mesh = node.Find("mesh");
+    if (mesh && !appendGltfMesh(document, (size_t)mesh->Number, world, out, skipped))
+        return false;
+    const Json* children = node.Find("children");
+    for (size_t i = 0; children && i < children->Items.size(); ++i)
+    {
+        if (!appendGltfNode(document, (size_t)children->Items[i].Number, world, out, skipped, depth + 1))
+            return false;
+    }
+    return true;
+}
+
+static bool importGltf(const std::string& path, MeshData& out)
+{
+    GltfDocument document;
+    if (!loadGltf(path, document))
+        return false;
+
+    out = MeshData();
+    size_t skipped = 0;
+    const Json* scenes = document.Root.Find("scenes");
+    if (scenes && !scenes->Items.empty())
+    {
+        size_t sceneIndex = std::min((size_t)document.Root.NumberOr("scene", 0), scenes->Items.size() - 1);
+        const Json* roots = scenes->Items[sceneIndex].Find("nodes");
+        for (size_t i = 0; roots && i < roots->Items.size(); ++i)
+        {
+            if (!appendGltfNode(document, (size_t)roots->Items[i].Number, glm::mat4(1.0f), out, skipped, 0))
+                return false;
+        }
+    }
+    else
+    {
+        // no scene: every mesh as it is
+        for (size_t i = 0; i < document.Root.Count("meshes"); ++i)
+        {
+            if (!appendGltfMesh(document, i, glm::mat4(1.0f), out, skipped))
+                return false;
+        }
+    }
+    if (skipped > 0)
+        printf("skipped %zu non-triangle primitives\n", skipped);
+    return true;
+}
+
+// ---------------------------------------------------------------------------------------------
+// Optimization
+
+// average cache misses per triangle with a FIFO cache, as most hardware behaves
+static double averageCacheMissRatio(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = 16)
+{
+    if (indices.empty())
+        return 0.0;
+    std::vector<uint32_t> timestamp(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0;
+    for (uint32_t index : indices)
+    {
+        if (time - timestamp[index] > cacheSize)
+        {
+            timestamp[index] = time++;
+            misses++;
+        }
+    }
+    return (double)misses / (indices.size() / 3);
+}
+
+// merges vertices whose packed bytes are identical; returns the unique vertex count
+static uint32_t weldVertices(std::vector<uint8_t>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+{
+    uint32_t count = (uint32_t)(vertices.size() / stride);
+    size_t capacity = 1;
+    while (capacity < (size_t)count * 2)
+        capacity *= 2;
+    const uint32_t EMPTY = 0xFFFFFFFFu;
+    std::vector<uint32_t> table(capacity, EMPTY);
+    std::vector<uint32_t> remap(count);
+    uint32_t unique = 0;
+    for (uint32_t v = 0; v < count; ++v)
+    {
+        const uint8_t* bytes = vertices.data() + (size_t)v * stride;
+        uint64_t hash = 14695981039346656037ull;
+        for (uint32_t i = 0; i < stride; ++i)
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+        size_t slot = (size_t)hash & (capacity - 1);
+        while (table[slot] != EMPTY && memcmp(vertices.data() + (size_t)table[slot] * stride, bytes, stride) != 0)
+            slot = (slot + 1) & (capacity - 1);
+        if (table[slot] == EMPTY)
+        {
+            // compacted in place: the unique slot is never past the one being read
+            memmove(vertices.data() + (size_t)unique * stride, bytes, stride);
+            table[slot] = unique++;
+        }
+        remap[v] = table[slot];
+    }
+    vertices.resize((size_t)unique * stride);
+    for (uint32_t& index : indices)
+        index = remap[index];
+    return unique;
+}
+
+// triangles with a repeated index cover no pixels
+static size_t removeDegenerates(std::vector<uint32_t>& indices)
+{
+    size_t kept = 0;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+        if (a == b || b == c || a == c)
+            continue;
+        indices[kept++] = a;
+        indices[kept++] = b;
+        indices[kept++] = c;
+    }
+    size_t removed = (indices.size() - kept) / 3;
+    indices.resize(kept);
+    return removed;
+}
+
+// Forsyth's linear-speed vertex cache optimization: greedily emits the triangle whose vertices
+// score highest, where vertices score for being recently used and for having few triangles left
+static void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount, int cacheSize)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+    const int MAX_VALENCE = 32;
+
+    float cacheScores[64 + 3];
+    for (int i = 0; i < cacheSize + 3; ++i)
+        cacheScores[i] = i < 3 ? 0.75f : (i < cacheSize ? std::pow(1.0f - (float)(i - 3) / (float)(cacheSize - 3), 1.5f) : 0.0f);
+    float valenceScores[MAX_VALENCE + 1];
+    valenceScores[0] = 0.0f;
+    for (int i = 1; i <= MAX_VALENCE; ++i)
+        valenceScores[i] = 2.0f / std::sqrt((float)i);
+
+    // triangles of every vertex as ranges of one array; the first `remaining` of each are not emitted yet
+    std::vector<uint32_t> offsets(vertexCount + 1, 0), remaining(vertexCount, 0);
+    for (uint32_t index : indices)
+        remaining[index]++;
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    auto vertexScore = [&](uint32_t v) {
+        if (remaining[v] == 0)
+            return -1.0f;
+        int position = cachePosition[v];
+        return (position >= 0 ? cacheScores[position] : 0.0f) + valenceScores[std::min<uint32_t>(remaining[v], MAX_VALENCE)];
+    };
+    std::vector<float> scores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        scores[v] = vertexScore(v);
+    auto triangleScore = [&](size_t t) { return scores[indices[t * 3]] + scores[indices[t * 3 + 1]] + scores[indices[t * 3 + 2]]; };
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    size_t best = 0;
+    for (size_t t = 1; t < triangleCount; ++t)
+    {
+        if (triangleScore(t) > triangleScore(best))
+            best = t;
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    std::vector<uint32_t> cache, nextCache;
+    size_t cursor = 0;
+    const size_t NONE = (size_t)-1;
+    while (result.size() < indices.size())
+    {
+        if (best == NONE)
+        {
+            // nothing in the cache has triangles left: take the next unemitted one in input order
+            while (emitted[cursor])
+                ++cursor;
+            best = cursor;
+        }
+        emitted[best] = 1;
+        const uint32_t* triangle = &indices[best * 3];
+        nextCache.assign(triangle, triangle + 3);
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t v = triangle[k];
+            result.push_back(v);
+            // drop the triangle from the vertex's pending list
+            uint32_t* list = &adjacency[offsets[v]];
+            for (uint32_t i = 0; i < remaining[v]; ++i)
+            {
+                if (list[i] == best)
+                {
+                    std::swap(list[i], list[remaining[v] - 1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+        }
+        for (uint32_t v : cache)
+        {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                nextCache.push_back(v);
+        }
+
+        // rescore everything that moved in the cache, including what just fell out of it
+        for (size_t i = 0; i < nextCache.size(); ++i)
+        {
+            uint32_t v = nextCache[i];
+            cachePosition[v] = i < (size_t)cacheSize ? (int)i : -1;
+            scores[v] = vertexScore(v);
+        }
+        best = NONE;
+        float bestScore = -1.0f;
+        for (uint32_t v : nextCache)
+        {
+            for (uint32_t i = 0; i < remaining[v]; ++i)
+            {
+                uint32_t t = adjacency[offsets[v] + i];
+                float score = triangleScore(t);
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = t;
+                }
+            }
+        }
+        if (nextCache.size() > (size_t)cacheSize)
+            nextCache.resize(cacheSize);
+        cache.swap(nextCache);
+    }
+    indices.swap(result);
+}
+
+// Splits the cache-ordered triangles into clusters wherever the cache restarted anyway (all three
+// vertices missed), then draws the clusters facing away from the mesh center first. Those tend to
+// be the outer surfaces, which then occlude the rest. Vertex cache efficiency is kept because the
+// cluster boundaries were cold starts already.
+static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<glm::vec3>& positions, uint32_t cacheSize = 16)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    std::vector<size_t> clusterStarts;
+    std::vector<uint32_t> timestamp(positions.size(), 0);
+    uint32_t time = cacheSize + 1;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            uint32_t v = indices[t * 3 + k];
+            if (time - timestamp[v] > cacheSize)
+            {
+                timestamp[v] = time++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3)
+            clusterStarts.push_back(t);
+    }
+    clusterStarts.push_back(triangleCount);
+
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    std::vector<glm::vec3> centers(clusterStarts.size() - 1), normals(clusterStarts.size() - 1);
+    std::vector<float> areas(clusterStarts.size() - 1);
+    for (size_t c = 0; c + 1 < clusterStarts.size(); ++c)
+    {
+        glm::vec3 center(0.0f), normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            const glm::vec3& a = positions[indices[t * 3]];
+            const glm::vec3& b = positions[indices[t * 3 + 1]];
+            const glm::vec3& d = positions[indices[t * 3 + 2]];
+            glm::vec3 n = glm::cross(b - a, d - a);
+            float triangleArea = glm::length(n);
+            center += (a + b + d) * (triangleArea / 3.0f);
+            normal += n;
+            area += triangleArea;
+        }
+        centers[c] = center;
+        normals[c] = normal;
+        areas[c] = area;
+        meshCenter += center;
+        meshArea += area;
+    }
+    if (meshArea <= 0.0f)
+        return;
+    meshCenter /= meshArea;
+
+    std::vector<float> sortKeys(centers.size());
+    std::vector<size_t> order(centers.size());
+    for (size_t c = 0; c < centers.size(); ++c)
+    {
+        glm::vec3 center = areas[c] > 0.0f ? centers[c] / areas[c] : meshCenter;
+        float normalLength = glm::length(normals[c]);
+        sortKeys[c] = normalLength > 0.0f ? glm::dot(center - meshCenter, normals[c] / normalLength) : 0.0f;
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (size_t c : order)
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    indices.swap(result);
+}
+
+// renumbers vertices in order of first use so vertex fetch walks memory forwards
+static void optimizeVertexFetch(std::vector<uint8_t>& vertices, uint32_t stride, std::vector<uint32_t>& indices)
+{
+    uint32_t count = (uint32_t)(vertices.size() / stride);
+    const uint32_t UNUSED = 0xFFFFFFFFu;
+    std::vector<uint32_t> remap(count, UNUSED);
+    std::vector<uint8_t> sorted;
+    sorted.reserve(vertices.size());
+    uint32_t next = 0;
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == UNUSED)
+        {
+            remap[index] = next++;
+            sorted.insert(sorted.end(), vertices.begin() + (size_t)index * stride, vertices.begin() + (size_t)(index + 1) * stride);
+        }
+        index = remap[index];
+    }
+    // vertices no triangle uses are dropped
+    vertices.swap(sorted);
+}
+
+static bool writeMeshFile(const std::string& path, MeshFileHeader header, const std::vector<uint8_t>& vertices, const std::vector<uint32_t>& indices)
+{
+    std::vector<uint16_t> shortIndices;
+    const void* indexData = indices.data();
+    if (header.IndexSize == 2)
+    {
+        shortIndices.assign(indices.begin(), indices.end());
+        indexData = shortIndices.data();
+    }
+
+    auto align = [](uint64_t offset) { return (offset + MESH_FILE_ALIGNMENT - 1) / MESH_FILE_ALIGNMENT * MESH_FILE_ALIGNMENT; };
+    header.VertexOffset = align(sizeof(MeshFileHeader));
+    header.VertexBytes = vertices.size();
+    header.IndexOffset = align(header.VertexOffset + header.VertexBytes);
+    header.IndexBytes = (uint64_t)indices.size() * header.IndexSize;
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file)
+        return false;
+    static const uint8_t padding[MESH_FILE_ALIGNMENT] = {};
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = ok && fwrite(padding, 1, header.VertexOffset - sizeof(header), file) == header.VertexOffset - sizeof(header);
+    ok = ok && fwrite(vertices.data(), 1, vertices.size(), file) == vertices.size();
+    ok = ok && fwrite(padding, 1, header.IndexOffset - header.VertexOffset - header.VertexBytes, file) == header.IndexOffset - header.VertexOffset - header.VertexBytes;
+    ok = ok && fwrite(indexData, 1, header.IndexBytes, file) == header.IndexBytes;
+    ok = fclose(file) == 0 && ok;
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    std::string input, output;
+    bool optimize = true;
+    int cacheSize = 32;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--no-optimize") optimize = false;
+        else if (arg == "--cache-size" && i + 1 < argc) cacheSize = std::min(64, std::max(4, atoi(argv[++i])));
+        else if (input.empty()) input = arg;
+        else output = arg;
+    }
+    if (input.empty() || output.empty())
+    {
+        fprintf(stderr, "usage: ge_cook input.(obj|gltf|glb) output.gemesh [--no-optimize] [--cache-size N]\n");
+        return 1;
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    MeshData data;
+    std::string extension = lowerExtension(input);
+    bool imported = false;
+    if (extension == ".obj")
+        imported = importObj(input, data);
+    else if (extension == ".gltf" || extension == ".glb")
+        imported = importGltf(input, data);
+    else
+        fprintf(stderr, "%s: unknown format, expected .obj, .gltf or .glb\n", input.c_str());
+    if (!imported || data.Indices.empty())
+    {
+        fprintf(stderr, "%s: nothing imported\n", input.c_str());
+        return 1;
+    }
+    printf("imported %zu vertices, %zu triangles: %.1f ms\n", data.Positions.size(), data.Indices.size() / 3, elapsedMs(start));
+
+    // quantize: positions become [0, 1] inside a cube around the bounds, one scale for every axis
+    start = std::chrono::high_resolution_clock::now();
+    glm::vec3 boundsMin = data.Positions[0], boundsMax = data.Positions[0];
+    for (const glm::vec3& position : data.Positions)
+    {
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+    glm::vec3 extent = boundsMax - boundsMin;
+    float scale = std::max(extent.x, std::max(extent.y, extent.z));
+    if (scale <= 0.0f)
+        scale = 1.0f;
+    std::vector<glm::vec3> modelPositions;
+    modelPositions.swap(data.Positions);
+    data.Positions.reserve(modelPositions.size());
+    for (const glm::vec3& position : modelPositions)
+        data.Positions.push_back((position - boundsMin) / scale);
+    for (glm::vec3& normal : data.Normals)
+    {
+        float length = glm::length(normal);
+        normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+    VertexLayout layout = VertexLayout::Quantized();
+    std::vector<uint8_t> vertices = data.Pack(layout);
+    std::vector<uint32_t> indices;
+    indices.swap(data.Indices);
+
+    // vertices that quantized to the same bytes are one vertex
+    uint32_t vertexCount = weldVertices(vertices, (uint32_t)layout.Stride, indices);
+    size_t degenerate = removeDegenerates(indices);
+    printf("welded to %u vertices, %zu degenerate triangles removed: %.1f ms\n", vertexCount, degenerate, elapsedMs(start));
+
+    double missesBefore = averageCacheMissRatio(indices, vertexCount);
+    if (optimize)
+    {
+        start = std::chrono::high_resolution_clock::now();
+        optimizeVertexCache(indices, vertexCount, cacheSize);
+
+        // overdraw sorting wants positions per welded vertex; the quantized ones are fine for that
+        std::vector<glm::vec3> positions(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v)
+        {
+            uint16_t q[3];
+            memcpy(q, vertices.data() + (size_t)v * layout.Stride, sizeof(q));
+            positions[v] = glm::vec3(q[0], q[1], q[2]);
+        }
+        optimizeOverdraw(indices, positions);
+        optimizeVertexFetch(vertices, (uint32_t)layout.Stride, indices);
+        vertexCount = (uint32_t)(vertices.size() / layout.Stride);
+        printf("optimized: ACMR %.3f -> %.3f (FIFO 16): %.1f ms\n", missesBefore, averageCacheMissRatio(indices, vertexCount), elapsedMs(start));
+    }
+    else
+        printf("not optimized: ACMR %.3f (FIFO 16)\n", missesBefore);
+
+    MeshFileHeader header = {};
+    memcpy(header.Magic, MESH_FILE_MAGIC, sizeof(header.Magic));
+    header.Version = MESH_FILE_VERSION;
+    header.VertexCount = vertexCount;
+    header.IndexCount = (uint32_t)indices.size();
+    header.VertexStride = (uint32_t)layout.Stride;
+    header.IndexSize = vertexCount <= 65536 ? 2 : 4;
+    header.AttributeCount = (uint32_t)layout.Attributes.size();
+    for (uint32_t i = 0; i < header.AttributeCount; ++i)
+    {
+        const VertexAttribute& attribute = layout.Attributes[i];
+        header.Attributes[i] = { (uint32_t)attribute.Semantic, (uint32_t)attribute.Components, (uint32_t)attribute.Type,
+                                 (uint32_t)attribute.Normalized, attribute.Offset };
+    }
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.PositionOffset[axis] = boundsMin[axis];
+        header.BoundsMin[axis] = boundsMin[axis];
+        header.BoundsMax[axis] = boundsMax[axis];
+    }
+    header.PositionScale = scale;
+
+    if (!writeMeshFile(output, header, vertices, indices))
+    {
+        fprintf(stderr, "%s: cannot write\n", output.c_str());
+        return 1;
+    }
+    printf("wrote %s: %u vertices x %u bytes, %zu triangles, %u-bit indices\n", output.c_str(), vertexCount, header.VertexStride,
+           indices.size() / 3, header.IndexSize * 8);
+    return 0;
+}